@@ -0,0 +1,143 @@
+// Waveform envelope benchmark: envelope_kernel::write_vertices (what
+// audio::project_visible_adapt_wave_into runs) against the per-sample loop it replaced,
+// for 1 .. 60 s windows at 22050 and 48000 Hz. Output must be bit identical.
+//
+//   envelope_bench [--width PX] [--reps N] [--isa scalar|sse2|avx2|neon]
+//
+// Defaults: 1200 px, median of 50 runs, the ISA picked at runtime.
+
+#include "envelope_kernel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+using raiden::db_kernel;
+using raiden::envelope_kernel;
+
+namespace {
+
+struct Options {
+    int width = 1200;
+    int reps = 50;
+    const char* isa = nullptr;
+};
+
+// the loop project_visible_adapt_wave ran before envelope_kernel, vector and all
+std::vector<float> oldLoop(const std::vector<float>& wave, int pixel_w, float gain) {
+    std::vector<float> out;
+    const int n = int(wave.size());
+    if (n <= pixel_w) {
+        out.reserve(size_t(n) * 2);
+        for (int i = 0; i < n; ++i) {
+            const float t = (n > 1) ? (float)i / (float)(n - 1) : 0.f;
+            out.push_back(t * 2.f - 1.f);
+            out.push_back(std::max(-1.f, std::min(1.f, wave[size_t(i)] * gain)));
+        }
+        return out;
+    }
+    const int spp = std::max(1, n / pixel_w);
+    out.reserve(size_t(pixel_w) * 4);
+    for (int px = 0; px < pixel_w; ++px) {
+        const int s0 = px * spp;
+        const int s1 = (px == pixel_w - 1) ? n : std::min(n, s0 + spp);
+        if (s0 >= n) break;
+        float vmin = 1e9f, vmax = -1e9f;
+        for (int j = s0; j < s1; ++j) {
+            const float v = wave[size_t(j)] * gain;
+            if (v < vmin) vmin = v;
+            if (v > vmax) vmax = v;
+        }
+        vmin = std::max(-1.f, std::min(1.f, vmin));
+        vmax = std::max(-1.f, std::min(1.f, vmax));
+        const float x_ndc = (pixel_w == 1) ? 0.f : ((float)px / (float)(pixel_w - 1) * 2.f - 1.f);
+        out.push_back(x_ndc); out.push_back(vmin);
+        out.push_back(x_ndc); out.push_back(vmax);
+    }
+    return out;
+}
+
+// speech-ish: a few partials under noise, the odd NaN a broken decode leaves behind
+std::vector<float> makeWave(size_t n, int sr) {
+    std::mt19937 rng(static_cast<uint32_t>(n));
+    std::normal_distribution<float> noise(0.0f, 0.05f);
+    std::vector<float> out(n);
+    for (size_t i = 0; i < n; ++i) {
+        const float t = float(i) / float(sr);
+        out[i] = 0.4f * std::sin(2.0f * 3.14159265f * 220.0f * t) + 0.2f * std::sin(2.0f * 3.14159265f * 1330.0f * t)
+                 + noise(rng);
+    }
+    for (size_t i = 7; i < n; i += 100003) out[i] = std::numeric_limits<float>::quiet_NaN();
+    return out;
+}
+
+template <typename F>
+double medianMs(int reps, F fn) {
+    std::vector<double> ms(size_t(std::max(1, reps)));
+    for (double& m : ms) {
+        const auto t0 = std::chrono::steady_clock::now();
+        fn();
+        m = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    }
+    std::nth_element(ms.begin(), ms.begin() + long(ms.size() / 2), ms.end());
+    return ms[ms.size() / 2];
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--width") && hasValue) {
+            opt.width = std::max(1, std::atoi(argv[++i]));
+        } else if (!std::strcmp(argv[i], "--reps") && hasValue) {
+            opt.reps = std::max(1, std::atoi(argv[++i]));
+        } else if (!std::strcmp(argv[i], "--isa") && hasValue) {
+            opt.isa = argv[++i];
+        } else {
+            std::fprintf(stderr, "usage: envelope_bench [--width PX] [--reps N] [--isa scalar|sse2|avx2|neon]\n");
+            return 2;
+        }
+    }
+    if (opt.isa) {
+        // before the first envelope call, which fixes its kernel
+        bool ok = false;
+        for (db_kernel::Isa isa : db_kernel::available_isas()) {
+            if (!std::strcmp(opt.isa, db_kernel::isa_name(isa))) ok = db_kernel::set_isa(isa);
+        }
+        if (!ok) {
+            std::fprintf(stderr, "isa %s not available here\n", opt.isa);
+            return 2;
+        }
+    }
+
+    std::printf("isa %s, %d px, median of %d\n", db_kernel::isa_name(envelope_kernel::active_isa()), opt.width, opt.reps);
+    std::printf("%8s %5s %12s %12s %8s\n", "sr", "sec", "old ms", "kernel ms", "speedup");
+    const float gain = 1.0f / 0.65f;
+    int failed = 0;
+    for (int sr : { 22050, 48000 }) {
+        for (int sec : { 1, 5, 10, 30, 60 }) {
+            const std::vector<float> wave = makeWave(size_t(sr) * size_t(sec), sr);
+            std::vector<float> out(envelope_kernel::vertex_floats(wave.size(), opt.width));
+            std::vector<float> ref;
+            volatile int sink = 0;
+
+            const double old_ms = medianMs(opt.reps, [&] { ref = oldLoop(wave, opt.width, gain); sink = sink + int(ref.size()); });
+            const double new_ms = medianMs(opt.reps, [&] {
+                sink = sink + envelope_kernel::write_vertices(wave.data(), wave.size(), opt.width, gain, out.data());
+            });
+            const bool same = ref.size() == out.size() && std::memcmp(ref.data(), out.data(), out.size() * sizeof(float)) == 0;
+            std::printf("%8d %5d %12.3f %12.3f %7.1fx%s\n", sr, sec, old_ms, new_ms, old_ms / std::max(new_ms, 1e-9),
+                        same ? "" : "  MISMATCH");
+            if (!same) ++failed;
+        }
+    }
+    return failed ? 1 : 0;
+}
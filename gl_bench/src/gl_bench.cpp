@@ -0,0 +1,348 @@
+// Headless render benchmark for GlSpecViewFrame and GlFrameMedia.
+//
+// Uses Qt's offscreen platform unless QT_QPA_PLATFORM says otherwise, so no display
+// is needed; with LIBGL_ALWAYS_SOFTWARE=1 Mesa (llvmpipe) renders on a machine
+// without a GPU. Every scenario drives the widgets through their normal API with
+// scripted input and forces each paintGL with grabFramebuffer() (the paint goes to
+// the widget's FBO); the times are the widgets' own GlProfiler regions, so the
+// grab's read back is not in them.
+//
+//   gl_bench [--frames N] [--warmup N] [--size WxH] [--sync] [--csv DIR] [scenario ...]
+//
+//   spec         full spectrogram texture (2048 x 128, F16) replaced every frame
+//   spec_ring    ring spectrogram, 8 new columns per frame, scrolling view
+//   timeline     spec_ring plus the GL timeline overlay (ticks + ~40 label spans) scrolling with it
+//   wave         streamed waveform + rms band, one vertex per pixel column
+//   wave_gpu     waveform from the peak pyramid of 10 minutes at 48 kHz, uniforms only
+//   video_1080p  RGBA frames through pushFrame, video_4k the same at 3840 x 2160
+//
+// --sync uploads video with glTexSubImage2D instead of the PBO ring. Percentiles are
+// over the last 240 frames (the profiler window).
+
+#include "gl_spec_frame.h"
+#include "frame_media_gl.h"
+#include "peak_index.h"
+#include "tools.h"
+
+#include <QApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace {
+
+struct Options {
+    int frames = 240;
+    int warmup = 30;
+    int width = 1280;
+    int height = 720;
+    bool syncUpload = false;
+    QString csvDir;
+    QStringList scenarios;
+};
+
+const float kPi = 3.14159265358979f;
+
+bool parseArgs(const QStringList& args, Options& opt) {
+    for (int i = 1; i < args.size(); ++i) {
+        const QString& a = args[i];
+        const bool hasValue = i + 1 < args.size();
+        if (a == "--frames" && hasValue) {
+            opt.frames = std::max(1, args[++i].toInt());
+        } else if (a == "--warmup" && hasValue) {
+            opt.warmup = std::max(0, args[++i].toInt());
+        } else if (a == "--size" && hasValue) {
+            const QStringList wh = args[++i].split('x');
+            if (wh.size() != 2) return false;
+            opt.width = std::max(16, wh[0].toInt());
+            opt.height = std::max(16, wh[1].toInt());
+        } else if (a == "--sync") {
+            opt.syncUpload = true;
+        } else if (a == "--csv" && hasValue) {
+            opt.csvDir = args[++i];
+        } else if (a.startsWith("--")) {
+            return false;
+        } else {
+            opt.scenarios << a;
+        }
+    }
+    if (opt.scenarios.isEmpty()) {
+        opt.scenarios << "spec" << "spec_ring" << "timeline" << "wave" << "wave_gpu" << "video_1080p" << "video_4k";
+    }
+    return true;
+}
+
+// shown (offscreen) and painted once, so initializeGL ran and the context can be made current
+void openWidget(QOpenGLWidget& w, const Options& opt) {
+    static bool printed = false;
+    w.resize(opt.width, opt.height);
+    w.show();
+    QApplication::processEvents();
+    w.grabFramebuffer();
+    if (printed || !w.context()) return;
+    w.makeCurrent();
+    QOpenGLFunctions* f = w.context()->functions();
+    std::printf("GL %s | %s\n", reinterpret_cast<const char*>(f->glGetString(GL_VERSION)),
+                reinterpret_cast<const char*>(f->glGetString(GL_RENDERER)));
+    w.doneCurrent();
+    printed = true;
+}
+
+void report(const QString& name, const Options& opt, const std::vector<GlProfiler::RegionStats>& stats,
+            double wall_ms, const char* uploadRegion, double uploadBytes) {
+    std::printf("\n== %s  (%dx%d, %d frames, %.2f ms/frame wall incl. read back)\n",
+                name.toUtf8().constData(), opt.width, opt.height, opt.frames, wall_ms);
+    std::printf("  %-10s %8s %8s %8s | %8s %8s %8s  (ms)\n", "region", "cpu p50", "p95", "p99", "gpu p50", "p95", "p99");
+    const GlProfiler::RegionStats* up = nullptr;
+    for (const GlProfiler::RegionStats& s : stats) {
+        if (s.gpu_samples > 0) {
+            std::printf("  %-10s %8.3f %8.3f %8.3f | %8.3f %8.3f %8.3f\n", s.name.c_str(),
+                        s.cpu_p50, s.cpu_p95, s.cpu_p99, s.gpu_p50, s.gpu_p95, s.gpu_p99);
+        } else {
+            std::printf("  %-10s %8.3f %8.3f %8.3f |        -\n", s.name.c_str(), s.cpu_p50, s.cpu_p95, s.cpu_p99);
+        }
+        if (uploadRegion && s.name == uploadRegion) up = &s;
+    }
+    if (up && uploadBytes > 0.0) {
+        // bytes handed to GL per frame over the time the call took
+        std::printf("  upload %.1f KiB/frame: cpu %.1f MB/s", uploadBytes / 1024.0,
+                    up->cpu_p50 > 0.0 ? uploadBytes / (up->cpu_p50 * 1e3) : 0.0);
+        if (up->gpu_samples > 0 && up->gpu_p50 > 0.0) {
+            std::printf(", gpu %.1f MB/s", uploadBytes / (up->gpu_p50 * 1e3));
+        }
+        std::printf(" (p50)\n");
+    }
+}
+
+// warm up, then profile opt.frames paints; step(i) feeds the input of frame i
+template<typename W>
+void run(W& w, const QString& name, const Options& opt, const std::function<void(int)>& step,
+         const char* uploadRegion, double uploadBytes) {
+    w.setProfiling(false);
+    for (int i = 0; i < opt.warmup; ++i) {
+        step(i);
+        w.grabFramebuffer();
+    }
+    w.setProfiling(true);
+    w.grabFramebuffer();   // creates the profiler
+
+    QElapsedTimer t;
+    t.start();
+    for (int i = 0; i < opt.frames; ++i) {
+        step(opt.warmup + i);
+        w.grabFramebuffer();
+    }
+    const double wall_ms = double(t.nsecsElapsed()) * 1e-6 / double(opt.frames);
+
+    report(name, opt, w.profileStats(), wall_ms, uploadRegion, uploadBytes);
+    const GlStateCache::FrameStats gl = w.glCallStats();
+    std::printf("  gl calls %llu / frame, %llu redundant skipped\n", (unsigned long long)gl.gl_calls,
+                (unsigned long long)gl.skipped);
+    if (!opt.csvDir.isEmpty()) {
+        const QString path = QDir(opt.csvDir).filePath(name + ".csv");
+        if (!w.dumpProfile(path)) std::printf("  could not write %s\n", path.toUtf8().constData());
+    }
+    w.setProfiling(false);
+}
+
+SpectrogramQ syntheticSpec(int width, int height, int frame) {
+    // moving chirp over a noise floor, as dB halves like the F16 analysis output
+    SpectrogramQ q;
+    q.width = width;
+    q.height = height;
+    q.format = SpecSampleFormat::F16;
+    q.data.resize(size_t(width) * size_t(height) * 2);
+    uint16_t* px = reinterpret_cast<uint16_t*>(q.data.data());
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const int ridge = (x + frame * 3) % height;
+            const float db = -70.0f + 10.0f * std::sin(0.05f * float(x * 7 + y * 13))
+                             + (std::abs(y - ridge) < 3 ? 60.0f : 0.0f);
+            px[size_t(y) * size_t(width) + size_t(x)] = raiden::tools::floatToHalf(db);
+        }
+    }
+    return q;
+}
+
+void benchSpec(const Options& opt) {
+    GlSpecViewFrame w;
+    openWidget(w, opt);
+
+    const int cols = 2048, bins = 128;
+    std::vector<SpectrogramQ> specs;
+    for (int i = 0; i < 4; ++i) specs.push_back(syntheticSpec(cols, bins, i * 40));
+
+    run(w, "spec", opt, [&](int i) {
+        w.setViewSpec(0.0f, 10.0f, specs[size_t(i) % specs.size()]);
+    }, "spec up", double(cols) * bins * 2);
+}
+
+void benchSpecRing(const Options& opt) {
+    GlSpecViewFrame w;
+    openWidget(w, opt);
+
+    const int ring = 1024, bins = 128, step = 8;
+    const SpectrogramQ cols = syntheticSpec(step * 64, bins, 0);
+    w.resetSpecRing(ring, bins, SpecSampleFormat::F16, 1.0f, 0.0f);
+
+    run(w, "spec_ring", opt, [&](int i) {
+        // the next `step` columns out of a pre-built strip
+        SpectrogramQ part;
+        part.width = step;
+        part.height = bins;
+        part.format = cols.format;
+        part.data.resize(size_t(step) * bins * 2);
+        const int x0 = (i * step) % cols.width;
+        for (int y = 0; y < bins; ++y) {
+            std::memcpy(&part.data[size_t(y) * step * 2], &cols.data[(size_t(y) * cols.width + x0) * 2], size_t(step) * 2);
+        }
+        const int64_t first = int64_t(i) * step;
+        w.writeSpecRing(first, part);
+        w.setSpecRingView(double(first + step) - ring * 0.75, ring * 0.75);
+    }, "spec up", double(step) * bins * 2);
+}
+
+void benchTimeline(const Options& opt) {
+    GlSpecViewFrame w;
+    openWidget(w, opt);
+    w.setTimelineOverlay(true);
+
+    const int bins = 128;
+    w.resetSpecRing(1024, bins, SpecSampleFormat::F16, 1.0f, 0.0f);
+    w.writeSpecRing(0, syntheticSpec(1024, bins, 0));
+
+    // a label every 0.25 s, the view is 10 s wide and moves 1/60 s per frame
+    const double view = 10.0;
+    std::vector<LabelSpan> labels;
+    for (int i = 0; i < 4000; ++i) {
+        labels.push_back({ i * 0.25, i * 0.25 + 0.2, i % 3 ? QString("Silent") : QString("Snoring") });
+    }
+    run(w, "timeline", opt, [&](int i) {
+        const double start = double(i) / 60.0;
+        // what the label worker would hand over for this view
+        std::vector<LabelSpan> shown;
+        for (const LabelSpan& l : labels) {
+            if (l.end > start && l.start < start + view) shown.push_back(l);
+        }
+        w.setSpecRingView(double(i), 1024 * 0.75);
+        w.setTimelineView(start, view);
+        w.setTimelineLabels(shown);
+    }, nullptr, 0.0);
+}
+
+void benchWave(const Options& opt) {
+    GlSpecViewFrame w;
+    openWidget(w, opt);
+
+    const int n = w.viewportWidthPx();
+    std::vector<float> wave(size_t(n) * 2), rms(size_t(n) * 4);
+
+    run(w, "wave", opt, [&](int i) {
+        for (int x = 0; x < n; ++x) {
+            const float fx = -1.0f + 2.0f * float(x) / float(std::max(1, n - 1));
+            const float y = 0.8f * std::sin(0.03f * float(x + i * 5)) * std::sin(0.002f * float(x));
+            const float r = std::fabs(y) * 0.7f;
+            wave[size_t(x) * 2] = fx;
+            wave[size_t(x) * 2 + 1] = y;
+            rms[size_t(x) * 4] = fx;
+            rms[size_t(x) * 4 + 1] = r;
+            rms[size_t(x) * 4 + 2] = fx;
+            rms[size_t(x) * 4 + 3] = -r;
+        }
+        w.setViewWav(0.0f, 10.0f, n, wave, rms);
+    }, "wave up", double(wave.size() + rms.size()) * sizeof(float));
+}
+
+void benchWaveGpu(const Options& opt) {
+    GlSpecViewFrame w;
+    openWidget(w, opt);
+
+    const int sr = 48000;
+    raiden::PeakIndex peaks(sr);
+    std::vector<float> block(size_t(sr));
+    for (int s = 0; s < 600; ++s) {
+        for (int k = 0; k < sr; ++k) {
+            const float t = float(s) + float(k) / float(sr);
+            block[size_t(k)] = 0.6f * std::sin(2.0f * kPi * 220.0f * t) * (0.5f + 0.5f * std::sin(0.7f * t));
+        }
+        peaks.push(block.data(), block.size());
+    }
+    peaks.finish();
+    if (!w.setWavePeaks(peaks)) {
+        std::printf("\n== wave_gpu: peak pyramid did not fit, skipped\n");
+        return;
+    }
+
+    const int64_t span = int64_t(sr) * 10;
+    run(w, "wave_gpu", opt, [&](int i) {
+        // scrolls a 10 s window by ~1/60 s per frame
+        w.setViewWavGpu(int64_t(i) * (sr / 60) % (peaks.totalSamples() - span), span, 1.0f);
+    }, nullptr, 0.0);
+}
+
+void benchVideo(const Options& opt, const QString& name, int fw, int fh) {
+    GlFrameMedia w;
+    w.setStreamingUpload(!opt.syncUpload);
+    w.setFramePacing(false);   // every pushed frame is due on the next paint
+    openWidget(w, opt);
+
+    // two pictures, so every upload really changes the texture
+    std::vector<std::shared_ptr<const std::vector<uint8_t>>> pics;
+    for (int p = 0; p < 2; ++p) {
+        std::shared_ptr<std::vector<uint8_t>> pix = std::make_shared<std::vector<uint8_t>>(size_t(fw) * fh * 4);
+        uint8_t* d = pix->data();
+        for (int y = 0; y < fh; ++y) {
+            for (int x = 0; x < fw; ++x, d += 4) {
+                d[0] = uint8_t(x + p * 64);
+                d[1] = uint8_t(y);
+                d[2] = uint8_t((x ^ y) + p * 128);
+                d[3] = 255;
+            }
+        }
+        pics.push_back(pix);
+    }
+
+    run(w, name + (opt.syncUpload ? "_sync" : ""), opt, [&](int i) {
+        const double t = double(i) / 60.0;
+        w.pushFrame(fw, fh, pics[size_t(i) % pics.size()], t, t);
+    }, "upload", double(fw) * fh * 4);
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    // headless unless asked otherwise
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication a(argc, argv);
+    Options opt;
+    if (!parseArgs(a.arguments(), opt)) {
+        std::fprintf(stderr, "usage: gl_bench [--frames N] [--warmup N] [--size WxH] [--sync] [--csv DIR] "
+                             "[spec|spec_ring|timeline|wave|wave_gpu|video_1080p|video_4k ...]\n");
+        return 2;
+    }
+    if (!opt.csvDir.isEmpty()) QDir().mkpath(opt.csvDir);
+
+    for (const QString& s : opt.scenarios) {
+        if (s == "spec") benchSpec(opt);
+        else if (s == "spec_ring") benchSpecRing(opt);
+        else if (s == "timeline") benchTimeline(opt);
+        else if (s == "wave") benchWave(opt);
+        else if (s == "wave_gpu") benchWaveGpu(opt);
+        else if (s == "video_1080p") benchVideo(opt, s, 1920, 1080);
+        else if (s == "video_4k") benchVideo(opt, s, 3840, 2160);
+        else std::fprintf(stderr, "unknown scenario %s\n", s.toUtf8().constData());
+    }
+    return 0;
+}
@@ -0,0 +1,185 @@
+// Label store benchmark: synthetic DL output streamed into a LabelStore the way
+// GlSpecViewport appends it, then load, index, query and CSV / JSON round trips.
+//
+//   label_bench [--labels N] [--block N] [--sync] [--dir DIR]
+//
+// Defaults: 1M labels in blocks of 256, far more blocks than real DL windows produce, so
+// the block walk on open is the pessimistic case; no fdatasync per block unless --sync.
+
+#include "label_index.h"
+#include "label_store.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Options {
+    size_t labels = 1000000;
+    size_t block = 256;
+    bool sync = false;
+    std::string dir = "/tmp";
+};
+
+double msSince(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+long fileBytes(const std::string& path) {
+    FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) return -1;
+    std::fseek(f, 0, SEEK_END);
+    const long n = std::ftell(f);
+    std::fclose(f);
+    return n;
+}
+
+// back to back spans of 0.1 .. 1.5 s with a few tags, like the DL service returns
+std::vector<audio_label> makeLabels(size_t n) {
+    static const char* kTags[] = { "Silent", "Snoring", "Speech", "Cough", "Breathing, heavy", "Noise \"hum\"" };
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> len(0.1, 1.5);
+    std::uniform_int_distribution<int> tag(0, 5);
+    std::vector<audio_label> out;
+    out.reserve(n);
+    double t = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        const double d = len(rng);
+        out.push_back({ t, t + d, kTags[tag(rng)] });
+        t += d * 0.9;
+    }
+    return out;
+}
+
+bool same(const std::vector<audio_label>& a, const std::vector<audio_label>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].start != b[i].start || a[i].end != b[i].end || a[i].label != b[i].label) return false;
+    }
+    return true;
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--labels") && hasValue) {
+            opt.labels = size_t(std::atoll(argv[++i]));
+        } else if (!std::strcmp(argv[i], "--block") && hasValue) {
+            opt.block = std::max<size_t>(1, size_t(std::atoll(argv[++i])));
+        } else if (!std::strcmp(argv[i], "--sync")) {
+            opt.sync = true;
+        } else if (!std::strcmp(argv[i], "--dir") && hasValue) {
+            opt.dir = argv[++i];
+        } else {
+            std::fprintf(stderr, "usage: label_bench [--labels N] [--block N] [--sync] [--dir DIR]\n");
+            return 2;
+        }
+    }
+
+    const std::string base = opt.dir + "/label_bench_" + std::to_string(getpid());
+    const std::string store_path = base + ".vlbl";
+    const std::string csv_path = base + ".csv";
+    const std::string json_path = base + ".json";
+    const std::vector<audio_label> labels = makeLabels(opt.labels);
+    const double span = labels.empty() ? 0.0 : labels.back().end;
+    int failed = 0;
+
+    std::string error;
+    {
+        std::unique_ptr<LabelStore> store = LabelStore::Open(store_path, true, &error);
+        if (!store) {
+            std::fprintf(stderr, "open %s: %s\n", store_path.c_str(), error.c_str());
+            return 1;
+        }
+        auto t0 = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < labels.size(); i += opt.block) {
+            const size_t n = std::min(opt.block, labels.size() - i);
+            std::vector<audio_label> chunk(labels.begin() + long(i), labels.begin() + long(i + n));
+            if (!store->Append(chunk, chunk.back().end, opt.sync)) {
+                std::fprintf(stderr, "append failed at %zu\n", i);
+                return 1;
+            }
+        }
+        const double ms = msSince(t0);
+        std::printf("append     %8.1f ms  %zu labels, %zu blocks%s, %.1f MB (%.1f B/label)\n",
+                    ms, store->Size(), store->Blocks().size(), opt.sync ? " fdatasync" : "",
+                    store->FileBytes() / 1e6, double(store->FileBytes()) / double(std::max<size_t>(1, labels.size())));
+    }
+
+    std::vector<audio_label> loaded;
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        std::unique_ptr<LabelStore> store = LabelStore::Open(store_path, false, &error);
+        const double open_ms = msSince(t0);
+        if (!store) {
+            std::fprintf(stderr, "reopen: %s\n", error.c_str());
+            return 1;
+        }
+        t0 = std::chrono::steady_clock::now();
+        loaded = store->ReadAll();
+        const double read_ms = msSince(t0);
+        std::printf("open+map   %8.3f ms  covered %.1f s of %.1f s\n", open_ms, store->CoveredSec(), span);
+        std::printf("read all   %8.1f ms\n", read_ms);
+        if (!same(loaded, labels)) {
+            std::printf("  MISMATCH after reopen\n");
+            ++failed;
+        }
+
+        // 5 s windows straight off the mapping (block skip + scan)
+        std::vector<audio_label> out;
+        const int queries = 1000;
+        size_t hits = 0;
+        t0 = std::chrono::steady_clock::now();
+        for (int q = 0; q < queries; ++q) {
+            out.clear();
+            store->Query(span * q / queries, span * q / queries + 5.0, out);
+            hits += out.size();
+        }
+        std::printf("store qry  %8.3f us  per 5 s window (%zu hits / %d)\n", msSince(t0) * 1000.0 / queries, hits, queries);
+    }
+
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        LabelIndex::Ptr idx = LabelIndex::Build(loaded);
+        std::printf("index      %8.1f ms\n", msSince(t0));
+        std::vector<audio_label> out;
+        const int queries = 1000;
+        t0 = std::chrono::steady_clock::now();
+        for (int q = 0; q < queries; ++q) {
+            out.clear();
+            idx->Query(span * q / queries, span * q / queries + 5.0, out);
+        }
+        std::printf("index qry  %8.3f us  per 5 s window\n", msSince(t0) * 1000.0 / queries);
+    }
+
+    for (int fmt = 0; fmt < 2; ++fmt) {
+        const std::string& path = fmt == 0 ? csv_path : json_path;
+        auto t0 = std::chrono::steady_clock::now();
+        const bool wrote = LabelFile::Write(path, labels);
+        const double write_ms = msSince(t0);
+        std::vector<audio_label> back;
+        t0 = std::chrono::steady_clock::now();
+        const bool read = LabelFile::Read(path, back);
+        const double read_ms = msSince(t0);
+        std::printf("%s export %8.1f ms  import %8.1f ms  %.1f MB%s\n", fmt == 0 ? "csv " : "json",
+                    write_ms, read_ms, fileBytes(path) / 1e6,
+                    wrote && read && same(back, labels) ? "" : "  MISMATCH");
+        if (!(wrote && read && same(back, labels))) ++failed;
+    }
+
+    std::remove(store_path.c_str());
+    std::remove(csv_path.c_str());
+    std::remove(json_path.c_str());
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,181 @@
+// SignalReader benchmark on real files: random window latency the way the view / DL
+// jobs read, cold (fresh reader) and warm, plus the latency of cache hits while a
+// second thread keeps missing, which is what a scroll feels during DL or prefetch.
+//
+//   signal_reader_bench [--windows N] [--span SEC] [--sr HZ] [--hits N] [FILE ...]
+//
+// Without files a 10 min 44.1 kHz stereo WAV and FLAC are written to /tmp first and
+// removed afterwards. --sr resamples like the view (default: source rate).
+
+#include "signal_reader.h"
+
+#include <sndfile.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using raiden::SignalReader;
+
+namespace {
+
+struct Options {
+    int windows = 200;
+    float span = 5.0f;
+    int sr = -1;
+    int hits = 2000;
+    std::vector<std::string> files;
+};
+
+double msSince(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+double percentile(std::vector<double> v, double q) {
+    if (v.empty()) return 0.0;
+    const size_t k = std::min(v.size() - 1, size_t(q * double(v.size())));
+    std::nth_element(v.begin(), v.begin() + long(k), v.end());
+    return v[k];
+}
+
+void report(const char* name, const std::vector<double>& ms) {
+    const double mx = ms.empty() ? 0.0 : *std::max_element(ms.begin(), ms.end());
+    std::printf("  %-18s p50 %8.3f  p95 %8.3f  p99 %8.3f  max %8.3f ms  (%zu)\n", name,
+                percentile(ms, 0.50), percentile(ms, 0.95), percentile(ms, 0.99), mx, ms.size());
+}
+
+// a few partials and noise, so FLAC has something to compress and decode
+bool writeTestFile(const std::string& path, int format, int sr, int channels, int seconds) {
+    SF_INFO info{};
+    info.samplerate = sr;
+    info.channels = channels;
+    info.format = format | SF_FORMAT_PCM_16;
+    SNDFILE* f = sf_open(path.c_str(), SFM_WRITE, &info);
+    if (!f) {
+        std::fprintf(stderr, "write %s: %s\n", path.c_str(), sf_strerror(nullptr));
+        return false;
+    }
+    std::mt19937 rng(5);
+    std::normal_distribution<float> noise(0.0f, 0.03f);
+    std::vector<float> buf(size_t(sr) * size_t(channels));
+    for (int s = 0; s < seconds; ++s) {
+        for (int i = 0; i < sr; ++i) {
+            const float t = float(s) + float(i) / float(sr);
+            const float v = 0.3f * std::sin(6.2831853f * 220.0f * t) + 0.1f * std::sin(6.2831853f * 3100.0f * t);
+            for (int c = 0; c < channels; ++c) buf[size_t(i) * size_t(channels) + size_t(c)] = v + noise(rng);
+        }
+        sf_writef_float(f, buf.data(), sr);
+    }
+    sf_close(f);
+    return true;
+}
+
+int benchFile(const std::string& path, const Options& opt) {
+    std::shared_ptr<SignalReader> reader = SignalReader::open(path);
+    if (!reader) {
+        std::fprintf(stderr, "cannot open %s\n", path.c_str());
+        return 1;
+    }
+    const double dur = double(reader->frames()) / double(reader->sampleRate());
+    std::printf("%s: %.1f s, %d Hz, %d ch, %d windows of %.1f s%s\n", path.c_str(), dur, reader->sampleRate(),
+                reader->channels(), opt.windows, opt.span, opt.sr > 0 ? " (resampled)" : "");
+    if (dur <= opt.span) return 1;
+
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<double> at(0.0, dur - opt.span);
+    std::vector<float> offsets(size_t(opt.windows));
+    for (float& o : offsets) o = float(at(rng));
+
+    // cold: every window on a fresh reader lands on blocks it has not decoded yet
+    std::vector<double> cold, warm;
+    for (float o : offsets) {
+        std::shared_ptr<SignalReader> fresh = SignalReader::open(path);
+        const auto t0 = std::chrono::steady_clock::now();
+        fresh->read(o, opt.span, opt.sr);
+        cold.push_back(msSince(t0));
+    }
+    report("cold window", cold);
+
+    // warm: the shared reader, the last few windows again (fit in the 64 block cache)
+    for (float o : offsets) reader->read(o, opt.span, opt.sr);
+    for (int rep = 0; rep < 4; ++rep) {
+        for (size_t i = offsets.size() - std::min<size_t>(offsets.size(), 8); i < offsets.size(); ++i) {
+            const auto t0 = std::chrono::steady_clock::now();
+            reader->read(offsets[i], opt.span, opt.sr);
+            warm.push_back(msSince(t0));
+        }
+    }
+    report("warm window", warm);
+
+    // hits while another thread misses: one resident window read over and over next to
+    // a thread walking random cold windows (DL / prefetch on the same reader)
+    const float hot = offsets.back();
+    reader->read(hot, opt.span, opt.sr);
+    std::atomic<bool> stop(false);
+    std::thread misser([&] {
+        std::mt19937 r(13);
+        while (!stop) reader->read(float(at(r)), opt.span, opt.sr);
+    });
+    std::vector<double> contended;
+    for (int i = 0; i < opt.hits; ++i) {
+        const auto t0 = std::chrono::steady_clock::now();
+        reader->read(hot, opt.span, opt.sr);
+        contended.push_back(msSince(t0));
+    }
+    stop = true;
+    misser.join();
+    report("hit under misses", contended);
+
+    const SignalReader::Stats st = reader->stats();
+    std::printf("  reader: %lld hits, %lld misses, %.1f M frames decoded\n",
+                (long long)st.hits, (long long)st.misses, double(st.decoded_frames) / 1e6);
+    return 0;
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--windows") && hasValue) {
+            opt.windows = std::max(1, std::atoi(argv[++i]));
+        } else if (!std::strcmp(argv[i], "--span") && hasValue) {
+            opt.span = std::max(0.01f, float(std::atof(argv[++i])));
+        } else if (!std::strcmp(argv[i], "--sr") && hasValue) {
+            opt.sr = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--hits") && hasValue) {
+            opt.hits = std::max(1, std::atoi(argv[++i]));
+        } else if (argv[i][0] == '-') {
+            std::fprintf(stderr, "usage: signal_reader_bench [--windows N] [--span SEC] [--sr HZ] [--hits N] [FILE ...]\n");
+            return 2;
+        } else {
+            opt.files.push_back(argv[i]);
+        }
+    }
+
+    std::vector<std::string> made;
+    if (opt.files.empty()) {
+        const std::string base = "/tmp/signal_reader_bench_" + std::to_string(getpid());
+        const std::string wav = base + ".wav", flac = base + ".flac";
+        if (!writeTestFile(wav, SF_FORMAT_WAV, 44100, 2, 600) || !writeTestFile(flac, SF_FORMAT_FLAC, 44100, 2, 600)) {
+            return 1;
+        }
+        made = { wav, flac };
+        opt.files = made;
+    }
+
+    int failed = 0;
+    for (const std::string& f : opt.files) failed += benchFile(f, opt);
+    for (const std::string& f : made) std::remove(f.c_str());
+    return failed ? 1 : 0;
+}
@@ -10,32 +10,52 @@
 
 #include "media.h"
 #include "librosa.h"
+#include "signal_reader.h"
+#include "feature_engine.h"
 #include "ffmpeg_reader.h"
 
 #include <thread>
 #include <atomic>
-#include <condition_variable>
+#include <memory>
 
 #include "label_track.h"
+#include "label_index.h"
+#include "label_store.h"
+#include "job_scheduler.h"
 #include "ws_sink.h"
 #include "i_media_sink.h"
 
-struct audio_label {
-    double start, end;
-    std::string label;
-};
-
-struct audio_ui_label {
-    audio_label label;
-    SpanItem* span;
-};
-
 class GlSpecViewport : public QFrame, public WsSink, public IMediaSinkCallback {
     Q_OBJECT
 public:
     explicit GlSpecViewport(QWidget* parent=nullptr);
     ~GlSpecViewport() override;
     void setSignalViewMode(const ViewSignalDataMode& view_mode, const bool& isChange);
+    // spectrogram colour window in dB; applied on the GPU, no recompute
+    void setSpecDbRange(float min_db, float max_db, float contrast = 1.0f);
+    void setSpecSmooth(bool smooth);
+    // scrolling ring texture for the spectrogram of audio files: new views only compute and
+    // upload the columns that were not on screen yet, and playback follows the playhead smoothly
+    void setSpecRingMode(bool on);
+    // resident full-window spectrogram textures (video / non-ring views); GUI thread
+    SpecTextureCache::Stats specCacheStats() const { return gl_frame->specCacheStats(); }
+    void setSpecCacheBudget(size_t bytes, size_t max_entries) { gl_frame->setSpecCacheBudget(bytes, max_entries); }
+    // ticks and labels drawn by the GL view itself; the LabelTrackView lane is hidden meanwhile
+    void setGlTimeline(bool on);
+    // labels of the open media persist in "<media path>.vlbl" next to it; import adds to
+    // them, export writes all of them. CSV or JSON by extension
+    bool importLabels(const QString& path);
+    bool exportLabels(const QString& path) const;
+    // queue latency / run time of the view, label, prefetch and DL jobs
+    JobScheduler::ClassStats jobStats(JobScheduler::Priority priority) const { return scheduler_->GetStats(priority); }
+    // spectrogram windows computed by the view and prefetch jobs since the viewport was made
+    struct MelWindowStats {
+        uint64_t windows = 0;
+        uint64_t upload_bytes = 0;
+        uint64_t direct_fft = 0;   // FFTs the direct path ran
+        uint64_t saved_fft = 0;    // against the overlap tiles for the same windows
+    };
+    MelWindowStats melWindowStats() const;
 private:
     QScrollBar* scroll_bar = nullptr;
     GlSpecViewFrame* gl_frame = nullptr;
@@ -43,21 +63,54 @@ private:
 private:
     ViewSignalDataMode view_mode = ViewSignalDataMode::WaveForm;
     std::vector<float> curr_wave_data;
-    SignalAdaptGl currSignAdaptGl;
+    std::shared_ptr<const SignalAdaptGl> currSignAdaptGl; // shared with the GUI thread, never copied
     double duration_sec_ = 0.0;
     double viewport_sec_ = 5.0;
     const int target_sr_ = 22050; // render SR
-    float global_peak_ = 1.0f;    // set to 1 if your loader returns [-1,1]
+    float global_peak_ = 1.0f;    // 1 until the peak index of the loaded file is ready
+    bool wave_gpu_view_ = false;  // GUI thread: the waveform is drawn from the uploaded peak pyramid
     int pWidthGlFrame;
 
     int n_hop = 256;
     // int n_fft = 2048;
     int n_fft = 1024;
-    std::vector<audio_label> list_label;
-    std::vector<audio_label> list_usage_label;
-    std::vector<audio_ui_label> list_ui_label;
+    SpecWindowMode spec_window_mode_ = SpecWindowMode::Direct;
+    SpecSampleFormat spec_sample_format_ = SpecSampleFormat::U8;
+    // worker-owned resamplers; filter state carries over between consecutive windows of the same file
+    raiden::StreamResampler display_resampler_{ResampleQuality::SincFast};
+    raiden::StreamResampler dl_resampler_{ResampleQuality::SincBest};
+    raiden::StreamResampler prefetch_resampler_{ResampleQuality::SincFast};
+    std::string display_resampler_path_;
+    std::string dl_resampler_path_;
+    std::string prefetch_resampler_path_;
+    // shared by the view, prefetch and DL jobs; swapped with std::atomic_store on open
+    std::shared_ptr<raiden::SignalReader> signal_reader_;
+
+    // per-hop features of the open file, computed in the background on open
+    const int feature_hop_ = 512;
+    std::thread feature_thread_;
+    std::atomic<bool> feature_cancel_{false};
+    std::shared_ptr<const raiden::AudioFeatures> features_;
+    void start_feature_analysis(std::shared_ptr<raiden::SignalReader> reader);
+    // all labels, replaced whole on every change (std::atomic_load / atomic_store); readers query
+    // their snapshot without a lock. nullptr while label_store_ holds every label: queries then
+    // read the mapped store under mtx_ws_dl_ and no index is built (open stays O(blocks))
+    LabelIndex::Ptr labels_ = LabelIndex::Empty();
+    // sidecar of the open media, mtx_ws_dl_; DL results are appended as they arrive
+    std::unique_ptr<LabelStore> label_store_;
+    // swaps the store and labels_ for the new media, returns how far DL already got
+    double open_label_store(const std::string& media_path);
+    // into the store and / or labels_; a failed append moves the labels to an index for good
+    void add_labels(std::vector<audio_label> list, double covered_sec);
+    void query_labels(double start, double end, std::vector<audio_label>& out) const;
+    void kick_labels();
+    std::vector<audio_label> list_usage_label;   // labels in the view, mtx_lbl_
+    std::vector<LabelSpan> shown_labels_;        // GUI thread, last handed to the lane / GL timeline
+    double timeline_start_sec_ = 0.0;
+    bool gl_timeline_ = false;
 private:
     void setScrollX(int px);
+    void setTimelineStart(double sec, double viewport_sec);   // label lane or GL timeline
     int chooseScale(double duration_sec, int preferred = 1000 /*ms*/);
     void setupTimeScrollbar(QScrollBar* bar,
                             double duration_sec,
@@ -65,36 +118,45 @@ private:
 
 // analyzer
 private:
+    // view (Interactive) > labels > next window prefetch > DL (Background); one job per key
+    // queued (latest wins) and running, so each job owns its resampler / reader like the
+    // worker threads did
+    std::unique_ptr<JobScheduler> scheduler_;
+
     // audio visualizer data
-    bool has_job_ = false;
     double job_start_ = 0.0;
-    std::thread worker_;
-    std::atomic<bool> quit_{false};
     std::mutex mtx_;
-    std::condition_variable cv_;
 
     // audio label data
-    bool has_job_lbl_ = false;
     double job_start_lbl_ = 0.0;
-    std::thread worker_lbl_;
-    std::atomic<bool> quit_lbl_{false};
     std::mutex mtx_lbl_;
-    std::condition_variable cv_lbl_;
 
     // audio label dl data
-    bool has_job_lbl_dl_ = false;
     double job_start_dl_ = 0.0;
-    std::thread worker_dl_;
-    std::atomic<bool> quit_dl_{false};
     std::mutex mtx_dl_;
-    std::condition_variable cv_dl_;
 
-    std::mutex mtx_ws_dl_;
+    mutable std::mutex mtx_ws_dl_;
 
     void request_window(float start=0.0);
-    void worker_loop();
-    void worker_audio_lbl_loop();
-    void worker_audio_dl_loop();
+    void view_job();
+    void labels_job();
+    void dl_job();
+    void prefetch_job(double start);
+    void kick_view();
+    void kick_dl();
+    // full-window spectrogram of start + viewport into the texture cache (cache mode only)
+    void kick_prefetch(double start);
+    SpecCacheKey prefetch_key_;   // last window handed to the prefetch job, mtx_
+    SpectrogramQ mel_window(const std::vector<float>& samples, int sr, float ref_power);
+    // shortest window mel_window computes: n_fft/2 + 1 for the direct STFT, n_fft for overlap chunks
+    int mel_min_samples() const { return spec_window_mode_ == SpecWindowMode::Direct ? n_fft / 2 + 1 : n_fft; }
+    // dB reference of every spectrogram path: a full-scale sine at the file's peak (1.0 until the
+    // features are in), so it does not move with the window, a ring reset or a jump
+    float spec_ref_power() const;
+    std::atomic<uint64_t> mel_windows_{0};        // view + prefetch jobs, see melWindowStats()
+    std::atomic<uint64_t> mel_upload_bytes_{0};
+    std::atomic<uint64_t> mel_direct_fft_{0};
+    std::atomic<uint64_t> mel_saved_fft_{0};
 signals:
     void glUiKick();
     void labelsUiKick();
@@ -107,11 +169,38 @@ private:
     // FFMpegReader ffmpeg_reader;
     std::shared_ptr<FFMpegReader> ffmpeg_reader;
     std::shared_ptr<FFMpegReader> ffmpeg_reader_dl;
+    std::shared_ptr<FFMpegReader> ffmpeg_reader_prefetch;
     MediaObj::Audio audio_obj;
     bool is_video = false;
     std::vector<SpecViewPort> list_view_port;
     std::vector<SpecViewPortNDC> list_view_port_ndc;
-    SpectrogramTileOverlap melSpec;
+    SpectrogramQ melSpecQ;
+    SpecCacheKey melSpecKey;          // what melSpecQ was computed from
+    // identifies the full spectrogram window at start with the current analysis settings (mtx_ held)
+    SpecCacheKey spec_cache_key(double start) const;
+
+    // ring spectrogram: batches of new columns queued for the GUI thread (mtx_); a reset drops older ones
+    struct SpecRingUpdate {
+        bool reset = false;
+        int width = 0;               // ring columns
+        int64_t first_frame = 0;     // absolute hop frame of cols column 0
+        SpectrogramQ cols;
+        double view_first = 0.0;     // fractional frame at the left edge
+        double view_frames = 0.0;
+    };
+    std::vector<SpecRingUpdate> spec_ring_pending_;
+    // frames [lo, hi) currently in the ring; view job only
+    struct SpecRingState {
+        std::string path;
+        int width = 0;
+        int64_t lo = 0, hi = 0;
+        float ref_power = 0.0f;      // spec_ref_power() the ring columns were computed with
+        SpecSampleFormat format = SpecSampleFormat::U8;
+    } spec_ring_;
+    std::atomic<bool> spec_ring_mode_{true};
+    std::atomic<bool> spec_ring_reset_{true};
+    static const int kSpecRingMargin = 64;   // spare columns on each side of the view
+    bool spec_ring_step(raiden::SignalReader& reader, double start, double view_sec, int sr);
 
     WsClient* client = nullptr;
     void on_ws_message(const std::string &m) override;
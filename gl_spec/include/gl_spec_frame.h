@@ -5,14 +5,22 @@
 #include <memory>
 #include "vertex_array.h"
 #include "vertex_buffer.h"
+#include "streaming_vertex_buffer.h"
 #include "vertex_buffer_layout.h"
 #include "shader.h"
 #include "renderer.h"
 #include "texture.h"
+#include "buffer_texture.h"
+#include "gl_profiler.h"
+#include "gl_state_cache.h"
+#include "spec_texture_cache.h"
+#include "timeline_overlay.h"
 
 #include "obj_audio.h"
+#include "peak_index.h"
 
 #include <QOpenGLWidget>
+#include <chrono>
 
 
 class GlSpecViewFrame : public QOpenGLWidget {
@@ -35,11 +43,49 @@ private:
    int gl_draw_count;
    std::unique_ptr<Renderer> renderer;
 
-   // vertex wave
-   std::unique_ptr<VertexBuffer> vbWave;
+   // vertex wave; each view is streamed into the next range of vbWave and drawn from waveFirst
+   std::unique_ptr<StreamingVertexBuffer> vbWave;
    std::unique_ptr<VertexArray> vaWave;
    std::unique_ptr<VertexBufferLayout> vblWave;
    std::unique_ptr<Shader> shaderWave;
+   GLint waveFirst = 0;
+   uint32_t vaWaveGeneration = 0;
+   int waveStreamFrames = 0;      // vbWave stats logged every kWaveStreamLogFrames while profiling
+   static const int kWaveStreamLogFrames = 120;
+   GlStateCache::FrameStats lastGlCalls;   // of the last paintGL, see glCallStats()
+
+   // created / dropped by paintGL (context current) as profiling is switched
+   std::unique_ptr<GlProfiler> profiler;
+   bool profiling = false;
+   bool profileOverlay = false;
+   std::chrono::steady_clock::time_point paintEnd;   // "swap" runs from here to frameSwapped
+   void drawProfileOverlay();
+
+   // RMS band drawn under the waveform (triangle strip)
+   std::unique_ptr<StreamingVertexBuffer> vbRms;
+   std::unique_ptr<VertexArray> vaRms;
+   std::unique_ptr<VertexBufferLayout> vblRms;
+   int rmsCount = 0;
+   GLint rmsFirst = 0;
+   uint32_t vaRmsGeneration = 0;
+
+   // GPU waveform: the peak pyramid of the whole file lives in one buffer texture
+   // (RGBA16F min/max/rms/0, levels back to back); a view is only uniforms
+   struct WaveGpuLevel {
+       int spp = 0;
+       int base = 0;     // first texel
+       int count = 0;    // 0 when the level did not fit
+   };
+   std::unique_ptr<BufferTexture> texWavePeaks;
+   std::unique_ptr<VertexArray> vaWaveGpu;   // no attributes, gl_VertexID only
+   std::unique_ptr<Shader> shaderWaveGpu;
+   WaveGpuLevel waveGpuLevels[raiden::PeakIndex::kLevels];
+   bool waveGpu = false;      // draw from texWavePeaks instead of vbWave
+   int waveGpuLevel = 0;
+   int waveGpuE0 = 0;
+   float waveGpuFrac = 0.0f;
+   float waveGpuStep = 1.0f;
+   float waveGpuGain = 1.0f;
 
    std::unique_ptr<VertexBuffer> vbMelSpec;
    std::unique_ptr<VertexArray> vaMelSpec;
@@ -47,10 +93,80 @@ private:
    std::unique_ptr<VertexBufferLayout> vblMelSpec;
    std::unique_ptr<Texture> texMelSpec;
    std::unique_ptr<Shader> shaderMelSpec;
+   // texel -> dB of the current texture, and the displayed dB window
+   float specScale = 1.0f;
+   float specOffset = 0.0f;
+   float specMinDb = -80.0f;
+   float specMaxDb = 0.0f;
+   float specContrast = 1.0f;
+   bool specSmooth = false; // GL_LINEAR between bins/frames instead of GL_NEAREST blocks
+
+   // recently shown full windows stay resident; specShown (when set) is drawn instead of texMelSpec
+   static const size_t kSpecCacheBytes = size_t(64) << 20;
+   static const size_t kSpecCacheEntries = 48;
+   SpecTextureCache specCache{kSpecCacheBytes, kSpecCacheEntries};
+   const SpecTextureCache::Entry* specShown = nullptr;
+
+   // ring mode: fixed width texture, spectrogram frame f lives in column f % specRingWidth
+   // and the shader scrolls through it with u_UOffset (GL_REPEAT wraps)
+   std::unique_ptr<Texture> texMelRing;
+   bool specRing = false;
+   int specRingWidth = 0;
+   float specUOffset = 0.0f;
+   float specUSpan = 1.0f;
+
+   // GL drawn ticks + label spans at the bottom, instead of the separate LabelTrackView
+   std::unique_ptr<TimelineOverlay> timeline;
+
+   void initSpecQuad();   // context current
+   // data -> next range of vb (re-pointing va after a grow); returns the first vertex. Context current
+   GLint streamVertices(StreamingVertexBuffer& vb, VertexArray& va, const VertexBufferLayout& layout,
+                        uint32_t& generation, const std::vector<float>& data);
 
 public:
-   void setViewWav(const float& start_sec, const float& view_port_sec, const int& gl_draw_count, const std::vector<float> &draw_data);
-   void setViewSpec(const float& start_sec, const float& view_port_sec, const SpectrogramTileOverlap& spec);
+   void setViewWav(const float& start_sec, const float& view_port_sec, const int& gl_draw_count, const std::vector<float> &draw_data,
+                   const std::vector<float> &rms_band = std::vector<float>());
+   void setViewSpec(const float& start_sec, const float& view_port_sec, const SpectrogramQ& spec);
+   // keep spec resident under key (uploaded once, no-op when already there); does not change the view
+   void cacheSpec(const SpecCacheKey& key, const SpectrogramQ& spec);
+   // switch to the resident window of key; false when it is not (or no longer) in the cache
+   bool showCachedSpec(const SpecCacheKey& key);
+   void setSpecCacheBudget(size_t bytes, size_t max_entries);
+   SpecTextureCache::Stats specCacheStats() const { return specCache.GetStats(); }
+   // display range / contrast only; the texture is not touched
+   void setSpecDbRange(float min_db, float max_db, float contrast = 1.0f);
+   void setSpecSmooth(bool smooth);
+
+   // upload the peak pyramid once per file (finest levels are dropped past GL_MAX_TEXTURE_BUFFER_SIZE)
+   bool setWavePeaks(const raiden::PeakIndex& peaks);
+   void clearWavePeaks();
+   bool hasWavePeaks() const { return texWavePeaks != nullptr; }
+   // waveform of source samples [start_sample, start_sample + span_samples) drawn from the uploaded
+   // pyramid; false when the view is finer than the finest uploaded level (use setViewWav)
+   bool setViewWavGpu(int64_t start_sample, int64_t span_samples, float gain);
+
+   // (re)allocate the ring: width columns x height bins, filled with the display floor
+   void resetSpecRing(int width, int height, SpecSampleFormat format, float scale, float offset);
+   // columns [first_frame, first_frame + cols.width) into their ring slots; only those texels are uploaded
+   void writeSpecRing(int64_t first_frame, const SpectrogramQ& cols);
+   // show frames [first_frame, first_frame + frames); fractional, so the view scrolls at display rate
+   void setSpecRingView(double first_frame, double frames);
+
+   // ticks and label spans drawn in this view's GL pass (see TimelineOverlay); off by default
+   void setTimelineOverlay(bool on);
+   bool hasTimelineOverlay() const { return timeline != nullptr; }
+   void setTimelineView(double start_sec, double viewport_sec);
+   void setTimelineLabels(const std::vector<LabelSpan>& spans);
+
+   // per region CPU / GPU times of paintGL and the uploads; overlay draws their percentiles on top
+   void setProfiling(bool on, bool overlay = false);
+   // percentiles as CSV; false when not profiling or the file cannot be written
+   bool dumpProfile(const QString& path) const;
+   std::vector<GlProfiler::RegionStats> profileStats() const {
+       return profiler ? profiler->Stats() : std::vector<GlProfiler::RegionStats>();
+   }
+   // GLCall invocations and redundant state changes the state cache skipped in the last paintGL
+   GlStateCache::FrameStats glCallStats() const { return lastGlCalls; }
 };
 
 #endif // GL_SPEC_FRAME_H
@@ -0,0 +1,91 @@
+#ifndef JOB_SCHEDULER_H
+#define JOB_SCHEDULER_H
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Small fixed pool for GlSpecViewport's background work, in place of one thread per kind of
+// job. Jobs carry a priority class and a key:
+//   - the highest class with a runnable job goes first, FIFO within a class
+//   - a job submitted while one with the same key is still queued replaces it (latest wins,
+//     it keeps the queue position and the submit time of the first)
+//   - jobs with the same key never run at the same time, so a key can own state that is not
+//     thread safe (a resampler, a decoder); an empty key opts out of both
+//   - Prefetch and Background together never take the last worker, so a view change always
+//     finds one free
+class JobScheduler {
+public:
+    enum Priority { Interactive = 0, Labels, Prefetch, Background, kPriorityCount };
+    typedef std::function<void()> Job;
+
+    struct ClassStats {
+        uint64_t submitted = 0;
+        uint64_t coalesced = 0;   // replaced before they started
+        uint64_t run = 0;
+        size_t queued = 0;
+        // submit -> start and run time over the last kStatsWindow jobs, ms
+        double wait_p50_ms = 0.0;
+        double wait_p95_ms = 0.0;
+        double wait_max_ms = 0.0;
+        double run_p50_ms = 0.0;
+    };
+
+    explicit JobScheduler(int worker_count = DefaultWorkers());
+    ~JobScheduler();   // Shutdown()
+
+    JobScheduler(const JobScheduler&) = delete;
+    JobScheduler& operator=(const JobScheduler&) = delete;
+
+    // false once shut down
+    bool Submit(Priority priority, const std::string& key, Job job);
+    // drops queued jobs with key (a running one finishes); how many were dropped
+    size_t Cancel(const std::string& key);
+    // drops everything queued and waits for the running jobs
+    void Shutdown();
+
+    ClassStats GetStats(Priority priority) const;
+    inline int WorkerCount() const { return workerCount; }
+
+    // hardware threads - 1, at least 2 (one stays free for Interactive), at most 4
+    static int DefaultWorkers();
+    static const char* PriorityName(Priority priority);
+    static const size_t kStatsWindow = 256;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+    struct Task {
+        std::string key;
+        Job job;
+        Clock::time_point submitted;
+    };
+    struct Samples {
+        std::vector<double> wait, run;   // rings of kStatsWindow
+        size_t next = 0;
+    };
+
+    void workerLoop();
+    bool pick(int& priority, std::deque<Task>::iterator& it);   // mtx held
+
+    mutable std::mutex mtx;
+    std::condition_variable cv;
+    int workerCount = 0;                  // fixed before the first worker starts
+    std::vector<std::thread> workers;
+    std::deque<Task> queues[kPriorityCount];
+    std::set<std::string> running;        // keys of the running jobs
+    int runningLow = 0;                   // Prefetch + Background jobs running
+    bool stopping = false;
+
+    ClassStats stats[kPriorityCount];
+    Samples samples[kPriorityCount];
+};
+
+#endif // JOB_SCHEDULER_H
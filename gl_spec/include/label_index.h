@@ -0,0 +1,54 @@
+#ifndef LABEL_INDEX_H
+#define LABEL_INDEX_H
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct audio_label {
+    double start, end;
+    std::string label;
+};
+
+// Immutable label set for viewport queries.
+//
+// Labels are sorted by start and the array doubles as an implicit balanced interval
+// tree (cgranges layout): the node at index i sits at level = number of trailing 1
+// bits of i, and maxEnd[i] is the largest end in its subtree. Overlap queries are
+// O(log n + k) without any pointer structure.
+//
+// A snapshot never changes after Build(); writers publish a new one (With()) and
+// readers holding the old shared_ptr keep a consistent view, no lock and no copy.
+class LabelIndex {
+public:
+    typedef std::shared_ptr<const LabelIndex> Ptr;
+
+    static Ptr Build(std::vector<audio_label> labels);
+    static Ptr Empty();
+    // this snapshot plus added, as a new snapshot (one merge, the old one is untouched)
+    Ptr With(std::vector<audio_label> added) const;
+
+    // labels with end > start && label.start < end, in start order; appended to out
+    void Query(double start, double end, std::vector<audio_label>& out) const;
+    // indices into Labels() of the same set
+    void QueryIndices(double start, double end, std::vector<size_t>& out) const;
+    size_t Count(double start, double end) const;
+
+    inline size_t Size() const { return labels.size(); }
+    inline const std::vector<audio_label>& Labels() const { return labels; }
+
+private:
+    LabelIndex() = default;
+    void index();
+
+    template <class F>
+    void overlap(double start, double end, F f) const;
+
+    std::vector<audio_label> labels;   // sorted by start
+    std::vector<double> maxEnd;        // per node, max end over its subtree
+    int rootLevel = -1;                // -1: empty
+};
+
+#endif // LABEL_INDEX_H
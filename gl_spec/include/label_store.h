@@ -0,0 +1,101 @@
+#ifndef LABEL_STORE_H
+#define LABEL_STORE_H
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "label_index.h"
+
+// Append-only, memory mapped label file (sidecar "<media>.vlbl"), so labels survive a
+// restart and DL output does not have to be inferred again.
+//
+//   header   64 bytes: magic, version, committed bytes, label / block / tag counts,
+//            covered_sec (how far the DL pass got)
+//   block    48 byte header (count, new tags, first label, min start, max end, bytes), then
+//            columns start f64[count], end f64[count], tag u32[count], then the tags first
+//            used by this block as (u32 length, bytes); 8 byte aligned
+//
+// Each Append() is one block, sorted by start; the block headers are the index (min start
+// / max end skip whole blocks in Query, a binary search on start finds the first candidate
+// inside one). Open() maps the file and walks the block headers only, labels are read in
+// place. A writable store maps ahead of the file (x2 when an append outgrows it), appends
+// show up through the shared mapping without a remap. A block is written before the header
+// that commits it, so a torn append is ignored and overwritten by the next one. Native
+// byte order.
+//
+// Not thread safe; one writer per file.
+class LabelStore {
+public:
+    struct Block {
+        uint64_t first = 0;       // index of the block's first label
+        uint32_t count = 0;
+        double min_start = 0.0;
+        double max_end = 0.0;
+        size_t offset = 0;        // of the start column in the file
+        mutable double max_len = -1.0;   // longest label; -1 until a Query needs it (loaded blocks)
+    };
+
+    // writable: created when missing. nullptr on failure (reason in *error)
+    static std::unique_ptr<LabelStore> Open(const std::string& path, bool writable, std::string* error = nullptr);
+    ~LabelStore();
+
+    LabelStore(const LabelStore&) = delete;
+    LabelStore& operator=(const LabelStore&) = delete;
+
+    // one block; labels are visible right away, durable once it returns when sync is set.
+    // covered_sec only grows. False on a read only store or a failed write
+    bool Append(const std::vector<audio_label>& labels, double covered_sec = 0.0, bool sync = true);
+
+    inline size_t Size() const { return size_t(labelCount); }
+    inline double CoveredSec() const { return coveredSec; }
+    inline const std::vector<Block>& Blocks() const { return blocks; }
+    inline const std::vector<std::string>& Tags() const { return tags; }
+    inline size_t FileBytes() const { return size_t(committed); }
+
+    // columns of block b, valid until the next Append
+    const double* Starts(const Block& b) const;
+    const double* Ends(const Block& b) const;
+    const uint32_t* TagIds(const Block& b) const;
+
+    std::vector<audio_label> ReadAll() const;
+    // labels with end > start && label.start < end, block by block
+    void Query(double start, double end, std::vector<audio_label>& out) const;
+
+private:
+    LabelStore() = default;
+    bool load(std::string* error);       // maps committed bytes, walks the blocks
+    bool remap();                        // no-op while the mapping still covers committed
+    bool writeHeader();
+
+    std::string path;
+    int fd = -1;
+    bool writable = false;
+    const uint8_t* base = nullptr;
+    size_t mapped = 0;
+
+    uint64_t committed = 0;
+    uint64_t labelCount = 0;
+    double coveredSec = 0.0;
+    std::vector<Block> blocks;
+    std::vector<std::string> tags;
+    std::unordered_map<std::string, uint32_t> tagIds;
+};
+
+// CSV (start,end,label with a header line) and JSON (array of {"start", "end", "value"}, the
+// DL result shape; {"result": [...]} is read too) for interop
+class LabelFile {
+public:
+    static bool ReadCsv(const std::string& path, std::vector<audio_label>& out);
+    static bool WriteCsv(const std::string& path, const std::vector<audio_label>& labels);
+    static bool ReadJson(const std::string& path, std::vector<audio_label>& out);
+    static bool WriteJson(const std::string& path, const std::vector<audio_label>& labels);
+    // by extension, .json or else CSV
+    static bool Read(const std::string& path, std::vector<audio_label>& out);
+    static bool Write(const std::string& path, const std::vector<audio_label>& labels);
+};
+
+#endif // LABEL_STORE_H
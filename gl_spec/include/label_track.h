@@ -3,6 +3,7 @@
 #pragma once
 #include <QGraphicsView>
 #include <QGraphicsObject>
+#include <vector>
 
 struct LabelSpan { double start, end; QString tag; };
 
@@ -22,6 +23,10 @@ public:
     }
 
     void setPxPerSec(double pps);
+    // rebinds a pooled item to another label, repaints only when the text changed
+    void setSpan(double start, double end, const QString& tag);
+    // left edge and width in scene px; geometry is only touched when they moved
+    void place(double x, double length);
 
 // signals:
     // void spanChanged(double start, double end);
@@ -47,15 +52,23 @@ public:
         return w > 0 ? double(w) / viewport_sec : 1.0;
     }
 
-    SpanItem* addSpan(double startSec, double endSec, const QString& tag);
+    // the labels to show (normally the ones overlapping the view); bound to a pool of SpanItems
+    // that only grows to the most ever visible at once, so scrolling creates and deletes nothing
+    void setLabels(const std::vector<LabelSpan>& spans);
 
 protected:
     void drawBackground(QPainter*, const QRectF&) override;
+    void resizeEvent(QResizeEvent* e) override;
 private:
+    void layoutSpans();   // positions the bound items for start_sec / viewport_sec
+
     QGraphicsScene scene_;
     double start_sec = 0.0;
     double viewport_sec = 5.0;
     double widthRec = 100;
+
+    std::vector<SpanItem*> pool_;   // owned by scene_
+    size_t active_ = 0;             // pool_[0, active_) are bound
 };
 
 #endif // LABEL_TRACK_H
@@ -0,0 +1,99 @@
+#ifndef SPEC_TEXTURE_CACHE_H
+#define SPEC_TEXTURE_CACHE_H
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "texture.h"
+#include "obj_audio.h"
+
+// What a full-window spectrogram texture was computed from; equal keys give equal texels.
+struct SpecCacheKey {
+    std::string path;
+    int64_t start_sample = 0;   // window start at sr
+    int64_t span_samples = 0;
+    int sr = 0;
+    int n_fft = 0;
+    int n_hop = 0;
+    int n_mels = 0;
+    SpecWindowMode window_mode = SpecWindowMode::Direct;
+    SpecSampleFormat format = SpecSampleFormat::U8;
+    float ref_power = 0.0f;     // dB reference; changes once the file's peak is known
+
+    bool operator==(const SpecCacheKey& o) const {
+        return start_sample == o.start_sample && span_samples == o.span_samples && sr == o.sr
+               && n_fft == o.n_fft && n_hop == o.n_hop && n_mels == o.n_mels
+               && window_mode == o.window_mode && format == o.format && ref_power == o.ref_power
+               && path == o.path;
+    }
+};
+
+struct SpecCacheKeyHash {
+    size_t operator()(const SpecCacheKey& k) const;
+};
+
+// LRU of resident spectrogram window textures under a byte and an entry budget, so
+// scrolling back to a window shown recently is a texture switch instead of a recompute
+// and upload. Textures that fall out are handed back by Reserve() for reuse when their
+// size matches, which keeps the storage allocation off the upload path.
+//
+// GUI thread, GL context current for everything that creates or drops textures.
+class SpecTextureCache {
+public:
+    struct Entry {
+        std::unique_ptr<Texture> tex;
+        TextureFormat format = TextureFormat::R8;
+        float scale = 1.0f;      // texel -> dB of this window
+        float offset = 0.0f;
+        size_t bytes = 0;
+    };
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        size_t entries = 0;
+        size_t resident_bytes = 0;
+        size_t budget_bytes = 0;
+        double hitRate() const { return hits + misses > 0 ? double(hits) / double(hits + misses) : 0.0; }
+    };
+
+    SpecTextureCache(size_t budget_bytes, size_t max_entries);
+
+    // most recently used on a hit, nullptr (and a miss) otherwise
+    const Entry* Find(const SpecCacheKey& key);
+    // no LRU or stats update
+    bool Contains(const SpecCacheKey& key) const { return index.count(key) != 0; }
+    // evicts until an entry of `bytes` fits; returns a dropped texture of that size and format
+    // to upload into, or nullptr
+    std::unique_ptr<Texture> Reserve(int width, int height, TextureFormat format);
+    // takes the texture, entry becomes most recently used (replaces an equal key)
+    const Entry* Insert(const SpecCacheKey& key, Entry entry);
+    // the entry on screen is never evicted (nullptr: none)
+    void Pin(const Entry* entry);
+    void Clear();
+
+    void SetBudget(size_t budget_bytes, size_t max_entries);
+    Stats GetStats() const;
+
+private:
+    typedef std::list<std::pair<SpecCacheKey, Entry> > Lru;   // front = most recent
+
+    // drop least recently used entries until `bytes` in `entries` more fit; one texture of
+    // width x height x format is handed to *reuse when given
+    void evictFor(size_t bytes, size_t entries, int width, int height, TextureFormat format,
+                  std::unique_ptr<Texture>* reuse);
+
+    size_t budgetBytes;
+    size_t maxEntries;
+    size_t residentBytes = 0;
+    const Entry* pinned = nullptr;
+    uint64_t hits = 0, misses = 0, evictions = 0;
+    Lru lru;
+    std::unordered_map<SpecCacheKey, Lru::iterator, SpecCacheKeyHash> index;
+};
+
+#endif // SPEC_TEXTURE_CACHE_H
@@ -0,0 +1,82 @@
+#ifndef TIMELINE_OVERLAY_H
+#define TIMELINE_OVERLAY_H
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "vertex_array.h"
+#include "vertex_buffer.h"
+#include "vertex_buffer_layout.h"
+#include "shader.h"
+#include "renderer.h"
+#include "texture.h"
+
+#include "label_track.h"
+
+// Time ticks and label spans along the bottom of the spectrogram view, drawn in the same GL
+// pass: every tick, span edge, fill and glyph is one instance of a gl_VertexID quad
+// (Label.shader), text comes from an ASCII glyph atlas rasterised once per device pixel
+// ratio. Instances are rebuilt only when the view, the labels or the framebuffer size
+// changed, otherwise a frame costs one instanced draw.
+//
+// Draw() and the destructor need the context current; the setters do not touch GL.
+class TimelineOverlay {
+public:
+    TimelineOverlay() = default;
+    ~TimelineOverlay() = default;
+
+    TimelineOverlay(const TimelineOverlay&) = delete;
+    TimelineOverlay& operator=(const TimelineOverlay&) = delete;
+
+    void SetView(double start_sec, double viewport_sec);
+    // tags outside printable ASCII show as '?'
+    void SetLabels(const std::vector<LabelSpan>& spans);
+
+    void Draw(Renderer& renderer, int fb_width, int fb_height, float dpr);
+
+    inline int GetInstanceCount() const { return instanceCount; }
+
+    static const int kLanePx = 44;        // strip height at dpr 1
+    static const int kAtlasUnit = 2;      // texture unit of the glyph atlas
+
+private:
+    struct Glyph {
+        float u0 = 0.0f, v0 = 0.0f, u1 = 0.0f, v1 = 0.0f;
+        float advance = 0.0f;             // px, also the quad width
+    };
+    struct Label {
+        double start, end;
+        std::string text;
+    };
+
+    void buildAtlas(float dpr);           // context current
+    void build(int fbw, int fbh, float dpr);
+    void quad(float x0, float y0, float x1, float y1, const float* col, const Glyph* g = nullptr);
+    void text(float x, float y, const std::string& s, const float* col);   // y: top of the line
+    float textWidth(const std::string& s) const;
+    std::string elide(const std::string& s, float max_w) const;
+    const Glyph& glyph(char c) const;
+
+    double startSec = 0.0;
+    double viewportSec = 5.0;
+    std::vector<Label> labels;
+    bool dirty = true;
+    int builtWidth = 0, builtHeight = 0;
+    float builtDpr = 0.0f;
+
+    Glyph glyphs[95];                     // ' ' .. '~'
+    float lineHeight = 0.0f;
+    float atlasDpr = 0.0f;
+    std::unique_ptr<Texture> atlas;
+
+    std::unique_ptr<Shader> shader;
+    std::unique_ptr<VertexArray> va;
+    std::unique_ptr<VertexBuffer> vb;     // per instance: rect, uv, colour (12 floats)
+    VertexBufferLayout layout;
+    std::vector<float> instances;
+    int instanceCount = 0;
+};
+
+#endif // TIMELINE_OVERLAY_H
@@ -34,6 +34,8 @@ GlSpecViewport::GlSpecViewport(QWidget* parent) : QFrame(parent) {
 
     ffmpeg_reader = make_unique<FFMpegReader>();
     ffmpeg_reader_dl = make_unique<FFMpegReader>();
+    ffmpeg_reader_prefetch = make_unique<FFMpegReader>();
+    scheduler_ = make_unique<JobScheduler>();
 
     // 1) Make a root layout for this widget, zero margins
     auto *outer = new QVBoxLayout(this);
@@ -77,31 +79,20 @@ GlSpecViewport::GlSpecViewport(QWidget* parent) : QFrame(parent) {
             // audio data > visual worker
             connect(this, &GlSpecViewport::glUiKick, this, &GlSpecViewport::on_new_audio,
                     Qt::QueuedConnection);
-            worker_ = std::thread(&GlSpecViewport::worker_loop, this);
 
-            // audio data label > label worker
+            // audio data label > label view
             connect(this, &GlSpecViewport::labelsUiKick, this, &GlSpecViewport::on_receive_audio_label,
                     Qt::QueuedConnection);
-            worker_lbl_ = std::thread(&GlSpecViewport::worker_audio_lbl_loop, this);
-
-            // audio data label > deep learning worker
-            worker_dl_ = std::thread(&GlSpecViewport::worker_audio_dl_loop, this);
         }
     }
 }
 
 GlSpecViewport::~GlSpecViewport() {
-    quit_ = true;
-    cv_.notify_all();
-    if (worker_.joinable()) worker_.join();
-
-    quit_lbl_ = true;
-    cv_lbl_.notify_all();
-    if (worker_lbl_.joinable()) worker_lbl_.join();
+    // queued jobs are dropped, running ones finish
+    scheduler_->Shutdown();
 
-    quit_dl_ = true;
-    cv_dl_.notify_all();
-    if (worker_dl_.joinable()) worker_dl_.join();
+    feature_cancel_ = true;
+    if (feature_thread_.joinable()) feature_thread_.join();
 }
 
 void GlSpecViewport::set_ws_client(WsClient* client) {
@@ -111,14 +102,19 @@ void GlSpecViewport::set_ws_client(WsClient* client) {
 void GlSpecViewport::on_receive_media_audio(MediaObj::Audio audio) {
     this->audio_obj = audio;
     this->is_video = false;
+    // mono=false: channel 0, as the workers asked audio::load for
+    std::shared_ptr<raiden::SignalReader> reader = raiden::SignalReader::open(audio.path, false);
+    std::atomic_store(&signal_reader_, reader);
+    start_feature_analysis(reader);
+    const double dl_from = open_label_store(audio.path);
     /*
-    list_label.clear();
-    list_label.push_back({0.0, 1.5, "Silent"});
-    list_label.push_back({2.0, 2.5, "Snoring"});
-    list_label.push_back({2.5, 2.8, "Silent"});
-    list_label.push_back({5.5, 6.9, "Silent"});
-    list_label.push_back({5.0, 5.4, "Silent"});
-    list_label.push_back({7.0, 8.4, "Silents"});
+    std::atomic_store(&labels_, LabelIndex::Build({
+        {0.0, 1.5, "Silent"},
+        {2.0, 2.5, "Snoring"},
+        {2.5, 2.8, "Silent"},
+        {5.5, 6.9, "Silent"},
+        {5.0, 5.4, "Silent"},
+        {7.0, 8.4, "Silents"}}));
     */
 
     this->list_view_port = raiden::audio::build_global_segments(
@@ -127,7 +123,7 @@ void GlSpecViewport::on_receive_media_audio(MediaObj::Audio audio) {
 
     duration_sec_ = this->audio_obj.num_sample() / this->audio_obj.sample_rate;
 
-    QMetaObject::invokeMethod(this, [this] {
+    QMetaObject::invokeMethod(this, [this, dl_from] {
             // now on GUI thread
             qDebug() << "Done read file spec: " << this->audio_obj.path.c_str() << " " << std::to_string(this->audio_obj.sample_rate).c_str() << " ~ "
                      << std::to_string(duration_sec_).c_str();
@@ -135,19 +131,63 @@ void GlSpecViewport::on_receive_media_audio(MediaObj::Audio audio) {
             request_window(0.0);
 
             {
+                // resume where the stored labels end
                 std::lock_guard<std::mutex> lk(mtx_dl_);
-                job_start_dl_ = 0;
-                has_job_lbl_dl_ = true;
+                job_start_dl_ = dl_from;
             }
-            cv_dl_.notify_one();
+            if (dl_from < duration_sec_) kick_dl();
 
         }, Qt::QueuedConnection);
 }
 
+void GlSpecViewport::start_feature_analysis(std::shared_ptr<raiden::SignalReader> reader) {
+    feature_cancel_ = true;
+    if (feature_thread_.joinable()) feature_thread_.join();
+    std::atomic_store(&features_, std::shared_ptr<const raiden::AudioFeatures>());
+    {
+        // back to unit gain until the new file's index says otherwise
+        std::lock_guard<std::mutex> lk(mtx_);
+        global_peak_ = 1.0f;
+    }
+    // queued ahead of the new file's upload below
+    QMetaObject::invokeMethod(this, [this] {
+            if (gl_frame) gl_frame->clearWavePeaks();
+        }, Qt::QueuedConnection);
+    if (!reader) return;
+
+    feature_cancel_ = false;
+    feature_thread_ = std::thread([this, reader] {
+        std::shared_ptr<const raiden::AudioFeatures> features = std::make_shared<const raiden::AudioFeatures>(
+            raiden::FeatureEngine::analyze(*reader, feature_hop_, &feature_cancel_));
+        if (feature_cancel_ || features->size() == 0) return;
+        std::atomic_store(&features_, features);
+
+        QMetaObject::invokeMethod(this, [this, features, reader] {
+            {
+                std::lock_guard<std::mutex> lk(mtx_);
+                if (audio_obj.path != reader->path()) return;
+                audio_obj.amplitude_time_series = features->mean_abs;
+                audio_obj.amplitude_envelope    = features->peak;
+                audio_obj.root_mean_square      = features->rms;
+                audio_obj.zero_crossing_rate    = features->zcr;
+                if (features->peaks.globalPeak() > 0.0f) global_peak_ = features->peaks.globalPeak();
+            }
+            gl_frame->setWavePeaks(features->peaks);
+            qDebug() << "Features:" << int(features->size()) << "frames, peak" << features->global_peak;
+            // the waveform gain and the spectrogram dB reference both follow the file's peak
+            if (view_mode == ViewSignalDataMode::WaveForm || view_mode == ViewSignalDataMode::Mel_Spectrogram) {
+                request_window(job_start_);
+            }
+        }, Qt::QueuedConnection);
+    });
+}
+
 void GlSpecViewport::on_receive_media(MediaObj::Vid vid, MediaObj::Audio audio) {
 
     this->is_video = true;
     this->audio_obj = audio;
+    std::atomic_store(&signal_reader_, std::shared_ptr<raiden::SignalReader>());
+    start_feature_analysis(nullptr);
     int target_sr_;
     {
         std::unique_lock<std::mutex> lk(mtx_);
@@ -155,13 +195,15 @@ void GlSpecViewport::on_receive_media(MediaObj::Vid vid, MediaObj::Audio audio)
     }
     ffmpeg_reader->media_init(vid.path, target_sr_);
     ffmpeg_reader_dl->media_init(vid.path, target_sr_);
+    ffmpeg_reader_prefetch->media_init(vid.path, target_sr_);
+    const double dl_from = open_label_store(vid.path);
 
     // qDebug() << std::to_string(this->audio_obj.num_sample()).c_str();
     // qDebug() << std::to_string(this->audio_obj.sample_rate).c_str();
     duration_sec_ = this->audio_obj.num_sample() / this->audio_obj.sample_rate;
 
     ///*
-    QMetaObject::invokeMethod(this, [this] {
+    QMetaObject::invokeMethod(this, [this, dl_from] {
             // now on GUI thread
             qDebug() << "Done read file spec: " << this->audio_obj.path.c_str() << " " << std::to_string(this->audio_obj.sample_rate).c_str() << " ~ "
                      << std::to_string(duration_sec_).c_str();
@@ -171,10 +213,9 @@ void GlSpecViewport::on_receive_media(MediaObj::Vid vid, MediaObj::Audio audio)
             ///*
             {
                 std::lock_guard<std::mutex> lk(mtx_dl_);
-                job_start_dl_ = 0;
-                has_job_lbl_dl_ = true;
+                job_start_dl_ = dl_from;
             }
-            cv_dl_.notify_one();
+            if (dl_from < duration_sec_) kick_dl();
             //*/
 
         }, Qt::QueuedConnection);
@@ -182,6 +223,92 @@ void GlSpecViewport::on_receive_media(MediaObj::Vid vid, MediaObj::Audio audio)
 
 }
 
+double GlSpecViewport::open_label_store(const std::string& media_path) {
+    std::string error;
+    std::unique_ptr<LabelStore> store = LabelStore::Open(media_path + ".vlbl", true, &error);
+    if (!store) {
+        qWarning() << "labels: no store next to" << media_path.c_str() << "-" << error.c_str() << "(kept in memory only)";
+    }
+    // the mapped store answers queries as is; nothing is read or sorted here
+    LabelIndex::Ptr labels = store ? LabelIndex::Ptr() : LabelIndex::Empty();
+    const double covered = store ? store->CoveredSec() : 0.0;
+    if (store) {
+        qDebug() << "labels:" << int(store->Size()) << "from store, DL done up to" << covered << "s";
+    }
+    {
+        std::unique_lock<std::mutex> lk(mtx_ws_dl_);
+        label_store_ = std::move(store);
+        std::atomic_store(&labels_, labels);
+    }
+    kick_labels();
+    return covered;
+}
+
+void GlSpecViewport::add_labels(std::vector<audio_label> list, double covered_sec) {
+    // writers are serialized, readers keep whatever snapshot they loaded
+    std::unique_lock<std::mutex> lk(mtx_ws_dl_);
+    const bool stored = label_store_ && label_store_->Append(list, covered_sec);
+    if (label_store_ && !stored) {
+        qWarning() << "labels: append to store failed, kept in memory only";
+    }
+    LabelIndex::Ptr labels = std::atomic_load(&labels_);
+    if (!labels) {
+        if (stored) return;
+        // the store misses these from now on: index what it has once, memory holds the rest
+        labels = LabelIndex::Build(label_store_->ReadAll());
+    } else if (list.empty()) {
+        return;
+    }
+    std::atomic_store(&labels_, labels->With(std::move(list)));
+}
+
+void GlSpecViewport::query_labels(double start, double end, std::vector<audio_label>& out) const {
+    LabelIndex::Ptr labels = std::atomic_load(&labels_);
+    if (!labels) {
+        std::lock_guard<std::mutex> lk(mtx_ws_dl_);
+        labels = std::atomic_load(&labels_);
+        if (!labels) {
+            label_store_->Query(start, end, out);
+            return;
+        }
+    }
+    labels->Query(start, end, out);
+}
+
+void GlSpecViewport::kick_labels() {
+    scheduler_->Submit(JobScheduler::Labels, "labels", [this] { labels_job(); });
+}
+
+bool GlSpecViewport::importLabels(const QString& path) {
+    std::vector<audio_label> list;
+    if (!LabelFile::Read(path.toStdString(), list)) {
+        qWarning() << "labels: cannot read" << path;
+        return false;
+    }
+    add_labels(std::move(list), 0.0);
+    kick_labels();
+    return true;
+}
+
+bool GlSpecViewport::exportLabels(const QString& path) const {
+    LabelIndex::Ptr labels = std::atomic_load(&labels_);
+    if (!labels) {
+        // start order like the index keeps them; an export reads every label anyway
+        std::vector<audio_label> all;
+        {
+            std::lock_guard<std::mutex> lk(mtx_ws_dl_);
+            labels = std::atomic_load(&labels_);
+            if (!labels) all = label_store_->ReadAll();
+        }
+        if (!labels) labels = LabelIndex::Build(std::move(all));
+    }
+    if (!LabelFile::Write(path.toStdString(), labels->Labels())) {
+        qWarning() << "labels: cannot write" << path;
+        return false;
+    }
+    return true;
+}
+
 void GlSpecViewport::on_played_sec(double sec) {
     // qDebug() << "asss:" << std::to_string(sec).c_str();
     ///*
@@ -192,6 +319,22 @@ void GlSpecViewport::on_played_sec(double sec) {
         current_sec = job_start_;
         viewport_sec_ = this->viewport_sec_;
     }
+    if (spec_ring_mode_ && view_mode == ViewSignalDataMode::Mel_Spectrogram && !is_video) {
+        // follow the playhead every tick (kept a quarter into the view); the ring only
+        // computes the few columns each step exposes
+        const double follow = std::max(0.0, sec - viewport_sec_ * 0.25);
+        QMetaObject::invokeMethod(this, [this, follow, viewport_sec_] {
+                const int scale = std::max(1, scroll_bar->property("timeScale").toInt());
+                {
+                    const QSignalBlocker b(*scroll_bar);   // no snapping through setScrollX
+                    scroll_bar->setValue(int(follow * scale));
+                }
+                request_window(follow);
+                setTimelineStart(follow, viewport_sec_);
+            }, Qt::QueuedConnection);
+        return;
+    }
+
     double end = current_sec + viewport_sec_;
     if (sec < current_sec || sec > end) {
 
@@ -202,7 +345,7 @@ void GlSpecViewport::on_played_sec(double sec) {
                 // now on GUI thread
                 scroll_bar->setValue(px_sec);
                 request_window(px_sec);
-                labelsView->setStartSec(px_sec, viewport_sec_);
+                setTimelineStart(px_sec, viewport_sec_);
 
             }, Qt::QueuedConnection);
     }
@@ -212,19 +355,15 @@ void GlSpecViewport::on_played_sec(double sec) {
 
 void GlSpecViewport::on_ws_message(const std::string &m) {
 
-    std::vector<audio_label> list_current_label;
-    {
-        std::unique_lock<std::mutex> lk(mtx_ws_dl_);
-        list_current_label = this->list_label;
-    }
-
     // qDebug() << "GlSpecViewport:" << m.c_str();
     auto j = nlohmann::json::parse(m);
     if (j.is_discarded()) {
         return;
     }
     if (j.contains("op") && j["op"].is_string() && j["op"] == "job_done") {
+        std::vector<audio_label> list_new_label;
         auto list_j = j["result"];
+        list_new_label.reserve(list_j.size());
         for (std::size_t i = 0; i < list_j.size(); ++i) {
             const auto& obj = list_j[i];
             double start = obj.value("start", 0.0);
@@ -234,17 +373,16 @@ void GlSpecViewport::on_ws_message(const std::string &m) {
 
             // qDebug() << "dl: " << std::to_string(i).c_str() << ": " << std::to_string(start).c_str() << " = " << value.c_str();
 
-            list_current_label.push_back({ start, end, value });
-        }
-        {
-            std::unique_lock<std::mutex> lk(mtx_ws_dl_);
-            this->list_label = list_current_label;
+            list_new_label.push_back({ start, end, value });
         }
+        double covered = 0.0;
         {
-            std::lock_guard<std::mutex> lk(mtx_);
-            has_job_lbl_ = true;
+            // the DL worker moved past the window this result is for
+            std::lock_guard<std::mutex> lk(mtx_dl_);
+            covered = job_start_dl_;
         }
-        cv_lbl_.notify_one();
+        add_labels(std::move(list_new_label), covered);
+        kick_labels();
 
 
         ////
@@ -256,74 +394,84 @@ void GlSpecViewport::on_ws_message(const std::string &m) {
             std::lock_guard<std::mutex> lk(mtx_dl_);
             start = job_start_dl_;
             duration_sec = this->duration_sec_;
-            if (start < duration_sec) {
-                // std::cout << "v dl:" << std::to_string(job_start_dl_).c_str();
-                has_job_lbl_dl_ = true;
-            }
         }
         if (start < duration_sec) {
             // std::cout << "v dl:" << std::to_string(job_start_dl_).c_str();
-            cv_dl_.notify_one();
+            kick_dl();
         }
     }
 
 }
 
-void GlSpecViewport::worker_audio_dl_loop() {
+// One DL window from job_start_dl_; the next one is kicked when its result comes back
+// (on_ws_message), so at most one window is in flight.
+void GlSpecViewport::dl_job() {
     const double viewport_sec = 5.0;
-    while(!quit_dl_) {
-        MediaObj::Audio audio_obj;
-        double start = 0.0;
-        {
-            std::unique_lock<std::mutex> lk(mtx_dl_);
-            cv_dl_.wait(lk, [&]{ return quit_dl_ || has_job_lbl_dl_; });
-            if (quit_dl_) break;
-
-            audio_obj = this->audio_obj;
-            start = job_start_dl_;
-            // qDebug() << "s:" << std::to_string(start).c_str();
-
-            has_job_lbl_dl_ = false;
+    MediaObj::Audio audio_obj;
+    double start = 0.0;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        audio_obj = this->audio_obj;
+    }
+    {
+        std::unique_lock<std::mutex> lk(mtx_dl_);
+        start = job_start_dl_;
+        // qDebug() << "s:" << std::to_string(start).c_str();
+    }
+    if (start >= duration_sec_) return;
+    double remaining = duration_sec_ - start;
+    double duration_viewport_sec = std::min(viewport_sec, remaining);
+
+    Signal audio;
+    if (!is_video) {
+        if (audio_obj.path != dl_resampler_path_) {
+            dl_resampler_.reset();
+            dl_resampler_path_ = audio_obj.path;
         }
-        double remaining = duration_sec_ - start;
-        double duration_viewport_sec = std::min(viewport_sec, remaining);
-
-        Signal audio;
-        if (!is_video) {
-            audio = raiden::audio::load(
-                audio_obj.path, target_sr_, false, float(start), duration_viewport_sec);
+        // export windows run back to back, so the sinc state is primed once per file
+        std::shared_ptr<raiden::SignalReader> reader = std::atomic_load(&signal_reader_);
+        if (reader && reader->path() == audio_obj.path) {
+            audio = reader->read(float(start), float(duration_viewport_sec), target_sr_, &dl_resampler_);
         } else {
-            AudioBufferU8 audio_buffer = ffmpeg_reader_dl->media_load_audio_buffer(start, duration_viewport_sec);
-            if (audio_buffer.sample_rate > 0) {
-                audio = raiden::audio::loadBufferToWaveMono(audio_buffer.data, audio_buffer.sample_rate);
-            }
+            audio = raiden::audio::loadStream(
+                audio_obj.path, dl_resampler_, target_sr_, false, float(start), float(duration_viewport_sec));
+        }
+    } else {
+        AudioBufferU8 audio_buffer = ffmpeg_reader_dl->media_load_audio_buffer(start, duration_viewport_sec);
+        if (audio_buffer.sample_rate > 0) {
+            audio = raiden::audio::loadBufferToWaveMono(audio_buffer.data, audio_buffer.sample_rate);
         }
-        if (!audio.data.empty()) {
-            SpectrogramTileOverlap melSpec = raiden::tools::loadMelOverlap(audio.data, target_sr_, n_fft, n_hop, 128, 0.0f, -1.0f, 0.5f, 0.0, false);
-            //qDebug() << "Mel:" << std::to_string(melSpec.height).c_str() << "x" << std::to_string(melSpec.width).c_str();
+    }
+    if (!audio.data.empty()) {
+        SpectrogramTileOverlap melSpec;
+        if (spec_window_mode_ == SpecWindowMode::Direct) {
+            melSpec = raiden::tools::loadMelDirect(audio.data, target_sr_, n_fft, n_hop, 128, 0.0f, -1.0f, false);
+        } else {
+            melSpec = raiden::tools::loadMelOverlap(audio.data, target_sr_, n_fft, n_hop, 128, 0.0f, -1.0f, 0.5f, 0.0, false);
+        }
+        //qDebug() << "Mel:" << std::to_string(melSpec.height).c_str() << "x" << std::to_string(melSpec.width).c_str();
 
-            if (melSpec.height > 0 && melSpec.width > 0) {
-                SpectrogramByte byteImg = raiden::tools::flatMatrixToByteImg(melSpec.spectrogram.data,
-                                                                              melSpec.spectrogram.height,
-                                                                              melSpec.spectrogram.width,
-                                                                              "_current_whole_" + std::to_string(10), true);
+        if (melSpec.spectrogram.height > 0 && melSpec.spectrogram.width > 0) {
+            SpectrogramByte byteImg = raiden::tools::flatMatrixToByteImg(melSpec.spectrogram.data,
+                                                                          melSpec.spectrogram.height,
+                                                                          melSpec.spectrogram.width,
+                                                                          "_current_whole_" + std::to_string(10), true);
 
-                SpecApi::uploadSpectrogramPNG("http://192.168.1.131/raid/api/spec", byteImg.data, byteImg.width,
-                                                  byteImg.height, "fakrul_dev", "spec.png");
+            SpecApi::uploadSpectrogramPNG("http://192.168.1.131/raid/api/spec", byteImg.data, byteImg.width,
+                                              byteImg.height, "fakrul_dev", "spec.png");
 
-                if (client) {
-                    client->send_with_time(start, viewport_sec);
-                }
-                start += viewport_sec;
-                //qDebug() << "c2 viewprt dl: " << std::to_string(duration_viewport_sec).c_str() << "~" << std::to_string(start).c_str() << "-" <<
-                //    std::to_string(remaining).c_str();
+            if (client) {
+                client->send_with_time(start, viewport_sec);
             }
+            start += viewport_sec;
+            //qDebug() << "c2 viewprt dl: " << std::to_string(duration_viewport_sec).c_str() << "~" << std::to_string(start).c_str() << "-" <<
+            //    std::to_string(remaining).c_str();
         }
+    }
 
-        {
-            std::lock_guard<std::mutex> lk(mtx_);
-            job_start_dl_ = start;
-        }
+    {
+        std::lock_guard<std::mutex> lk(mtx_dl_);
+        job_start_dl_ = start;
     }
 }
 
@@ -339,11 +487,26 @@ void GlSpecViewport::setSignalViewMode(const ViewSignalDataMode& view_mode, cons
     }
 
     this->view_mode = view_mode;
+    spec_ring_reset_ = true;
     if (isChange) {
         request_window(job_start_);
     }
 }
 
+void GlSpecViewport::setSpecDbRange(float min_db, float max_db, float contrast) {
+    if (gl_frame) gl_frame->setSpecDbRange(min_db, max_db, contrast);
+}
+
+void GlSpecViewport::setSpecRingMode(bool on) {
+    spec_ring_mode_ = on;
+    spec_ring_reset_ = true;
+    if (view_mode == ViewSignalDataMode::Mel_Spectrogram) request_window(job_start_);
+}
+
+void GlSpecViewport::setSpecSmooth(bool smooth) {
+    if (gl_frame) gl_frame->setSpecSmooth(smooth);
+}
+
 void GlSpecViewport::setScrollX(int px) {
     const int scale     = std::max(1, scroll_bar->property("timeScale").toInt());
     const int stepTicks = std::max(1, scroll_bar->property("timeStepTicks").toInt());
@@ -358,7 +521,7 @@ void GlSpecViewport::setScrollX(int px) {
     const double startSec = double(snapped) / double(scale);
     // gl_frame->setViewStartSeconds(startSec);
 
-    labelsView->setStartSec(startSec, viewport_sec_);
+    setTimelineStart(startSec, viewport_sec_);
     request_window(startSec);
 }
 
@@ -413,80 +576,135 @@ void GlSpecViewport::request_window(float start) {
 
     //qDebug() << "Start: " << std::to_string(start).c_str();
 
-    ///*
-    {
-        std::lock_guard<std::mutex> lk(mtx_);
-        job_start_ = start;
-        pWidthGlFrame = gl_frame->viewportWidthPx();
-        has_job_ = true; // coalesce rapid changes
+    // waveform zoomed out past the finest pyramid level: the GPU draws it from the uploaded
+    // peaks, so scrolling is a uniform update and the worker is not woken
+    std::shared_ptr<const raiden::AudioFeatures> features = std::atomic_load(&features_);
+    wave_gpu_view_ = false;
+    if (view_mode == ViewSignalDataMode::WaveForm && !is_video && features && gl_frame->hasWavePeaks()) {
+        const int sr = features->peaks.sampleRate();
+        float gain = 1.0f;
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            if (global_peak_ > 0.0f) gain = 1.0f / global_peak_;
+        }
+        if (sr > 0 && gl_frame->setViewWavGpu(int64_t(std::llround(double(start) * sr)),
+                                              int64_t(std::llround(viewport_sec_ * sr)), gain)) {
+            wave_gpu_view_ = true;
+            {
+                std::lock_guard<std::mutex> lk(mtx_);
+                job_start_ = start;
+            }
+            scheduler_->Cancel("view"); // a queued CPU window would only be dropped
+        }
+    }
+
+    // spectrogram window still resident (video, or the ring is off): switch textures, no recompute
+    bool spec_cached = false;
+    if (view_mode == ViewSignalDataMode::Mel_Spectrogram && (is_video || !spec_ring_mode_)) {
+        SpecCacheKey key;
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            key = spec_cache_key(start);
+        }
+        if (gl_frame->showCachedSpec(key)) {
+            spec_cached = true;
+            {
+                std::lock_guard<std::mutex> lk(mtx_);
+                job_start_ = start;
+            }
+            scheduler_->Cancel("view");
+            kick_prefetch(start + viewport_sec_);
+        }
+    }
+
+    if (!wave_gpu_view_ && !spec_cached) {
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            job_start_ = start;
+            pWidthGlFrame = gl_frame->viewportWidthPx();
+        }
+        kick_view(); // coalesce rapid changes
     }
-    cv_.notify_one();
-    //*/
 
     ///*
     {
         std::unique_lock<std::mutex> lk(mtx_lbl_);
         job_start_lbl_ = start;
-        has_job_lbl_ = true;
     }
-    cv_lbl_.notify_one();
+    kick_labels();
     //*/
 }
 
+void GlSpecViewport::kick_view() {
+    scheduler_->Submit(JobScheduler::Interactive, "view", [this] { view_job(); });
+}
 
-//////////////////////////
+void GlSpecViewport::kick_dl() {
+    scheduler_->Submit(JobScheduler::Background, "dl", [this] { dl_job(); });
+}
 
-void GlSpecViewport::worker_audio_lbl_loop() {
-    while(!quit_lbl_) {
-        std::vector<audio_label> list_label;
-        double start = 0.0;
-        double viewport_sec_;
-        {
-            std::unique_lock<std::mutex> lk(mtx_lbl_);
-            cv_lbl_.wait(lk, [&]{return quit_lbl_ || has_job_lbl_;});
-            if (quit_lbl_) break;
-
-            start = job_start_lbl_;
-            viewport_sec_ = this->viewport_sec_;
-            list_label = this->list_label;
-            has_job_lbl_ = false;
-        }
 
-        std::vector<audio_label> list_usage_label_import;
-        //list_usage_label_import = list_label;
-        const double end = start + viewport_sec_;
+//////////////////////////
 
-        list_usage_label_import.reserve(list_label.size());
-        for (const auto& a : list_label) {
-            // qDebug() << "lbl: " << std::to_string(a.start).c_str() << " = " << a.label.c_str();
-            if (a.end > start && a.start < end) {
-                list_usage_label_import.push_back(a);
-            }
-        }
+void GlSpecViewport::labels_job() {
+    double start = 0.0;
+    double viewport_sec_;
+    {
+        std::unique_lock<std::mutex> lk(mtx_lbl_);
+        start = job_start_lbl_;
+        viewport_sec_ = this->viewport_sec_;
+    }
 
-        {
-            std::lock_guard<std::mutex> lk(mtx_);
-            this->list_usage_label.swap(list_usage_label_import);
-        }
-        emit labelsUiKick();
+    // the index snapshot or the mapped store, nothing copied but the hits
+    std::vector<audio_label> list_usage_label_import;
+    query_labels(start, start + viewport_sec_, list_usage_label_import);
+
+    {
+        std::lock_guard<std::mutex> lk(mtx_lbl_);
+        this->list_usage_label.swap(list_usage_label_import);
     }
+    emit labelsUiKick();
 }
 
 void GlSpecViewport::on_receive_audio_label() {
-    std::vector<audio_label> list_usage_label;
+    std::vector<LabelSpan> spans;
     {
         std::unique_lock<std::mutex> lk(mtx_lbl_);
-        list_usage_label = this->list_usage_label;
+        spans.reserve(this->list_usage_label.size());
+        for (const audio_label& a : this->list_usage_label) {
+            spans.push_back({a.start, a.end, QString::fromStdString(a.label)});
+        }
+    }
+    shown_labels_.swap(spans);
+    if (gl_timeline_) {
+        gl_frame->setTimelineLabels(shown_labels_);
+    } else {
+        // rebinds the pooled items, nothing is deleted or created per update
+        labelsView->setLabels(shown_labels_);
     }
+}
 
-    for (auto& l : list_ui_label) {
-        delete l.span;
+void GlSpecViewport::setTimelineStart(double sec, double viewport_sec) {
+    timeline_start_sec_ = sec;
+    if (gl_timeline_) {
+        gl_frame->setTimelineView(sec, viewport_sec);
+    } else {
+        labelsView->setStartSec(sec, viewport_sec);
     }
-    list_ui_label.clear();
+}
 
-    for (int i = 0; i < list_usage_label.size(); i++) {
-        audio_label a = list_usage_label[i];
-        list_ui_label.push_back({a, labelsView->addSpan(a.start, a.end, QString::fromStdString(a.label))});
+void GlSpecViewport::setGlTimeline(bool on) {
+    if (on == gl_timeline_ || !gl_frame || !labelsView) return;
+    gl_timeline_ = on;
+    gl_frame->setTimelineOverlay(on);
+    labelsView->setVisible(!on);
+    // the side that was off missed the updates meanwhile
+    if (on) {
+        gl_frame->setTimelineView(timeline_start_sec_, viewport_sec_);
+        gl_frame->setTimelineLabels(shown_labels_);
+    } else {
+        labelsView->setStartSec(timeline_start_sec_, viewport_sec_);
+        labelsView->setLabels(shown_labels_);
     }
 }
 
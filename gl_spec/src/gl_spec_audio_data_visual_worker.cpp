@@ -2,132 +2,383 @@
 #include<QDebug>
 #include <QThread>
 
+#include <algorithm>
+#include <cmath>
+
 #include "tools.h"
 
-void GlSpecViewport::worker_loop() {
-    while (!quit_) {
-        MediaObj::Audio audio_obj;
-        double start = 0.0;
-        float viewport_sec_;
-        float global_peak;
-        int pWidthGlFrame;
-        int target_sr_;
-        std::vector<SpecViewPort> list_view_port;
-        {
-            std::unique_lock<std::mutex> lk(mtx_);
-            cv_.wait(lk, [&]{ return quit_ || has_job_; });
-            if (quit_) break;
-
-            audio_obj = this->audio_obj;
-            start = job_start_;
-            target_sr_ = this->target_sr_;
-            viewport_sec_ = this->viewport_sec_;
-            pWidthGlFrame = this->pWidthGlFrame;
-            global_peak = global_peak_;
-            list_view_port = this->list_view_port;
-
-            has_job_ = false;
-        }
-        //qDebug() << "Extracting: " << std::to_string(job_start_).c_str();
-        auto listSpecViewPortNdc = raiden::audio::project_visible_segments_to_ndc(list_view_port,
-                                                                                  start, viewport_sec_);
-
-        Signal audio;
-        if (!is_video) {
-            audio = raiden::audio::load(
-                audio_obj.path, target_sr_, false, float(start), float(viewport_sec_));
-        } else {
-            AudioBufferU8 audio_buffer = ffmpeg_reader->media_load_audio_buffer(start, viewport_sec_);
-            // qDebug() << std::to_string(audio_buffer.sample_rate).c_str();
-            if (audio_buffer.sample_rate > 0) {
-                audio = raiden::audio::loadBufferToWaveMono(audio_buffer.data, audio_buffer.sample_rate);
+// One window for the view at job_start_ as it is when the job runs, so a burst of scroll
+// events costs one computation (the scheduler keeps only the latest queued "view" job).
+void GlSpecViewport::view_job() {
+    MediaObj::Audio audio_obj;
+    double start = 0.0;
+    float viewport_sec_;
+    float global_peak;
+    int pWidthGlFrame;
+    int target_sr_;
+    std::vector<SpecViewPort> list_view_port;
+    SpecCacheKey spec_key;
+    {
+        std::unique_lock<std::mutex> lk(mtx_);
+        audio_obj = this->audio_obj;
+        start = job_start_;
+        target_sr_ = this->target_sr_;
+        viewport_sec_ = this->viewport_sec_;
+        pWidthGlFrame = this->pWidthGlFrame;
+        global_peak = global_peak_;
+        list_view_port = this->list_view_port;
+        spec_key = spec_cache_key(start);
+    }
+    //qDebug() << "Extracting: " << std::to_string(job_start_).c_str();
+    auto listSpecViewPortNdc = raiden::audio::project_visible_segments_to_ndc(list_view_port,
+                                                                              start, viewport_sec_);
+
+    // zoomed out far enough: the envelope comes straight from the peak index, no decode
+    std::shared_ptr<const raiden::AudioFeatures> features = std::atomic_load(&features_);
+    if (!is_video && view_mode == ViewSignalDataMode::WaveForm && features && features->sr > 0) {
+        SignalAdaptGl signAdaptGl = raiden::audio::project_visible_adapt_wave(
+            features->peaks, start, viewport_sec_, pWidthGlFrame, global_peak);
+        if (signAdaptGl.gl_draw_count > 0) {
+            signAdaptGl.rms_band = raiden::audio::project_feature_band(
+                features->rms, features->hop, features->sr, start, viewport_sec_, global_peak);
+            {
+                std::lock_guard<std::mutex> lk(mtx_);
+                curr_wave_data.clear();
+                list_view_port_ndc.swap(listSpecViewPortNdc);
+                currSignAdaptGl = std::make_shared<const SignalAdaptGl>(std::move(signAdaptGl));
             }
+            emit glUiKick();
+            return;
         }
-        // qWarning() << "empty audio"; continue;
-        if (!audio.data.empty()) {
-            if (target_sr_ <= 0 || n_fft <= 0 || n_hop <= 0) {
-                qWarning() << "bad params sr/fft/hop:" << target_sr_ << n_fft << n_hop;
-                continue;
-            }
-            if (int(audio.data.size()) < n_fft) {
-                qWarning() << "clip shorter than n_fft; skipping. N=" << int(audio.data.size());
-                continue;
+    }
+
+    Signal audio;
+    if (!is_video) {
+        if (audio_obj.path != display_resampler_path_) {
+            display_resampler_.reset();
+            display_resampler_path_ = audio_obj.path;
+        }
+        std::shared_ptr<raiden::SignalReader> reader = std::atomic_load(&signal_reader_);
+        if (reader && reader->path() == audio_obj.path && spec_ring_mode_
+            && view_mode == ViewSignalDataMode::Mel_Spectrogram
+            && spec_ring_step(*reader, start, viewport_sec_, target_sr_)) {
+            return;
+        }
+        if (reader && reader->path() == audio_obj.path) {
+            audio = reader->read(float(start), float(viewport_sec_), target_sr_, &display_resampler_);
+        } else {
+            audio = raiden::audio::loadStream(
+                audio_obj.path, display_resampler_, target_sr_, false, float(start), float(viewport_sec_));
+        }
+    } else {
+        AudioBufferU8 audio_buffer = ffmpeg_reader->media_load_audio_buffer(start, viewport_sec_);
+        // qDebug() << std::to_string(audio_buffer.sample_rate).c_str();
+        if (audio_buffer.sample_rate > 0) {
+            audio = raiden::audio::loadBufferToWaveMono(audio_buffer.data, audio_buffer.sample_rate);
+        }
+    }
+    // qWarning() << "empty audio"; continue;
+    if (!audio.data.empty()) {
+        if (target_sr_ <= 0 || n_fft <= 0 || n_hop <= 0) {
+            qWarning() << "bad params sr/fft/hop:" << target_sr_ << n_fft << n_hop;
+            return;
+        }
+        if (int(audio.data.size()) < mel_min_samples()) {
+            qWarning() << "clip too short for the spectrogram; skipping. N=" << int(audio.data.size());
+            return;
+        }
+        SignalAdaptGl signAdaptGl;
+        SpectrogramQ melSpecQ;
+
+        switch (view_mode) {
+        case ViewSignalDataMode::Mel_Spectrogram:
+            melSpecQ = mel_window(audio.data, target_sr_, spec_key.ref_power);
+            break;
+        default:
+        case ViewSignalDataMode::WaveForm:
+            signAdaptGl = raiden::audio::project_visible_adapt_wave(audio.data, pWidthGlFrame, global_peak);
+            // RMS overlay straight from the precomputed features, no rescan of the window
+            if (features && features->sr > 0) {
+                signAdaptGl.rms_band = raiden::audio::project_feature_band(
+                    features->rms, features->hop, features->sr, start, viewport_sec_, global_peak);
             }
-            SignalAdaptGl signAdaptGl;
-            SpectrogramTileOverlap melSpec;
+            break;
+        }
 
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
             switch (view_mode) {
             case ViewSignalDataMode::Mel_Spectrogram:
-                melSpec = raiden::tools::loadMelOverlap(audio.data, target_sr_, n_fft, n_hop, 128);
+                this->melSpecQ = std::move(melSpecQ);
+                this->melSpecKey = spec_key;
                 break;
             default:
             case ViewSignalDataMode::WaveForm:
-                signAdaptGl = raiden::audio::project_visible_adapt_wave(audio.data, pWidthGlFrame, global_peak);
+                curr_wave_data.swap(audio.data);
+                list_view_port_ndc.swap(listSpecViewPortNdc);
+                currSignAdaptGl = std::make_shared<const SignalAdaptGl>(std::move(signAdaptGl));
                 break;
             }
+        }
+        emit glUiKick();
+        // paging forward or playing hits the next window next
+        if (view_mode == ViewSignalDataMode::Mel_Spectrogram) kick_prefetch(start + viewport_sec_);
+    }
+}
 
-            {
-                std::lock_guard<std::mutex> lk(mtx_);
-                switch (view_mode) {
-                case ViewSignalDataMode::Mel_Spectrogram:
-                    this->melSpec = std::move(melSpec);
-                    break;
-                default:
-                case ViewSignalDataMode::WaveForm:
-                    curr_wave_data.swap(audio.data);
-                    list_view_port_ndc.swap(listSpecViewPortNdc);
-                    currSignAdaptGl = std::move(signAdaptGl);
-                    break;
-                }
-            }
-            emit glUiKick();
+SpectrogramQ GlSpecViewport::mel_window(const std::vector<float>& samples, int sr, float ref_power) {
+    // keep dB here; the [-80, 0] -> colour mapping happens in the shader
+    SpectrogramTileOverlap melSpec;
+    const bool direct = spec_window_mode_ == SpecWindowMode::Direct;
+    if (direct) {
+        melSpec = raiden::tools::loadMelDirect(samples, sr, n_fft, n_hop, 128, 0.0f, -1.0f, false, false, ref_power);
+    } else {
+        melSpec = raiden::tools::loadMelOverlap(samples, sr, n_fft, n_hop, 128,
+                                                0.0f, -1.0f, 0.5f, 0.5f, false, false, ref_power);
+    }
+    // native columns x mels; GL sampling does the magnification
+    SpectrogramQ q = raiden::tools::quantizeSpectrogram(melSpec.spectrogram.data,
+                                                        melSpec.spectrogram.width,
+                                                        melSpec.spectrogram.height,
+                                                        spec_sample_format_);
+    ++mel_windows_;
+    mel_upload_bytes_ += q.data.size();
+    if (direct) {
+        const int overlap_fft = raiden::tools::countOverlapFft(int(samples.size()), sr, n_hop);
+        mel_direct_fft_ += uint64_t(melSpec.fft_count);
+        mel_saved_fft_ += uint64_t(std::max(0, overlap_fft - melSpec.fft_count));
+    }
+    return q;
+}
+
+GlSpecViewport::MelWindowStats GlSpecViewport::melWindowStats() const {
+    MelWindowStats st;
+    st.windows = mel_windows_;
+    st.upload_bytes = mel_upload_bytes_;
+    st.direct_fft = mel_direct_fft_;
+    st.saved_fft = mel_saved_fft_;
+    return st;
+}
+
+void GlSpecViewport::kick_prefetch(double start) {
+    // the ring already computes only what scrolls in
+    if (!is_video && spec_ring_mode_) return;
+    if (start >= duration_sec_ || start + viewport_sec_ > duration_sec_ + 1e-6) return;
+    {
+        // both the view job and a cache hit ask for the same next window
+        std::lock_guard<std::mutex> lk(mtx_);
+        const SpecCacheKey key = spec_cache_key(start);
+        if (key == prefetch_key_) return;
+        prefetch_key_ = key;
+    }
+    scheduler_->Submit(JobScheduler::Prefetch, "prefetch", [this, start] { prefetch_job(start); });
+}
+
+// Same window as view_job would compute for start, only parked in the texture cache; the
+// view picks it up when request_window lands there (showCachedSpec).
+void GlSpecViewport::prefetch_job(double start) {
+    MediaObj::Audio audio_obj;
+    SpecCacheKey key;
+    int target_sr;
+    float viewport_sec;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        if (view_mode != ViewSignalDataMode::Mel_Spectrogram) return;
+        audio_obj = this->audio_obj;
+        key = spec_cache_key(start);
+        target_sr = target_sr_;
+        viewport_sec = viewport_sec_;
+    }
+
+    Signal audio;
+    if (!is_video) {
+        std::shared_ptr<raiden::SignalReader> reader = std::atomic_load(&signal_reader_);
+        if (!reader || reader->path() != audio_obj.path) return;
+        if (audio_obj.path != prefetch_resampler_path_) {
+            prefetch_resampler_.reset();
+            prefetch_resampler_path_ = audio_obj.path;
+        }
+        audio = reader->read(float(start), viewport_sec, target_sr, &prefetch_resampler_);
+    } else {
+        AudioBufferU8 audio_buffer = ffmpeg_reader_prefetch->media_load_audio_buffer(start, viewport_sec);
+        if (audio_buffer.sample_rate > 0) {
+            audio = raiden::audio::loadBufferToWaveMono(audio_buffer.data, audio_buffer.sample_rate);
+        }
+    }
+    if (target_sr <= 0 || n_fft <= 0 || n_hop <= 0 || int(audio.data.size()) < mel_min_samples()) return;
+
+    SpectrogramQ q = mel_window(audio.data, target_sr, key.ref_power);
+    if (q.data.empty()) return;
+    QMetaObject::invokeMethod(this, [this, key, q] {
+            // no-op when the view got there first
+            gl_frame->cacheSpec(key, q);
+        }, Qt::QueuedConnection);
+}
+
+// Ring spectrogram step for the window at `start`: computes only the hop frames the ring does
+// not hold yet (on the absolute frame grid, so batches from separate calls line up), queues them
+// for the GUI thread and returns true. Jumps past the ring, a new file, a new view width or sample
+// format rebuild it.
+bool GlSpecViewport::spec_ring_step(raiden::SignalReader& reader, double start, double view_sec, int sr) {
+    if (sr <= 0 || n_hop <= 0 || n_fft <= 0 || view_sec <= 0.0) return false;
+
+    const double fps = double(sr) / double(n_hop);
+    const double view_first = start * fps;
+    const double view_frames = view_sec * fps;
+    const int64_t f0 = int64_t(std::floor(view_first));
+    const int64_t f1 = int64_t(std::ceil(view_first + view_frames)) + 1;
+    const int width = int(std::ceil(view_frames)) + 2 * kSpecRingMargin;
+    const float ref_power = spec_ref_power();
+
+    // the reference only moves when the file's peak comes in: one rebuild, then columns line up again
+    bool reset = spec_ring_reset_.exchange(false) || spec_ring_.path != reader.path()
+                 || spec_ring_.width != width || spec_ring_.format != spec_sample_format_
+                 || spec_ring_.ref_power != ref_power;
+    int64_t a = f0, b = f0;
+    bool forward = true;
+    if (!reset) {
+        if (f0 >= spec_ring_.lo && f1 <= spec_ring_.hi) {
+            // already resident, only the view moves
+        } else if (f0 >= spec_ring_.lo && f0 <= spec_ring_.hi) {
+            a = spec_ring_.hi; b = f1;
+        } else if (f1 >= spec_ring_.lo && f1 <= spec_ring_.hi) {
+            a = f0; b = spec_ring_.lo; forward = false;
         } else {
-            {
-                std::lock_guard<std::mutex> lk(mtx_);
-                has_job_ = false;
+            reset = true;
+        }
+    }
+    if (reset) {
+        spec_ring_ = SpecRingState();
+        spec_ring_.path = reader.path();
+        spec_ring_.width = width;
+        spec_ring_.format = spec_sample_format_;
+        spec_ring_.ref_power = ref_power;
+        spec_ring_.lo = spec_ring_.hi = f0;
+        a = f0; b = f1;
+    }
+
+    SpecRingUpdate up;
+    up.reset = reset;
+    up.width = width;
+    up.first_frame = a;
+    up.view_first = view_first;
+    up.view_frames = view_frames;
+    if (b > a) {
+        // enough samples around [a, b) that every frame sees its full n_fft support
+        const int pad = (n_fft / 2 + n_hop - 1) / n_hop;
+        const int64_t ws = std::max<int64_t>(0, a - pad);
+        Signal sig = reader.readSamples(ws * n_hop, (b - ws + pad) * n_hop, sr, &display_resampler_);
+        Spectrogram cols = raiden::tools::loadMelFrames(sig.data, sr, n_fft, n_hop, 128,
+                                                       int(a - ws), int(b - a), ref_power);
+        if (cols.width > 0) {
+            up.cols = raiden::tools::quantizeSpectrogram(cols.data, cols.width, cols.height, spec_sample_format_);
+            b = a + cols.width;   // shorter at the end of the file
+            if (forward) {
+                spec_ring_.hi = std::max(spec_ring_.hi, b);
+                spec_ring_.lo = std::max(spec_ring_.lo, spec_ring_.hi - width);
+                if (reset) spec_ring_.lo = a;
+            } else {
+                spec_ring_.lo = a;
+                spec_ring_.hi = std::min(spec_ring_.hi, a + width);
             }
+        } else if (reset) {
+            return false;   // nothing to show (end of file); let the plain path deal with it
         }
     }
+
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        if (up.reset) spec_ring_pending_.clear();
+        spec_ring_pending_.push_back(std::move(up));
+        melSpecQ = SpectrogramQ();   // so a later kick does not bring back the full-window texture
+    }
+    emit glUiKick();
+    return true;
+}
+
+SpecCacheKey GlSpecViewport::spec_cache_key(double start) const {
+    SpecCacheKey k;
+    k.path = audio_obj.path;
+    k.sr = target_sr_;
+    k.start_sample = int64_t(std::llround(start * target_sr_));
+    k.span_samples = int64_t(std::llround(viewport_sec_ * target_sr_));
+    k.n_fft = n_fft;
+    k.n_hop = n_hop;
+    k.n_mels = 128;
+    k.window_mode = spec_window_mode_;
+    k.format = spec_sample_format_;
+    k.ref_power = spec_ref_power();
+    return k;
+}
+
+float GlSpecViewport::spec_ref_power() const {
+    std::shared_ptr<const raiden::AudioFeatures> features = std::atomic_load(&features_);
+    const float peak = features && features->global_peak > 0.0f ? features->global_peak : 1.0f;
+    return raiden::tools::melReferencePower(peak);
 }
 
 void GlSpecViewport::on_new_audio() {
     ViewSignalDataMode view_mode;
     float start = 0.0;
     float viewport_sec = 0.0;
-    std::vector<float> audio;
-    SignalAdaptGl signAdaptGl;
+    std::shared_ptr<const SignalAdaptGl> signAdaptGl;
     std::vector<SpecViewPortNDC> listSegmentWindowNDC;
-    SpectrogramTileOverlap melSpec;
+    SpectrogramQ melSpec;
+    SpecCacheKey melKey;
+    bool melCurrent = false;
+    std::vector<SpecRingUpdate> ringUpdates;
     {
         std::lock_guard<std::mutex> lk(mtx_);
+        ringUpdates.swap(spec_ring_pending_);
         start = static_cast<float>(job_start_);
         view_mode = this->view_mode;
         viewport_sec = static_cast<float>(viewport_sec_);
-        audio = curr_wave_data;
         signAdaptGl = currSignAdaptGl;
         listSegmentWindowNDC = this->list_view_port_ndc;
-        melSpec = this->melSpec;
+        melSpec = this->melSpecQ;
+        melKey = this->melSpecKey;
+        // the view may have moved (or hit the cache) while this window was computed
+        melCurrent = melKey == spec_cache_key(job_start_);
     }
 
     switch(view_mode) {
     case ViewSignalDataMode::Mel_Spectrogram:
+        if (!ringUpdates.empty()) {
+            // queued connection: already on the GUI thread
+            for (const SpecRingUpdate& up : ringUpdates) {
+                if (up.reset) {
+                    gl_frame->resetSpecRing(up.width, up.cols.height, up.cols.format, up.cols.scale, up.cols.offset);
+                }
+                gl_frame->writeSpecRing(up.first_frame, up.cols);
+            }
+            gl_frame->setSpecRingView(ringUpdates.back().view_first, ringUpdates.back().view_frames);
+            break;
+        }
         // qDebug() << "Res: " << std::to_string(melSpec.height).c_str() << "x" << std::to_string(melSpec.width).c_str();
+        if (melSpec.data.empty()) break;
+        // resident from here on, so scrolling back to it is a texture switch (request_window)
         if (QThread::currentThread() != thread()) {
-            QMetaObject::invokeMethod(this, [this, start, viewport_sec, melSpec]{
-                    gl_frame->setViewSpec(start, viewport_sec, melSpec);
+            QMetaObject::invokeMethod(this, [this, melKey, melCurrent, melSpec]{
+                    gl_frame->cacheSpec(melKey, melSpec);
+                    if (melCurrent) gl_frame->showCachedSpec(melKey);
                 }, Qt::QueuedConnection);
         } else {
-            gl_frame->setViewSpec(start, viewport_sec, melSpec);
+            gl_frame->cacheSpec(melKey, melSpec);
+            if (melCurrent) gl_frame->showCachedSpec(melKey);
         }
         break;
     default:
     case ViewSignalDataMode::WaveForm:
+        // late CPU result of a window the GPU path has replaced since
+        if (!signAdaptGl || wave_gpu_view_) break;
         if (QThread::currentThread() != thread()) {
             QMetaObject::invokeMethod(this, [this, start, viewport_sec, signAdaptGl]{
-                    gl_frame->setViewWav(start, viewport_sec, signAdaptGl.gl_draw_count, signAdaptGl.adapt_audio_wave);
+                    gl_frame->setViewWav(start, viewport_sec, signAdaptGl->gl_draw_count, signAdaptGl->adapt_audio_wave,
+                                         signAdaptGl->rms_band);
                 }, Qt::QueuedConnection);
         } else {
-            gl_frame->setViewWav(start, viewport_sec, signAdaptGl.gl_draw_count, signAdaptGl.adapt_audio_wave);
+            gl_frame->setViewWav(start, viewport_sec, signAdaptGl->gl_draw_count, signAdaptGl->adapt_audio_wave,
+                                 signAdaptGl->rms_band);
         }
         break;
     }
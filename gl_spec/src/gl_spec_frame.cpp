@@ -4,10 +4,16 @@
 
 #include <QSurfaceFormat>
 #include <QOpenGLContext>
+#include <QPainter>
 
 #include <QDebug>
+#include <algorithm>
+#include <cmath>
 #include <string>
 
+#include "tools.h"
+#include "gl_state_cache.h"
+
 // Only if you're stuck with C++11
 template<typename T, typename... Args>
 std::unique_ptr<T> make_unique(Args&&... args) {
@@ -49,9 +55,24 @@ void GlSpecViewFrame::cleanup() {
     }
 
     // Destroy ALL objects that might call gl* in their destructors:
+    profiler.reset();
+    timeline.reset();
     shaderWave.reset();
     vaWave.reset();
     vbWave.reset();
+    vaRms.reset();
+    vbRms.reset();
+    texWavePeaks.reset();
+    vaWaveGpu.reset();
+    shaderWaveGpu.reset();
+    texMelSpec.reset();
+    specShown = nullptr;
+    specCache.Clear();
+    texMelRing.reset();
+    shaderMelSpec.reset();
+    ibMelSpec.reset();
+    vaMelSpec.reset();
+    vbMelSpec.reset();
     renderer.reset();
 
     if (needDone && QOpenGLContext::currentContext() == ctx)
@@ -59,26 +80,35 @@ void GlSpecViewFrame::cleanup() {
 
 }
 
-void GlSpecViewFrame::setViewWav(const float& start_sec, const float& view_port_sec, const int& gl_draw_count, const std::vector<float> &draw_data) {
+void GlSpecViewFrame::setViewWav(const float& start_sec, const float& view_port_sec, const int& gl_draw_count, const std::vector<float> &draw_data,
+                                 const std::vector<float> &rms_band) {
 
     this->view_mode = ViewSignalDataMode::WaveForm;
+    this->waveGpu = false;
     this->signalWaveSize = static_cast<int>(draw_data.size());
     this->gl_draw_count = gl_draw_count;
+    this->rmsCount = static_cast<int>(rms_band.size() / 2);
+
+    makeCurrent();
+    GlProfiler::Scope prof(profiler.get(), "wave up");
+    if (!rms_band.empty()) {
+        if (!vaRms) {
+            vaRms = make_unique<VertexArray>();
+            vblRms = make_unique<VertexBufferLayout>();
+            vblRms->Pushs(2);
+            vbRms = make_unique<StreamingVertexBuffer>(vblRms->GetStride(), rms_band.size() * sizeof(GLfloat));
+        }
+        rmsFirst = streamVertices(*vbRms, *vaRms, *vblRms, vaRmsGeneration, rms_band);
+    }
 
     //if (QOpenGLContext::currentContext() == context()) {}
 
     if (!vaWave) {
-        makeCurrent();
-
         vaWave = make_unique<VertexArray>();
-        vbWave = make_unique<VertexBuffer>(
-            draw_data.data(),
-            draw_data.size() * sizeof(GLfloat),
-            GL_DYNAMIC_DRAW
-            );
         vblWave = make_unique<VertexBufferLayout>();
         vblWave->Pushs(2);
-        vaWave->AddBuffer(*vbWave, *vblWave);
+        // grows on its own when a wider window comes in
+        vbWave = make_unique<StreamingVertexBuffer>(vblWave->GetStride(), draw_data.size() * sizeof(GLfloat));
 
         float zoom = 1.0f;        // 1.0 = normal size, >1 = zoom in
         float pan_x = 0.0f;       // left/right pan
@@ -95,92 +125,308 @@ void GlSpecViewFrame::setViewWav(const float& start_sec, const float& view_port_
         shaderWave->Bind();
         shaderWave->SetUniform4f("u_Color", 1.0f, 1.0f, 1.0f, 1.0f);
         shaderWave->SetUniformMat4f("u_MVP", proj);
-
-        vaWave->Unbind();
-        vbWave->Bind();
         shaderWave->Unbind();
+    }
+    waveFirst = streamVertices(*vbWave, *vaWave, *vblWave, vaWaveGeneration, draw_data);
 
-        doneCurrent();
-        update();
+    doneCurrent();
+    update();
+}
+
+GLint GlSpecViewFrame::streamVertices(StreamingVertexBuffer& vb, VertexArray& va, const VertexBufferLayout& layout,
+                                      uint32_t& generation, const std::vector<float>& data) {
+    if (data.empty()) return 0;
+    const GLint first = vb.Write(data.data(), data.size() * sizeof(GLfloat));
+    if (vb.GetGeneration() != generation) {
+        // new buffer object after a grow: point the attributes at it
+        va.AddBuffer(vb, layout);
+        va.Unbind();
+        generation = vb.GetGeneration();
+    }
+    vb.Unbind();
+    return first;
+}
+
+void GlSpecViewFrame::initSpecQuad() {
+    float vertices[] = {
+        // Positions     // UVs
+        -1.0f, -1.0f,    0.0f, 0.0f,
+        1.0f, -1.0f,    1.0f, 0.0f,
+        1.0f,  1.0f,    1.0f, 1.0f,
+        -1.0f,  1.0f,    0.0f, 1.0f,
+    };
+    unsigned int indices[] = {
+        0, 1, 2,
+        2, 3, 0
+    };
+
+    vaMelSpec = make_unique<VertexArray>();
+    vbMelSpec = make_unique<VertexBuffer>(
+        vertices, 4 * 4 * sizeof(float), GL_DYNAMIC_DRAW
+        );
+
+    vblMelSpec = make_unique<VertexBufferLayout>();
+    vblMelSpec->Pushs(2);
+    vblMelSpec->Pushs(2);
+    vaMelSpec->AddBuffer(*vbMelSpec, *vblMelSpec);
+
+    ibMelSpec = make_unique<IndexBuffer>(indices, 6);
+
+    shaderMelSpec = make_unique<Shader>("resources/shader/SpectrogramQuad.shader");
+    shaderMelSpec->Bind();
+    shaderMelSpec->SetUniform1i("u_Colormap", 3);
+    shaderMelSpec->SetUniform1i("u_Texture", 0);  // Texture unit 0
+
+    vaMelSpec->Unbind();
+    vbMelSpec->Unbind();
+    ibMelSpec->Unbind();
+    shaderMelSpec->Unbind();
+}
+
+void GlSpecViewFrame::setViewSpec(const float& start_sec, const float& view_port_sec, const SpectrogramQ& spec) {
+
+    this->view_mode = ViewSignalDataMode::Mel_Spectrogram;
+    if (spec.width <= 0 || spec.height <= 0 || spec.data.empty()) return;
+
+    const TextureFormat texFormat = spec.format == SpecSampleFormat::F16 ? TextureFormat::R16F : TextureFormat::R8;
+    this->specScale = spec.scale;
+    this->specOffset = spec.offset;
+    this->specRing = false;
+    this->specShown = nullptr;
+    specCache.Pin(nullptr);
+
+    makeCurrent();
+    GlProfiler::Scope prof(profiler.get(), "spec up");
+    if (!vaMelSpec) initSpecQuad();
+    if (!texMelSpec) {
+        texMelSpec = make_unique<Texture>(spec.width, spec.height, spec.data.data(), texFormat);
+        texMelSpec->SetFilter(specSmooth ? GL_LINEAR : GL_NEAREST);
+        texMelSpec->Unbind();
     } else {
-        makeCurrent();
+        texMelSpec->updateText(spec.width, spec.height, spec.data.data(), texFormat);
+    }
+    doneCurrent();
+    update();
+}
 
-        vbWave->Bind();
-        GLCall(glBufferSubData(GL_ARRAY_BUFFER, 0, draw_data.size() * sizeof(GLfloat), draw_data.data()));
-        vbWave->Bind();
+void GlSpecViewFrame::cacheSpec(const SpecCacheKey& key, const SpectrogramQ& spec) {
+    if (spec.width <= 0 || spec.height <= 0 || spec.data.empty() || specCache.Contains(key)) return;
+
+    const TextureFormat texFormat = spec.format == SpecSampleFormat::F16 ? TextureFormat::R16F : TextureFormat::R8;
+    makeCurrent();
+    GlProfiler::Scope prof(profiler.get(), "spec up");
+    if (!vaMelSpec) initSpecQuad();
+    SpecTextureCache::Entry e;
+    // a texture of the same size that just fell out takes the texels, no new storage
+    e.tex = specCache.Reserve(spec.width, spec.height, texFormat);
+    if (e.tex) {
+        e.tex->updateText(spec.width, spec.height, spec.data.data(), texFormat);
+    } else {
+        e.tex = make_unique<Texture>(spec.width, spec.height, spec.data.data(), texFormat);
+    }
+    e.tex->Unbind();
+    e.format = texFormat;
+    e.scale = spec.scale;
+    e.offset = spec.offset;
+    e.bytes = size_t(spec.width) * size_t(spec.height) * size_t(Texture::BytesPerPixel(texFormat));
+    specCache.Insert(key, std::move(e));
+    doneCurrent();
+}
 
+bool GlSpecViewFrame::showCachedSpec(const SpecCacheKey& key) {
+    const SpecTextureCache::Entry* e = specCache.Find(key);
+    if (!e) return false;
+
+    this->view_mode = ViewSignalDataMode::Mel_Spectrogram;
+    this->specRing = false;
+    this->specScale = e->scale;
+    this->specOffset = e->offset;
+    if (e != specShown) {
+        specShown = e;
+        specCache.Pin(e);
+        makeCurrent();
+        e->tex->SetFilter(specSmooth ? GL_LINEAR : GL_NEAREST);
         doneCurrent();
-        update();
     }
+    update();
+    return true;
+}
 
+void GlSpecViewFrame::setSpecCacheBudget(size_t bytes, size_t max_entries) {
+    makeCurrent();
+    specCache.SetBudget(bytes, max_entries);
+    doneCurrent();
 }
 
-void GlSpecViewFrame::setViewSpec(const float& start_sec, const float& view_port_sec, const SpectrogramTileOverlap& spec) {
+void GlSpecViewFrame::resetSpecRing(int width, int height, SpecSampleFormat format, float scale, float offset) {
+    if (width <= 0 || height <= 0) return;
 
     this->view_mode = ViewSignalDataMode::Mel_Spectrogram;
-    if (!vaMelSpec) {
-        float vertices[] = {
-            // Positions     // UVs
-            -1.0f, -1.0f,    0.0f, 0.0f,
-            1.0f, -1.0f,    1.0f, 0.0f,
-            1.0f,  1.0f,    1.0f, 1.0f,
-            -1.0f,  1.0f,    0.0f, 1.0f,
-        };
-        unsigned int indices[] = {
-            0, 1, 2,
-            2, 3, 0
-        };
-        makeCurrent();
+    this->specScale = scale;
+    this->specOffset = offset;
+    this->specRing = true;
+    this->specRingWidth = width;
+
+    // empty columns read as the display floor, not as 0 dB
+    const size_t n = size_t(width) * size_t(height);
+    std::vector<uint16_t> fill;
+    TextureFormat texFormat = TextureFormat::R8;
+    if (format == SpecSampleFormat::F16) {
+        texFormat = TextureFormat::R16F;
+        fill.assign(n, raiden::tools::floatToHalf(specMinDb));
+    } else {
+        fill.assign((n + 1) / 2, 0);
+    }
 
-        vaMelSpec = make_unique<VertexArray>();
-        vbMelSpec = make_unique<VertexBuffer>(
-            vertices, 4 * 4 * sizeof(float), GL_DYNAMIC_DRAW
-            );
+    makeCurrent();
+    if (!vaMelSpec) initSpecQuad();
+    if (!texMelRing) {
+        texMelRing = make_unique<Texture>(width, height, static_cast<const void*>(fill.data()), texFormat);
+    } else {
+        texMelRing->updateText(width, height, fill.data(), texFormat);
+    }
+    texMelRing->SetFilter(specSmooth ? GL_LINEAR : GL_NEAREST);
+    texMelRing->SetWrap(GL_REPEAT, GL_CLAMP_TO_EDGE);
+    doneCurrent();
+    update();
+}
 
-        vblMelSpec = make_unique<VertexBufferLayout>();
-        vblMelSpec->Pushs(2);
-        vblMelSpec->Pushs(2);
-        vaMelSpec->AddBuffer(*vbMelSpec, *vblMelSpec);
+void GlSpecViewFrame::writeSpecRing(int64_t first_frame, const SpectrogramQ& cols) {
+    if (!texMelRing || specRingWidth <= 0 || cols.width <= 0 || cols.height != texMelRing->GetHeight()) return;
+
+    // only the last specRingWidth columns can survive anyway
+    int skip = std::max(0, cols.width - specRingWidth);
+    first_frame += skip;
+    const int count = cols.width - skip;
+    const int x0 = int(((first_frame % specRingWidth) + specRingWidth) % specRingWidth);
+    const int part1 = std::min(count, specRingWidth - x0);
+    const uint8_t* base = cols.data.data() + size_t(skip) * size_t(cols.bytesPerSample());
+
+    makeCurrent();
+    GlProfiler::Scope prof(profiler.get(), "spec up");
+    // rows of cols are cols.width texels long; upload in place, splitting at the wrap
+    texMelRing->UpdateRegion(x0, 0, part1, cols.height, base, cols.width);
+    if (count > part1) {
+        texMelRing->UpdateRegion(0, 0, count - part1, cols.height,
+                                 base + size_t(part1) * size_t(cols.bytesPerSample()), cols.width);
+    }
+    doneCurrent();
+    update();
+}
 
-        ibMelSpec = make_unique<IndexBuffer>(indices, 6);
+void GlSpecViewFrame::setSpecRingView(double first_frame, double frames) {
+    if (specRingWidth <= 0) return;
+    // column f covers u in [f, f + 1) / width, its centre sits at frame time f
+    const double u = (first_frame + 0.5) / double(specRingWidth);
+    this->specUOffset = float(u - std::floor(u));
+    this->specUSpan = float(frames / double(specRingWidth));
+    update();
+}
 
-        texMelSpec = make_unique<Texture>(spec.width, spec.height, spec.data.data());
-        shaderMelSpec = make_unique<Shader>("resources/shader/SpectrogramQuad.shader");
-        shaderMelSpec->Bind();
-        shaderMelSpec->SetUniform1i("u_Colormap", 3);
-        shaderMelSpec->SetUniform1i("u_Texture", 0);  // Texture unit 0
+void GlSpecViewFrame::setSpecDbRange(float min_db, float max_db, float contrast) {
+    if (max_db <= min_db) return;
+    this->specMinDb = min_db;
+    this->specMaxDb = max_db;
+    this->specContrast = contrast > 0.0f ? contrast : 1.0f;
+    update();
+}
 
-        vaMelSpec->Unbind();
-        vbMelSpec->Unbind();
-        ibMelSpec->Unbind();
-        texMelSpec->Unbind();
-        shaderMelSpec->Unbind();
+void GlSpecViewFrame::setSpecSmooth(bool smooth) {
+    this->specSmooth = smooth;
+    if (texMelSpec || texMelRing || specShown) {
+        makeCurrent();
+        if (texMelSpec) texMelSpec->SetFilter(smooth ? GL_LINEAR : GL_NEAREST);
+        // other resident windows pick it up in showCachedSpec
+        if (specShown) specShown->tex->SetFilter(smooth ? GL_LINEAR : GL_NEAREST);
+        if (texMelRing) texMelRing->SetFilter(smooth ? GL_LINEAR : GL_NEAREST);
+        doneCurrent();
+    }
+    update();
+}
 
+bool GlSpecViewFrame::setWavePeaks(const raiden::PeakIndex& peaks) {
+    clearWavePeaks();
+    if (peaks.empty()) return false;
+
+    makeCurrent();
+    // coarse levels first, finer ones while they still fit
+    const int64_t max_texels = BufferTexture::MaxTexels();
+    int64_t total = 0;
+    for (int i = raiden::PeakIndex::kLevels - 1; i >= 0; --i) {
+        const int64_t n = int64_t(peaks.level(i).size());
+        if (n == 0 || total + n > max_texels) break;
+        total += n;
+        waveGpuLevels[i].spp = peaks.level(i).spp;
+        waveGpuLevels[i].count = int(n);
+    }
+    if (total == 0) {
         doneCurrent();
+        return false;
+    }
+
+    std::vector<uint16_t> texels(size_t(total) * 4, 0);
+    int base = 0;
+    for (int i = 0; i < raiden::PeakIndex::kLevels; ++i) {
+        if (waveGpuLevels[i].count == 0) continue;
+        const raiden::PeakIndex::Level& L = peaks.level(i);
+        waveGpuLevels[i].base = base;
+        uint16_t* t = texels.data() + size_t(base) * 4;
+        for (size_t e = 0; e < L.size(); ++e, t += 4) {
+            t[0] = raiden::tools::floatToHalf(L.min[e]);
+            t[1] = raiden::tools::floatToHalf(L.max[e]);
+            t[2] = raiden::tools::floatToHalf(L.rms[e]);
+        }
+        base += waveGpuLevels[i].count;
+    }
+
+    texWavePeaks = make_unique<BufferTexture>(texels.data(), texels.size() * sizeof(uint16_t), GL_RGBA16F);
+    if (!vaWaveGpu) {
+        vaWaveGpu = make_unique<VertexArray>();
+        shaderWaveGpu = make_unique<Shader>("resources/shader/WavePeaks.shader");
+        shaderWaveGpu->Bind();
+        shaderWaveGpu->SetUniform1i("u_Peaks", 1);
+        shaderWaveGpu->Unbind();
+    }
+    doneCurrent();
+    return true;
+}
+
+void GlSpecViewFrame::clearWavePeaks() {
+    for (WaveGpuLevel& l : waveGpuLevels) l = WaveGpuLevel();
+    if (waveGpu) {
+        waveGpu = false;
         update();
-    } else {
+    }
+    if (texWavePeaks) {
         makeCurrent();
+        texWavePeaks.reset();
+        doneCurrent();
+    }
+}
 
-        texMelSpec->updateText(spec.width, spec.height, spec.data.data());
-        /*
-        texMelSpec->Bind();
-        GLCall(glTexImage2D(
-            GL_TEXTURE_2D,
-            0,
-            GL_R32F,
-            spec.width,
-            spec.height,
-            0,
-            GL_RED,
-            GL_FLOAT,
-            spec.data.data()
-            ));
-        texMelSpec->Unbind();
-        */
+bool GlSpecViewFrame::setViewWavGpu(int64_t start_sample, int64_t span_samples, float gain) {
+    const int cols = viewportWidthPx();
+    if (!texWavePeaks || cols <= 0 || span_samples <= 0 || start_sample < 0) return false;
+    const double spp = double(span_samples) / double(cols);
 
-        doneCurrent();
-        update();
+    // coarsest level with at least one entry per column, as PeakIndex::project picks it
+    int lvl = -1;
+    for (int i = raiden::PeakIndex::kLevels - 1; i >= 0; --i) {
+        if (waveGpuLevels[i].count > 0 && waveGpuLevels[i].spp <= spp) { lvl = i; break; }
     }
+    if (lvl < 0) return false;
+
+    // entry index and fraction split on the CPU, floats in the shader only see offsets into the view
+    const int64_t L = waveGpuLevels[lvl].spp;
+    this->view_mode = ViewSignalDataMode::WaveForm;
+    this->waveGpu = true;
+    this->waveGpuLevel = lvl;
+    this->waveGpuE0 = int(start_sample / L);
+    this->waveGpuFrac = float(double(start_sample - int64_t(waveGpuE0) * L) / double(L));
+    this->waveGpuStep = float(spp / double(L));
+    this->waveGpuGain = gain;
+    update();
+    return true;
 }
 
 void GlSpecViewFrame::initializeGL() {
@@ -190,6 +436,12 @@ void GlSpecViewFrame::initializeGL() {
     qDebug() << "GL:" << (const char*)glGetString(GL_VERSION);
     connect(context(), &QOpenGLContext::aboutToBeDestroyed,
             this, &GlSpecViewFrame::cleanup, Qt::DirectConnection);
+    connect(this, &QOpenGLWidget::frameSwapped, this, [this]() {
+        if (profiler && paintEnd.time_since_epoch().count() > 0) {
+            profiler->AddCpuSample("swap", std::chrono::duration<double, std::milli>(
+                                               std::chrono::steady_clock::now() - paintEnd).count());
+        }
+    });
 
     renderer = make_unique<Renderer>();
 
@@ -210,12 +462,52 @@ void GlSpecViewFrame::resizeGL(int w, int h) {
 void GlSpecViewFrame::paintGL() {
     //if (cleaned_) return;
 
+    if (profiling && !profiler) profiler = make_unique<GlProfiler>();
+    else if (!profiling && profiler) profiler.reset();
+    if (profiler) profiler->BeginFrame();
+
+    GlStateCache::BeginFrame();
     renderer->Clear();
+    Texture* melTex = specRing ? texMelRing.get() : (specShown ? specShown->tex.get() : texMelSpec.get());
     switch(view_mode) {
     case ViewSignalDataMode::WaveForm:
-        if (vaWave) {
+        if (waveGpu && texWavePeaks) {
+            GlProfiler::Scope prof(profiler.get(), "wave gpu");
+            const WaveGpuLevel& L = waveGpuLevels[waveGpuLevel];
+            const int cols = viewportWidthPx();
+            texWavePeaks->Bind(1);
+            shaderWaveGpu->Bind();
+            shaderWaveGpu->SetUniform1i("u_Peaks", 1);
+            shaderWaveGpu->SetUniform1i("u_Base", L.base);
+            shaderWaveGpu->SetUniform1i("u_Count", L.count);
+            shaderWaveGpu->SetUniform1i("u_E0", waveGpuE0);
+            shaderWaveGpu->SetUniform1f("u_Frac", waveGpuFrac);
+            shaderWaveGpu->SetUniform1f("u_Step", waveGpuStep);
+            shaderWaveGpu->SetUniform1i("u_Cols", cols);
+            shaderWaveGpu->SetUniform1f("u_Gain", waveGpuGain);
+
+            shaderWaveGpu->SetUniform1i("u_Mode", 1);
+            shaderWaveGpu->SetUniform4f("u_Color", 0.15f, 0.3f, 0.55f, 1.0f);
+            renderer->DrawWithoutIndexBuffer(*vaWaveGpu, *shaderWaveGpu, cols * 2, GL_TRIANGLE_STRIP);
+            shaderWaveGpu->SetUniform1i("u_Mode", 0);
+            shaderWaveGpu->SetUniform4f("u_Color", 0.0f, 0.0f, 1.0f, 1.0f);
+            renderer->DrawWithoutIndexBuffer(*vaWaveGpu, *shaderWaveGpu, cols * 2, GL_LINES);
+
+            vaWaveGpu->Unbind();
+            texWavePeaks->Unbind();
+            shaderWaveGpu->Unbind();
+        } else if (vaWave) {
+            GlProfiler::Scope prof(profiler.get(), "wave");
             GLCall(glPointSize(0.01f));
             shaderWave->Bind();
+            if (vaRms && rmsCount > 0) {
+                shaderWave->SetUniform4f("u_Color", 0.15f, 0.3f, 0.55f, 1.0f);
+                renderer->DrawWithoutIndexBuffer(*vaRms, *shaderWave, rmsCount, GL_TRIANGLE_STRIP, rmsFirst);
+                vaRms->Unbind();
+                // repaints redraw the last write: fence its range every frame, not only when written
+                vbRms->MarkDrawn(rmsFirst);
+                vbRms->EndFrame();
+            }
             shaderWave->SetUniform4f("u_Color", 0.0f, 0.0f, 1.0f, 1.0f);
 
             GLenum enumType = GL_LINE_STRIP;
@@ -224,16 +516,34 @@ void GlSpecViewFrame::paintGL() {
             } else {
                 enumType = GL_LINES;
             }
-            renderer->DrawWithoutIndexBuffer(*vaWave, *shaderWave, gl_draw_count, enumType);
+            renderer->DrawWithoutIndexBuffer(*vaWave, *shaderWave, gl_draw_count, enumType, waveFirst);
             vaWave->Unbind();
             shaderWave->Unbind();
+            vbWave->MarkDrawn(waveFirst);
+            vbWave->EndFrame();
+
+            if (profiling && ++waveStreamFrames % kWaveStreamLogFrames == 0) {
+                const StreamingVertexBuffer::Stats& st = vbWave->GetStats();
+                qDebug() << "Wave stream" << (vbWave->IsPersistent() ? "persistent" : "orphan")
+                         << "bytes/frame" << int(st.last_frame_bytes) << "capacity" << int(vbWave->GetCapacity())
+                         << "reallocs" << int(st.reallocs) << "fence waits" << int(st.fence_waits)
+                         << "timeouts" << int(st.fence_timeouts);
+            }
         }
         break;
     case ViewSignalDataMode::Mel_Spectrogram:
-        if (vaMelSpec) {
-            texMelSpec->Bind(0);
+        if (vaMelSpec && melTex) {
+            GlProfiler::Scope prof(profiler.get(), "spec");
+            melTex->Bind(0);
             shaderMelSpec->Bind();
             shaderMelSpec->SetUniform1i("u_Colormap", 3);
+            shaderMelSpec->SetUniform1f("u_Scale", specScale);
+            shaderMelSpec->SetUniform1f("u_Offset", specOffset);
+            shaderMelSpec->SetUniform1f("u_MinDb", specMinDb);
+            shaderMelSpec->SetUniform1f("u_MaxDb", specMaxDb);
+            shaderMelSpec->SetUniform1f("u_Contrast", specContrast);
+            shaderMelSpec->SetUniform1f("u_UOffset", specRing ? specUOffset : 0.0f);
+            shaderMelSpec->SetUniform1f("u_USpan", specRing ? specUSpan : 1.0f);
             renderer->Draw(*vaMelSpec, *ibMelSpec, *shaderMelSpec);
 
             vaMelSpec->Unbind();
@@ -242,5 +552,62 @@ void GlSpecViewFrame::paintGL() {
         }
         break;
     }
+    if (timeline) {
+        GlProfiler::Scope prof(profiler.get(), "timeline");
+        timeline->Draw(*renderer, viewportWidthPx(), viewportHeightPx(), float(devicePixelRatioF()));
+    }
+    GlStateCache::EndFrame();
+    lastGlCalls = GlStateCache::LastFrame();
+    if (profiler) {
+        profiler->EndFrame();
+        paintEnd = std::chrono::steady_clock::now();
+        if (profileOverlay) drawProfileOverlay();
+    }
+}
+
+void GlSpecViewFrame::setTimelineOverlay(bool on) {
+    if (on == (timeline != nullptr)) return;
+    if (on) {
+        // GL objects are made on the first Draw
+        timeline = make_unique<TimelineOverlay>();
+    } else {
+        makeCurrent();
+        timeline.reset();
+        doneCurrent();
+    }
+    update();
+}
+
+void GlSpecViewFrame::setTimelineView(double start_sec, double viewport_sec) {
+    if (!timeline) return;
+    timeline->SetView(start_sec, viewport_sec);
+    update();
+}
+
+void GlSpecViewFrame::setTimelineLabels(const std::vector<LabelSpan>& spans) {
+    if (!timeline) return;
+    timeline->SetLabels(spans);
+    update();
+}
+
+void GlSpecViewFrame::setProfiling(bool on, bool overlay) {
+    profiling = on;
+    profileOverlay = on && overlay;
+    update();
+}
+
+bool GlSpecViewFrame::dumpProfile(const QString& path) const {
+    return profiler && profiler->DumpCsv(path.toStdString());
+}
 
+void GlSpecViewFrame::drawProfileOverlay() {
+    // QPainter after the GL draws; the next paintGL starts from a forgotten state cache anyway
+    QPainter painter(this);
+    QFont font("Monospace");
+    font.setStyleHint(QFont::TypeWriter);
+    font.setPointSize(8);
+    painter.setFont(font);
+    painter.setPen(Qt::yellow);
+    painter.drawText(rect().adjusted(6, 4, -6, -4), Qt::AlignTop | Qt::AlignLeft,
+                     QString::fromStdString(profiler->Summary()));
 }
@@ -0,0 +1,171 @@
+#include "job_scheduler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <exception>
+
+namespace {
+
+double percentile(std::vector<double> v, double q) {
+    if (v.empty()) return 0.0;
+    const size_t k = std::min(v.size() - 1, size_t(q * double(v.size())));
+    std::nth_element(v.begin(), v.begin() + long(k), v.end());
+    return v[k];
+}
+
+}
+
+JobScheduler::JobScheduler(int worker_count) {
+    workerCount = std::max(1, worker_count);
+    workers.reserve(size_t(workerCount));
+    for (int i = 0; i < workerCount; ++i) {
+        workers.emplace_back(&JobScheduler::workerLoop, this);
+    }
+}
+
+JobScheduler::~JobScheduler() {
+    Shutdown();
+}
+
+int JobScheduler::DefaultWorkers() {
+    const int hw = int(std::thread::hardware_concurrency());
+    return std::min(4, std::max(2, hw - 1));
+}
+
+const char* JobScheduler::PriorityName(Priority priority) {
+    switch (priority) {
+    case Interactive: return "interactive";
+    case Labels:      return "labels";
+    case Prefetch:    return "prefetch";
+    case Background:  return "background";
+    default:          return "?";
+    }
+}
+
+bool JobScheduler::Submit(Priority priority, const std::string& key, Job job) {
+    if (priority < 0 || priority >= kPriorityCount || !job) return false;
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        if (stopping) return false;
+        ++stats[priority].submitted;
+        std::deque<Task>& q = queues[priority];
+        if (!key.empty()) {
+            for (Task& t : q) {
+                if (t.key == key) {
+                    t.job = std::move(job);
+                    ++stats[priority].coalesced;
+                    return true;
+                }
+            }
+        }
+        q.push_back({ key, std::move(job), Clock::now() });
+    }
+    cv.notify_one();
+    return true;
+}
+
+size_t JobScheduler::Cancel(const std::string& key) {
+    std::lock_guard<std::mutex> lk(mtx);
+    size_t n = 0;
+    for (std::deque<Task>& q : queues) {
+        for (auto it = q.begin(); it != q.end();) {
+            if (it->key == key) {
+                it = q.erase(it);
+                ++n;
+            } else {
+                ++it;
+            }
+        }
+    }
+    return n;
+}
+
+void JobScheduler::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        stopping = true;
+        for (std::deque<Task>& q : queues) q.clear();
+    }
+    cv.notify_all();
+    for (std::thread& t : workers) {
+        if (t.joinable()) t.join();
+    }
+}
+
+bool JobScheduler::pick(int& priority, std::deque<Task>::iterator& it) {
+    // the last worker is kept for Interactive and Labels
+    const bool lowFull = workerCount > 1 && runningLow >= workerCount - 1;
+    for (int p = 0; p < kPriorityCount; ++p) {
+        if (p >= Prefetch && lowFull) return false;
+        std::deque<Task>& q = queues[p];
+        for (auto i = q.begin(); i != q.end(); ++i) {
+            if (i->key.empty() || running.count(i->key) == 0) {
+                priority = p;
+                it = i;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void JobScheduler::workerLoop() {
+    std::unique_lock<std::mutex> lk(mtx);
+    while (true) {
+        int p = 0;
+        std::deque<Task>::iterator it;
+        cv.wait(lk, [&] { return stopping || pick(p, it); });
+        if (stopping) break;
+
+        Task task = std::move(*it);
+        queues[p].erase(it);
+        if (!task.key.empty()) running.insert(task.key);
+        if (p >= Prefetch) ++runningLow;
+        const Clock::time_point start = Clock::now();
+        const double wait_ms = std::chrono::duration<double, std::milli>(start - task.submitted).count();
+
+        lk.unlock();
+        try {
+            task.job();
+        } catch (const std::exception& e) {
+            std::fprintf(stderr, "JobScheduler: %s job '%s' threw: %s\n",
+                         PriorityName(Priority(p)), task.key.c_str(), e.what());
+        }
+        const double run_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        task.job = nullptr;   // captures are released outside the lock too
+        lk.lock();
+
+        if (!task.key.empty()) running.erase(task.key);
+        if (p >= Prefetch) --runningLow;
+        ++stats[p].run;
+        Samples& s = samples[p];
+        if (s.wait.size() < kStatsWindow) {
+            s.wait.push_back(wait_ms);
+            s.run.push_back(run_ms);
+        } else {
+            s.wait[s.next] = wait_ms;
+            s.run[s.next] = run_ms;
+        }
+        s.next = (s.next + 1) % kStatsWindow;
+        // a freed key or worker may unblock queued jobs of any class
+        cv.notify_all();
+    }
+}
+
+JobScheduler::ClassStats JobScheduler::GetStats(Priority priority) const {
+    ClassStats out;
+    if (priority < 0 || priority >= kPriorityCount) return out;
+    std::vector<double> wait, run;
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        out = stats[priority];
+        out.queued = queues[priority].size();
+        wait = samples[priority].wait;
+        run = samples[priority].run;
+    }
+    out.wait_p50_ms = percentile(wait, 0.50);
+    out.wait_p95_ms = percentile(wait, 0.95);
+    out.wait_max_ms = wait.empty() ? 0.0 : *std::max_element(wait.begin(), wait.end());
+    out.run_p50_ms = percentile(run, 0.50);
+    return out;
+}
@@ -0,0 +1,110 @@
+#include "label_index.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace {
+
+bool byStart(const audio_label& a, const audio_label& b) {
+    return a.start < b.start || (a.start == b.start && a.end < b.end);
+}
+
+}
+
+LabelIndex::Ptr LabelIndex::Build(std::vector<audio_label> labels) {
+    std::shared_ptr<LabelIndex> idx(new LabelIndex());
+    idx->labels.swap(labels);
+    std::stable_sort(idx->labels.begin(), idx->labels.end(), byStart);
+    idx->index();
+    return idx;
+}
+
+LabelIndex::Ptr LabelIndex::Empty() {
+    return Build(std::vector<audio_label>());
+}
+
+LabelIndex::Ptr LabelIndex::With(std::vector<audio_label> added) const {
+    if (added.empty()) return Build(labels);
+
+    std::stable_sort(added.begin(), added.end(), byStart);
+    std::shared_ptr<LabelIndex> idx(new LabelIndex());
+    idx->labels.reserve(labels.size() + added.size());
+    std::merge(labels.begin(), labels.end(),
+               std::make_move_iterator(added.begin()), std::make_move_iterator(added.end()),
+               std::back_inserter(idx->labels), byStart);
+    idx->index();
+    return idx;
+}
+
+void LabelIndex::index() {
+    const int64_t n = int64_t(labels.size());
+    maxEnd.assign(size_t(n), 0.0);
+    rootLevel = -1;
+    if (n == 0) return;
+
+    // leaves (even indices) hold their own end
+    int64_t last_i = 0;
+    double last = 0.0;
+    for (int64_t i = 0; i < n; i += 2) {
+        last_i = i;
+        last = maxEnd[size_t(i)] = labels[size_t(i)].end;
+    }
+    // level k nodes are i = 2^k - 1 + j * 2^(k+1), children at i -/+ 2^(k-1); a right child past n
+    // takes the max of the last subtree that exists
+    int k = 1;
+    for (; (int64_t(1) << k) <= n; ++k) {
+        const int64_t x = int64_t(1) << (k - 1), i0 = (x << 1) - 1, step = x << 2;
+        for (int64_t i = i0; i < n; i += step) {
+            const double el = maxEnd[size_t(i - x)];
+            const double er = i + x < n ? maxEnd[size_t(i + x)] : last;
+            maxEnd[size_t(i)] = std::max(labels[size_t(i)].end, std::max(el, er));
+        }
+        last_i = (last_i >> k & 1) ? last_i - x : last_i + x;
+        if (last_i < n && maxEnd[size_t(last_i)] > last) last = maxEnd[size_t(last_i)];
+    }
+    rootLevel = k - 1;
+}
+
+template <class F>
+void LabelIndex::overlap(double start, double end, F f) const {
+    if (rootLevel < 0) return;
+    const int64_t n = int64_t(labels.size());
+
+    struct Node { int64_t x; int k; bool leftDone; };
+    Node stack[64];
+    int t = 0;
+    stack[t++] = { (int64_t(1) << rootLevel) - 1, rootLevel, false };
+    while (t > 0) {
+        const Node z = stack[--t];
+        if (z.k <= 3) {
+            // small subtree: a linear walk is cheaper than descending
+            const int64_t i0 = z.x >> z.k << z.k;
+            const int64_t i1 = std::min(n, i0 + (int64_t(1) << (z.k + 1)) - 1);
+            for (int64_t i = i0; i < i1 && labels[size_t(i)].start < end; ++i) {
+                if (labels[size_t(i)].end > start) f(size_t(i));
+            }
+        } else if (!z.leftDone) {
+            // revisit z after its left subtree, which only matters if something in it ends after start
+            const int64_t y = z.x - (int64_t(1) << (z.k - 1));
+            stack[t++] = { z.x, z.k, true };
+            if (y >= n || maxEnd[size_t(y)] > start) stack[t++] = { y, z.k - 1, false };
+        } else if (z.x < n && labels[size_t(z.x)].start < end) {
+            if (labels[size_t(z.x)].end > start) f(size_t(z.x));
+            stack[t++] = { z.x + (int64_t(1) << (z.k - 1)), z.k - 1, false };
+        }
+    }
+}
+
+void LabelIndex::Query(double start, double end, std::vector<audio_label>& out) const {
+    overlap(start, end, [&](size_t i) { out.push_back(labels[i]); });
+}
+
+void LabelIndex::QueryIndices(double start, double end, std::vector<size_t>& out) const {
+    overlap(start, end, [&](size_t i) { out.push_back(i); });
+}
+
+size_t LabelIndex::Count(double start, double end) const {
+    size_t c = 0;
+    overlap(start, end, [&](size_t) { ++c; });
+    return c;
+}
@@ -0,0 +1,531 @@
+#include "label_store.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include <nlohmann/json.hpp>
+
+namespace {
+
+const uint32_t kFileMagic = 0x4c424c56;    // "VLBL"
+const uint32_t kBlockMagic = 0x4b4c4256;   // "VBLK"
+const uint32_t kVersion = 1;
+
+struct FileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t committed;       // bytes, header included; anything past it is a torn append
+    uint64_t labels;
+    uint64_t blocks;
+    uint64_t tags;
+    double covered_sec;
+    uint8_t reserved[16];
+};
+static_assert(sizeof(FileHeader) == 64, "label store header");
+
+struct BlockHeader {
+    uint32_t magic;
+    uint32_t count;
+    uint32_t new_tags;
+    uint32_t tag_bytes;       // of the (length, bytes) entries, unpadded
+    uint64_t first;
+    double min_start;
+    double max_end;
+    uint64_t bytes;           // whole block, header and padding included
+};
+static_assert(sizeof(BlockHeader) == 48, "label store block header");
+
+const size_t kMinMapBytes = size_t(1) << 20;
+
+inline size_t pad8(size_t n) { return (n + 7) & ~size_t(7); }
+
+// column bytes of a block, the tag entries start right after
+inline size_t columnBytes(uint32_t count) {
+    return pad8(size_t(count) * (2 * sizeof(double) + sizeof(uint32_t)));
+}
+
+std::string errnoText(const char* what) {
+    return std::string(what) + ": " + std::strerror(errno);
+}
+
+bool writeAll(int fd, const void* data, size_t len, uint64_t off) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    while (len > 0) {
+        const ssize_t n = pwrite(fd, p, len, off_t(off));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += n;
+        len -= size_t(n);
+        off += uint64_t(n);
+    }
+    return true;
+}
+
+bool byStart(const audio_label& a, const audio_label& b) {
+    return a.start < b.start || (a.start == b.start && a.end < b.end);
+}
+
+}
+
+std::unique_ptr<LabelStore> LabelStore::Open(const std::string& path, bool writable, std::string* error) {
+    std::unique_ptr<LabelStore> store(new LabelStore());
+    store->path = path;
+    store->writable = writable;
+    store->fd = writable ? open(path.c_str(), O_RDWR | O_CREAT, 0644) : open(path.c_str(), O_RDONLY);
+    if (store->fd < 0) {
+        if (error) *error = errnoText("open");
+        return nullptr;
+    }
+
+    struct stat st;
+    if (fstat(store->fd, &st) != 0) {
+        if (error) *error = errnoText("fstat");
+        return nullptr;
+    }
+    if (st.st_size == 0 && writable) {
+        store->committed = sizeof(FileHeader);
+        if (!store->writeHeader()) {
+            if (error) *error = errnoText("write header");
+            return nullptr;
+        }
+    } else if (size_t(st.st_size) < sizeof(FileHeader)) {
+        if (error) *error = "not a label store (too short)";
+        return nullptr;
+    }
+
+    if (!store->load(error)) return nullptr;
+    if (writable && uint64_t(st.st_size) > store->committed) {
+        // drop a torn append so the file size says what is in it
+        if (ftruncate(store->fd, off_t(store->committed)) != 0) {
+            if (error) *error = errnoText("ftruncate");
+            return nullptr;
+        }
+    }
+    return store;
+}
+
+LabelStore::~LabelStore() {
+    if (base) munmap(const_cast<uint8_t*>(base), mapped);
+    if (fd >= 0) close(fd);
+}
+
+bool LabelStore::writeHeader() {
+    FileHeader h;
+    std::memset(&h, 0, sizeof(h));
+    h.magic = kFileMagic;
+    h.version = kVersion;
+    h.committed = committed;
+    h.labels = labelCount;
+    h.blocks = blocks.size();
+    h.tags = tags.size();
+    h.covered_sec = coveredSec;
+    return writeAll(fd, &h, sizeof(h), 0);
+}
+
+bool LabelStore::remap() {
+    if (base && size_t(committed) <= mapped) return true;
+    size_t want = size_t(committed);
+    if (writable) {
+        // room for the appends to come; pages past the end of the file are never touched
+        const size_t page = size_t(sysconf(_SC_PAGESIZE));
+        want = std::max(want, std::max(mapped * 2, kMinMapBytes));
+        want = (want + page - 1) / page * page;
+    }
+    if (base) munmap(const_cast<uint8_t*>(base), mapped);
+    base = nullptr;
+    mapped = 0;
+    void* p = mmap(nullptr, want, PROT_READ, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) return false;
+    base = static_cast<const uint8_t*>(p);
+    mapped = want;
+    return true;
+}
+
+bool LabelStore::load(std::string* error) {
+    FileHeader h;
+    if (pread(fd, &h, sizeof(h), 0) != ssize_t(sizeof(h))) {
+        if (error) *error = errnoText("read header");
+        return false;
+    }
+    if (h.magic != kFileMagic) {
+        if (error) *error = "not a label store (bad magic)";
+        return false;
+    }
+    if (h.version != kVersion) {
+        if (error) *error = "unsupported label store version " + std::to_string(h.version);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || h.committed < sizeof(FileHeader) || h.committed > uint64_t(st.st_size)) {
+        if (error) *error = "label store truncated";
+        return false;
+    }
+    committed = h.committed;
+    coveredSec = h.covered_sec;
+    if (!remap()) {
+        if (error) *error = errnoText("mmap");
+        return false;
+    }
+
+    // the block headers are the index: walk them, the columns stay in the mapping
+    blocks.clear();
+    tags.clear();
+    tagIds.clear();
+    blocks.reserve(size_t(h.blocks));
+    tags.reserve(size_t(h.tags));
+    uint64_t off = sizeof(FileHeader);
+    uint64_t count = 0;
+    while (off < committed) {
+        BlockHeader b;
+        if (committed - off < sizeof(b)) break;
+        std::memcpy(&b, base + off, sizeof(b));
+        const uint64_t tag_off = off + sizeof(b) + columnBytes(b.count);
+        if (b.magic != kBlockMagic || b.first != count || b.bytes > committed - off
+                || b.bytes < sizeof(b) + columnBytes(b.count) + b.tag_bytes || tag_off + b.tag_bytes > off + b.bytes) {
+            if (error) *error = "corrupt block at " + std::to_string(off);
+            return false;
+        }
+
+        const uint8_t* t = base + tag_off;
+        const uint8_t* t_end = t + b.tag_bytes;
+        for (uint32_t i = 0; i < b.new_tags; ++i) {
+            uint32_t len;
+            if (t_end - t < ptrdiff_t(sizeof(len))) break;
+            std::memcpy(&len, t, sizeof(len));
+            t += sizeof(len);
+            if (uint64_t(t_end - t) < len) break;
+            tagIds.emplace(std::string(reinterpret_cast<const char*>(t), len), uint32_t(tags.size()));
+            tags.emplace_back(reinterpret_cast<const char*>(t), len);
+            t += len;
+        }
+
+        Block blk;
+        blk.first = b.first;
+        blk.count = b.count;
+        blk.min_start = b.min_start;
+        blk.max_end = b.max_end;
+        blk.offset = size_t(off + sizeof(b));
+        blocks.push_back(blk);
+        count += b.count;
+        off += b.bytes;
+    }
+    labelCount = count;
+    return true;
+}
+
+bool LabelStore::Append(const std::vector<audio_label>& labels, double covered_sec, bool sync) {
+    if (!writable) return false;
+    const double covered = std::max(coveredSec, covered_sec);
+    if (labels.empty()) {
+        if (covered == coveredSec) return true;
+        coveredSec = covered;
+        if (!writeHeader()) return false;
+        return !sync || fdatasync(fd) == 0;
+    }
+
+    std::vector<const audio_label*> sorted;
+    sorted.reserve(labels.size());
+    for (const audio_label& l : labels) sorted.push_back(&l);
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [](const audio_label* a, const audio_label* b) { return byStart(*a, *b); });
+
+    const uint32_t n = uint32_t(sorted.size());
+    const size_t tags_before = tags.size();
+    std::vector<uint32_t> ids(n);
+    size_t tag_bytes = 0;
+    BlockHeader h;
+    std::memset(&h, 0, sizeof(h));
+    h.magic = kBlockMagic;
+    h.count = n;
+    h.first = labelCount;
+    h.min_start = sorted.front()->start;
+    h.max_end = sorted.front()->end;
+    double max_len = 0.0;
+    for (uint32_t i = 0; i < n; ++i) {
+        const audio_label& l = *sorted[i];
+        h.max_end = std::max(h.max_end, l.end);
+        max_len = std::max(max_len, l.end - l.start);
+        auto it = tagIds.find(l.label);
+        if (it == tagIds.end()) {
+            it = tagIds.emplace(l.label, uint32_t(tags.size())).first;
+            tags.push_back(l.label);
+            tag_bytes += sizeof(uint32_t) + l.label.size();
+        }
+        ids[i] = it->second;
+    }
+    h.new_tags = uint32_t(tags.size() - tags_before);
+    h.tag_bytes = uint32_t(tag_bytes);
+    h.bytes = sizeof(h) + columnBytes(n) + pad8(tag_bytes);
+
+    std::vector<uint8_t> buf(size_t(h.bytes), 0);
+    uint8_t* p = buf.data();
+    std::memcpy(p, &h, sizeof(h));
+    double* starts = reinterpret_cast<double*>(p + sizeof(h));
+    double* ends = starts + n;
+    uint32_t* tag_col = reinterpret_cast<uint32_t*>(ends + n);
+    for (uint32_t i = 0; i < n; ++i) {
+        starts[i] = sorted[i]->start;
+        ends[i] = sorted[i]->end;
+    }
+    std::memcpy(tag_col, ids.data(), n * sizeof(uint32_t));
+    uint8_t* t = p + sizeof(h) + columnBytes(n);
+    for (size_t i = tags_before; i < tags.size(); ++i) {
+        const uint32_t len = uint32_t(tags[i].size());
+        std::memcpy(t, &len, sizeof(len));
+        std::memcpy(t + sizeof(len), tags[i].data(), len);
+        t += sizeof(len) + len;
+    }
+
+    // block first, then the header that commits it
+    const uint64_t off = committed;
+    const uint64_t prev_count = labelCount;
+    const double prev_covered = coveredSec;
+    bool ok = writeAll(fd, buf.data(), buf.size(), off) && (!sync || fdatasync(fd) == 0);
+    if (ok) {
+        committed = off + h.bytes;
+        labelCount += n;
+        coveredSec = covered;
+        Block blk;
+        blk.first = h.first;
+        blk.count = n;
+        blk.min_start = h.min_start;
+        blk.max_end = h.max_end;
+        blk.offset = size_t(off + sizeof(h));
+        blk.max_len = max_len;
+        blocks.push_back(blk);
+        ok = writeHeader() && (!sync || fdatasync(fd) == 0);
+        if (!ok) blocks.pop_back();
+    }
+    if (!ok) {
+        committed = off;
+        labelCount = prev_count;
+        coveredSec = prev_covered;
+        for (size_t i = tags_before; i < tags.size(); ++i) tagIds.erase(tags[i]);
+        tags.resize(tags_before);
+        return false;
+    }
+    return remap();
+}
+
+const double* LabelStore::Starts(const Block& b) const {
+    return reinterpret_cast<const double*>(base + b.offset);
+}
+
+const double* LabelStore::Ends(const Block& b) const {
+    return Starts(b) + b.count;
+}
+
+const uint32_t* LabelStore::TagIds(const Block& b) const {
+    return reinterpret_cast<const uint32_t*>(Ends(b) + b.count);
+}
+
+std::vector<audio_label> LabelStore::ReadAll() const {
+    std::vector<audio_label> out;
+    out.reserve(size_t(labelCount));
+    const std::string none;
+    for (const Block& b : blocks) {
+        const double* s = Starts(b);
+        const double* e = Ends(b);
+        const uint32_t* id = TagIds(b);
+        for (uint32_t i = 0; i < b.count; ++i) {
+            out.push_back({ s[i], e[i], id[i] < tags.size() ? tags[id[i]] : none });
+        }
+    }
+    return out;
+}
+
+void LabelStore::Query(double start, double end, std::vector<audio_label>& out) const {
+    const std::string none;
+    for (const Block& b : blocks) {
+        if (!(b.max_end > start && b.min_start < end)) continue;
+        const double* s = Starts(b);
+        const double* e = Ends(b);
+        const uint32_t* id = TagIds(b);
+        if (b.max_len < 0.0) {
+            double len = 0.0;
+            for (uint32_t i = 0; i < b.count; ++i) len = std::max(len, e[i] - s[i]);
+            b.max_len = len;
+        }
+        // sorted by start within a block: nothing starting before start - max_len reaches start
+        // (a little slack for the rounding of the subtraction)
+        const double from = start - b.max_len * (1.0 + 1e-12) - 1e-9;
+        for (uint32_t i = uint32_t(std::lower_bound(s, s + b.count, from) - s); i < b.count && s[i] < end; ++i) {
+            if (e[i] > start) out.push_back({ s[i], e[i], id[i] < tags.size() ? tags[id[i]] : none });
+        }
+    }
+}
+
+namespace {
+
+bool readFile(const std::string& path, std::string& out) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    std::ostringstream ss;
+    ss << in.rdbuf();
+    out = ss.str();
+    return true;
+}
+
+bool parseNumber(const std::string& s, double& v) {
+    const char* b = s.c_str();
+    char* e = nullptr;
+    v = std::strtod(b, &e);
+    if (e == b) return false;
+    while (*e == ' ' || *e == '\t') ++e;
+    return *e == '\0';
+}
+
+void csvField(std::string& out, const std::string& s) {
+    if (s.find_first_of(",\"\r\n") == std::string::npos) {
+        out += s;
+        return;
+    }
+    out += '"';
+    for (char c : s) {
+        if (c == '"') out += '"';
+        out += c;
+    }
+    out += '"';
+}
+
+bool hasExtension(const std::string& path, const char* ext) {
+    const size_t n = std::strlen(ext);
+    if (path.size() < n) return false;
+    for (size_t i = 0; i < n; ++i) {
+        if (std::tolower(static_cast<unsigned char>(path[path.size() - n + i])) != ext[i]) return false;
+    }
+    return true;
+}
+
+}
+
+bool LabelFile::ReadCsv(const std::string& path, std::vector<audio_label>& out) {
+    std::string text;
+    if (!readFile(path, text)) return false;
+
+    // RFC 4180: quoted fields may hold commas, newlines and doubled quotes
+    std::vector<std::string> row;
+    std::string field;
+    bool quoted = false;
+    bool first_row = true;
+    auto endRow = [&]() {
+        row.push_back(field);
+        field.clear();
+        double s, e;
+        if (row.size() >= 3 && parseNumber(row[0], s) && parseNumber(row[1], e)) {
+            out.push_back({ s, e, row[2] });
+        } else if (!first_row && !(row.size() == 1 && row[0].empty())) {
+            std::fprintf(stderr, "labels: skipping bad csv row in %s\n", path.c_str());
+        }
+        first_row = false;   // a header line is the one non numeric row allowed
+        row.clear();
+    };
+    for (size_t i = 0; i < text.size(); ++i) {
+        const char c = text[i];
+        if (quoted) {
+            if (c != '"') {
+                field += c;
+            } else if (i + 1 < text.size() && text[i + 1] == '"') {
+                field += '"';
+                ++i;
+            } else {
+                quoted = false;
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            row.push_back(field);
+            field.clear();
+        } else if (c == '\n') {
+            endRow();
+        } else if (c != '\r') {
+            field += c;
+        }
+    }
+    if (!field.empty() || !row.empty()) endRow();
+    return true;
+}
+
+bool LabelFile::WriteCsv(const std::string& path, const std::vector<audio_label>& labels) {
+    std::ofstream f(path, std::ios::binary | std::ios::trunc);
+    if (!f) return false;
+    std::string out("start,end,label\n");
+    char num[64];
+    for (const audio_label& l : labels) {
+        // %.17g round-trips a double
+        std::snprintf(num, sizeof(num), "%.17g,%.17g,", l.start, l.end);
+        out += num;
+        csvField(out, l.label);
+        out += '\n';
+        if (out.size() > (1 << 20)) {
+            f.write(out.data(), std::streamsize(out.size()));
+            out.clear();
+        }
+    }
+    f.write(out.data(), std::streamsize(out.size()));
+    return bool(f);
+}
+
+bool LabelFile::ReadJson(const std::string& path, std::vector<audio_label>& out) {
+    std::string text;
+    if (!readFile(path, text)) return false;
+    auto j = nlohmann::json::parse(text, nullptr, false);
+    if (j.is_discarded()) return false;
+    if (j.is_object() && j.contains("result")) j = j["result"];
+    if (!j.is_array()) return false;
+
+    // checked field by field: json::value() throws on a wrong type ("start": "1.5")
+    out.reserve(out.size() + j.size());
+    size_t bad = 0;
+    for (const auto& obj : j) {
+        if (!obj.is_object()) {
+            ++bad;
+            continue;
+        }
+        auto s = obj.find("start");
+        auto e = obj.find("end");
+        auto v = obj.find("value");
+        if (s == obj.end() || !s->is_number() || e == obj.end() || !e->is_number() ||
+            (v != obj.end() && !v->is_string())) {
+            ++bad;
+            continue;
+        }
+        out.push_back({ s->get<double>(), e->get<double>(), v != obj.end() ? v->get<std::string>() : std::string() });
+    }
+    if (bad) std::fprintf(stderr, "labels: skipped %zu bad json entries in %s\n", bad, path.c_str());
+    // like ReadCsv a bad entry is skipped; a file with nothing usable fails the import
+    return j.empty() || bad < j.size();
+}
+
+bool LabelFile::WriteJson(const std::string& path, const std::vector<audio_label>& labels) {
+    nlohmann::json j = nlohmann::json::array();
+    for (const audio_label& l : labels) {
+        j.push_back({ { "start", l.start }, { "end", l.end }, { "value", l.label } });
+    }
+    std::ofstream f(path, std::ios::binary | std::ios::trunc);
+    if (!f) return false;
+    // tags come from the DL service as-is; bad UTF-8 must not throw here
+    f << j.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+    return bool(f);
+}
+
+bool LabelFile::Read(const std::string& path, std::vector<audio_label>& out) {
+    return hasExtension(path, ".json") ? ReadJson(path, out) : ReadCsv(path, out);
+}
+
+bool LabelFile::Write(const std::string& path, const std::vector<audio_label>& labels) {
+    return hasExtension(path, ".json") ? WriteJson(path, labels) : WriteCsv(path, labels);
+}
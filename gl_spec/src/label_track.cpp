@@ -1,6 +1,7 @@
 #include "label_track.h"
 #include <QPainter>
 #include <QGraphicsSceneMouseEvent>
+#include <QResizeEvent>
 #include <cmath>
 
 #include <QDebug>
@@ -28,6 +29,20 @@ void SpanItem::setPxPerSec(double pps){
     update();
 }
 
+void SpanItem::setSpan(double start, double end, const QString& tag) {
+    s_ = start;
+    e_ = end;
+    if (tag_ != tag) {
+        tag_ = tag;
+        update();
+    }
+}
+
+void SpanItem::place(double x, double length) {
+    if (pos().x() != x || pos().y() != 20) setPos(x, 20);
+    if (this->_length_ != length) setNewLength(length);
+}
+
 void SpanItem::paint(QPainter* p, const QStyleOptionGraphicsItem*, QWidget*) {
     const QRectF r = boundingRect();
     p->setRenderHint(QPainter::Antialiasing, true);
@@ -48,6 +63,8 @@ void SpanItem::paint(QPainter* p, const QStyleOptionGraphicsItem*, QWidget*) {
 LabelTrackView::LabelTrackView(QWidget* parent) : QGraphicsView(parent) {
 
     setScene(&scene_);
+    // spans move on every scroll, a BSP index would be rebuilt each time for a handful of items
+    scene_.setItemIndexMethod(QGraphicsScene::NoIndex);
 
     scene_.setSceneRect(0, 0, this->widthRec, 30);
     setAlignment(Qt::AlignLeft | Qt::AlignTop);
@@ -58,60 +75,67 @@ LabelTrackView::LabelTrackView(QWidget* parent) : QGraphicsView(parent) {
 
 }
 
-SpanItem* LabelTrackView::addSpan(double startSec, double endSec, const QString& tag) {
-
-    double view_port_sec = 5.0;
-    double pxPerSec = this->widthRec / view_port_sec;
-    auto* it = new SpanItem(pxPerSec, startSec, endSec, tag);
-    scene_.addItem(it);
+void LabelTrackView::setLabels(const std::vector<LabelSpan>& spans) {
+    const double pxPerSec = this->widthRec / viewport_sec;
+    while (pool_.size() < spans.size()) {
+        auto* it = new SpanItem(pxPerSec, 0.0, 0.0, QString());
+        it->setVisible(false);
+        scene_.addItem(it);
+        pool_.push_back(it);
+    }
 
-    resetCachedContent();
-    update();
+    for (size_t i = 0; i < spans.size(); ++i) {
+        pool_[i]->setSpan(spans[i].start, spans[i].end, spans[i].tag);
+    }
+    // spare items stay in the scene, hidden
+    for (size_t i = spans.size(); i < active_; ++i) {
+        pool_[i]->setVisible(false);
+    }
+    active_ = spans.size();
+    layoutSpans();
+}
 
-    return it;
+void LabelTrackView::layoutSpans() {
+    const double pxPerSec = widthRec / viewport_sec;
+    const double S = start_sec;
+    const double E = start_sec + viewport_sec;
+    for (size_t i = 0; i < active_; ++i) {
+        SpanItem* it = pool_[i];
+        const double A = it->start();
+        const double B = it->end();
+        const bool visible = (B > S) && (A < E);
+        it->setVisible(visible);
+        if (!visible) continue;
+
+        const double L = std::max(A, S);
+        const double R = std::min(B, E);
+        it->place((L - S) * pxPerSec, (R - L) * pxPerSec);
+    }
 }
 
 void LabelTrackView::setStartSec(double sec, double viewport) {
     this->start_sec = sec;
     this->viewport_sec = viewport;
+    // the time grid is in the cached background
     resetCachedContent();
     update();
 
-    double pxPerSec = widthRec / viewport_sec;
-    double S = start_sec;
-    int i = 0;
-    for (QGraphicsItem* gi : scene_.items()) {
-        if (auto* it = qgraphicsitem_cast<SpanItem*>(gi)) {
-            it->setPxPerSec(pxPerSec);
-
-            double A = it->start();
-            double B = it->end();
-            bool visible = (B > S) && (A < S + 5.0);
-            it->setVisible(visible);
-
-            double L = std::max(A, S);
-            double R = std::min(B, S + 5.0);
-            double x = (L - S) * pxPerSec;
-            double w = (R - L) * pxPerSec;
-
-            i++;
-            /*
-            qDebug() << std::to_string(i).c_str() << ":"
-                     << std::to_string(it->start()).c_str() << " - " << std::to_string(it->end()).c_str() << " > "
-                     << std::to_string(x).c_str() << " ~ " << std::to_string(w).c_str();
-            */
-            it->setPos(x, 20);
-        }
-    }
+    layoutSpans();
+}
+
+void LabelTrackView::resizeEvent(QResizeEvent* e) {
+    QGraphicsView::resizeEvent(e);
+    this->widthRec = viewport()->width();
+    scene_.setSceneRect(0, 0, this->widthRec, 30);
+    layoutSpans();
 }
 
 // if (endSec <= startSec) endSec = startSec + 0.25; // guard: min 250ms
 void LabelTrackView::drawBackground(QPainter* p, const QRectF& r) {
     p->fillRect(r, QColor("#d9d9d9"));
-    this->widthRec = r.width();
-    scene_.setSceneRect(0, 0, this->widthRec, 30);
 
-    double pxPerSec = r.width() / viewport_sec;
+    // grid only: the spans are laid out by setStartSec / setLabels / resizeEvent, never from paint
+    double pxPerSec = widthRec / viewport_sec;
     double pxForHalfSec = 0.5 * pxPerSec;
 
     //qDebug() << "pps__:" << std::to_string(pxPerSec).c_str();
@@ -123,32 +147,4 @@ void LabelTrackView::drawBackground(QPainter* p, const QRectF& r) {
         p->drawText(t+3, r.top()+12, QString::number(curr_start_sec)+"s");
         curr_start_sec += 0.5;
     }
-
-    double S = start_sec;
-    int i = 0;
-    for (QGraphicsItem* gi : scene_.items()) {
-        if (auto* it = qgraphicsitem_cast<SpanItem*>(gi)) {
-
-
-            double A = it->start();
-            double B = it->end();
-            bool visible = (B > S) && (A < S + 5.0);
-            it->setVisible(visible);
-
-            double L = std::max(A, S);
-            double R = std::min(B, S + 5.0);
-            double x = (L - S) * pxPerSec;
-            double w = (R - L) * pxPerSec;
-
-            i++;
-            /*
-            qDebug() << std::to_string(i).c_str() << ":"
-                     << std::to_string(it->start()).c_str() << " - " << std::to_string(it->end()).c_str() << " > "
-                     << std::to_string(x).c_str() << " ~ " << std::to_string(w).c_str();
-            */
-            it->setPos(x, 20);
-            it->setPxPerSec(pxPerSec);
-            it->setNewLength(w);
-        }
-    }
 }
@@ -0,0 +1,105 @@
+#include "spec_texture_cache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <iterator>
+
+size_t SpecCacheKeyHash::operator()(const SpecCacheKey& k) const {
+    size_t h = std::hash<std::string>()(k.path);
+    const auto mix = [&h](uint64_t v) { h ^= size_t(v) + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2); };
+    mix(uint64_t(k.start_sample));
+    mix(uint64_t(k.span_samples));
+    mix(uint64_t(k.sr));
+    mix(uint64_t(k.n_fft) << 32 | uint64_t(uint32_t(k.n_hop)));
+    mix(uint64_t(k.n_mels) << 8 | uint64_t(k.window_mode) << 4 | uint64_t(k.format));
+    uint32_t ref_bits;
+    std::memcpy(&ref_bits, &k.ref_power, sizeof(ref_bits));
+    mix(ref_bits);
+    return h;
+}
+
+SpecTextureCache::SpecTextureCache(size_t budget_bytes, size_t max_entries)
+    : budgetBytes(budget_bytes), maxEntries(std::max<size_t>(1, max_entries)) {}
+
+const SpecTextureCache::Entry* SpecTextureCache::Find(const SpecCacheKey& key) {
+    auto it = index.find(key);
+    if (it == index.end()) {
+        ++misses;
+        return nullptr;
+    }
+    ++hits;
+    lru.splice(lru.begin(), lru, it->second);
+    return &lru.front().second;
+}
+
+void SpecTextureCache::evictFor(size_t bytes, size_t entries, int width, int height, TextureFormat format,
+                                std::unique_ptr<Texture>* reuse) {
+    size_t pinnedMoves = 0;
+    while (!lru.empty() && (residentBytes + bytes > budgetBytes || lru.size() + entries > maxEntries)) {
+        if (&lru.back().second == pinned) {
+            // on screen: goes to the front instead, everything else is older
+            if (lru.size() == 1 || pinnedMoves++ > 0) break;
+            lru.splice(lru.begin(), lru, std::prev(lru.end()));
+            continue;
+        }
+        Entry& e = lru.back().second;
+        if (reuse && !*reuse && e.format == format && e.tex
+            && e.tex->GetWidth() == width && e.tex->GetHeight() == height) {
+            *reuse = std::move(e.tex);
+        }
+        residentBytes -= e.bytes;
+        index.erase(lru.back().first);
+        lru.pop_back();
+        ++evictions;
+    }
+}
+
+std::unique_ptr<Texture> SpecTextureCache::Reserve(int width, int height, TextureFormat format) {
+    std::unique_ptr<Texture> reuse;
+    const size_t bytes = size_t(width) * size_t(height) * size_t(Texture::BytesPerPixel(format));
+    evictFor(bytes, 1, width, height, format, &reuse);
+    return reuse;
+}
+
+const SpecTextureCache::Entry* SpecTextureCache::Insert(const SpecCacheKey& key, Entry entry) {
+    auto it = index.find(key);
+    if (it != index.end()) {
+        // same key, same texels: keep the resident one
+        lru.splice(lru.begin(), lru, it->second);
+        return &lru.front().second;
+    }
+    evictFor(entry.bytes, 1, 0, 0, entry.format, nullptr);
+    residentBytes += entry.bytes;
+    lru.emplace_front(key, std::move(entry));
+    index[key] = lru.begin();
+    return &lru.front().second;
+}
+
+void SpecTextureCache::Pin(const Entry* entry) {
+    pinned = entry;
+}
+
+void SpecTextureCache::Clear() {
+    pinned = nullptr;
+    index.clear();
+    lru.clear();
+    residentBytes = 0;
+}
+
+void SpecTextureCache::SetBudget(size_t budget_bytes, size_t max_entries) {
+    budgetBytes = budget_bytes;
+    maxEntries = std::max<size_t>(1, max_entries);
+    evictFor(0, 0, 0, 0, TextureFormat::R8, nullptr);
+}
+
+SpecTextureCache::Stats SpecTextureCache::GetStats() const {
+    Stats st;
+    st.hits = hits;
+    st.misses = misses;
+    st.evictions = evictions;
+    st.entries = lru.size();
+    st.resident_bytes = residentBytes;
+    st.budget_bytes = budgetBytes;
+    return st;
+}
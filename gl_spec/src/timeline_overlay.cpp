@@ -0,0 +1,237 @@
+#include "timeline_overlay.h"
+
+#include <QFont>
+#include <QFontMetrics>
+#include <QImage>
+#include <QPainter>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+
+// Only if you're stuck with C++11
+template<typename T, typename... Args>
+std::unique_ptr<T> make_unique(Args&&... args) {
+    return std::unique_ptr<T>(new T(std::forward<Args>(args)...));
+}
+
+namespace {
+
+const int kFloatsPerInstance = 12;
+const int kAtlasColumns = 16;
+
+const float kLaneColor[4]   = { 0.85f, 0.85f, 0.85f, 0.85f };
+const float kTickColor[4]   = { 0.0f, 0.0f, 0.0f, 1.0f };
+const float kSpanEdge[4]    = { 0.0f, 0.0f, 0.0f, 1.0f };
+const float kSpanFill[4]    = { 0.81f, 0.89f, 1.0f, 1.0f };   // #cfe3ff, as SpanItem
+const float kSpanHandle[4]  = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+// "2.5", "3", "12.25": at most two decimals, no trailing zeros
+std::string secText(double t) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.2f", t);
+    std::string s(buf);
+    while (!s.empty() && s.back() == '0') s.pop_back();
+    if (!s.empty() && s.back() == '.') s.pop_back();
+    if (s == "-0") s = "0";
+    return s + "s";
+}
+
+}
+
+void TimelineOverlay::SetView(double start_sec, double viewport_sec) {
+    if (viewport_sec <= 0.0 || (start_sec == startSec && viewport_sec == viewportSec)) return;
+    startSec = start_sec;
+    viewportSec = viewport_sec;
+    dirty = true;
+}
+
+void TimelineOverlay::SetLabels(const std::vector<LabelSpan>& spans) {
+    labels.clear();
+    labels.reserve(spans.size());
+    for (const LabelSpan& s : spans) {
+        labels.push_back({ s.start, s.end, s.tag.toLatin1().toStdString() });
+    }
+    dirty = true;
+}
+
+const TimelineOverlay::Glyph& TimelineOverlay::glyph(char c) const {
+    const int i = int(static_cast<unsigned char>(c)) - 32;
+    return glyphs[(i >= 0 && i < 95) ? i : ('?' - 32)];
+}
+
+void TimelineOverlay::buildAtlas(float dpr) {
+    QFont font;
+    font.setPixelSize(std::max(6, int(std::lround(11.0 * dpr))));
+    const QFontMetrics fm(font);
+    const int cellW = fm.maxWidth() + 2;
+    const int cellH = fm.height() + 2;
+    const int rows = (95 + kAtlasColumns - 1) / kAtlasColumns;
+    // R8 rows of a multiple of 4 texels upload without padding
+    const int w = (kAtlasColumns * cellW + 3) & ~3;
+    const int h = rows * cellH;
+
+    QImage img(w, h, QImage::Format_ARGB32_Premultiplied);
+    img.fill(Qt::transparent);
+    QPainter p(&img);
+    p.setFont(font);
+    p.setPen(Qt::white);
+    for (int i = 0; i < 95; ++i) {
+        const QChar ch(char(32 + i));
+        const int x = (i % kAtlasColumns) * cellW + 1;
+        const int y = (i / kAtlasColumns) * cellH + 1;
+        p.drawText(x, y + fm.ascent(), QString(ch));
+
+        Glyph& g = glyphs[i];
+        g.advance = float(fm.horizontalAdvance(ch));
+        g.u0 = float(x) / float(w);
+        g.v0 = float(y) / float(h);
+        g.u1 = (float(x) + g.advance) / float(w);
+        g.v1 = float(y + fm.height()) / float(h);
+    }
+    p.end();
+
+    // coverage only, the colour is per instance
+    std::vector<uint8_t> texels(size_t(w) * size_t(h));
+    for (int y = 0; y < h; ++y) {
+        const QRgb* line = reinterpret_cast<const QRgb*>(img.constScanLine(y));
+        for (int x = 0; x < w; ++x) texels[size_t(y) * size_t(w) + size_t(x)] = uint8_t(qAlpha(line[x]));
+    }
+    if (!atlas) {
+        atlas = make_unique<Texture>(w, h, static_cast<const void*>(texels.data()), TextureFormat::R8);
+    } else {
+        atlas->updateText(w, h, texels.data(), TextureFormat::R8);
+    }
+    // glyph quads are placed on whole pixels at the atlas scale
+    atlas->SetFilter(GL_NEAREST);
+
+    lineHeight = float(fm.height());
+    atlasDpr = dpr;
+    dirty = true;
+}
+
+void TimelineOverlay::quad(float x0, float y0, float x1, float y1, const float* col, const Glyph* g) {
+    const float v[kFloatsPerInstance] = {
+        x0, y0, x1, y1,
+        g ? g->u0 : -1.0f, g ? g->v0 : 0.0f, g ? g->u1 : 0.0f, g ? g->v1 : 0.0f,
+        col[0], col[1], col[2], col[3]
+    };
+    instances.insert(instances.end(), v, v + kFloatsPerInstance);
+}
+
+float TimelineOverlay::textWidth(const std::string& s) const {
+    float w = 0.0f;
+    for (char c : s) w += glyph(c).advance;
+    return w;
+}
+
+std::string TimelineOverlay::elide(const std::string& s, float max_w) const {
+    if (textWidth(s) <= max_w) return s;
+    const float dots = textWidth("...");
+    if (dots > max_w) return std::string();
+    float w = dots;
+    size_t n = 0;
+    while (n < s.size() && w + glyph(s[n]).advance <= max_w) w += glyph(s[n++]).advance;
+    return s.substr(0, n) + "...";
+}
+
+void TimelineOverlay::text(float x, float y, const std::string& s, const float* col) {
+    x = std::floor(x + 0.5f);
+    y = std::floor(y + 0.5f);
+    for (char c : s) {
+        const Glyph& g = glyph(c);
+        if (c != ' ') quad(x, y, x + g.advance, y + lineHeight, col, &g);
+        x += g.advance;
+    }
+}
+
+void TimelineOverlay::build(int fbw, int fbh, float dpr) {
+    instances.clear();
+    const float lane = float(kLanePx) * dpr;
+    const float top = float(fbh) - lane;
+    const double pps = double(fbw) / viewportSec;
+    const float px = std::max(1.0f, std::floor(dpr));
+
+    quad(0.0f, top, float(fbw), float(fbh), kLaneColor);
+
+    // 0.5 s grid as the label lane had it, coarser when the labels would collide
+    double step = 0.5;
+    while (step * pps < 48.0 * dpr) step *= 2.0;
+    const double end = startSec + viewportSec;
+    for (int64_t k = int64_t(std::ceil(startSec / step)); double(k) * step < end; ++k) {
+        const double t = double(k) * step;
+        const float x = float((t - startSec) * pps);
+        quad(x, top, x + px, float(fbh), kTickColor);
+        text(x + 3.0f * dpr, top + 1.0f * dpr, secText(t), kTickColor);
+    }
+
+    const float y0 = top + 16.0f * dpr;
+    const float y1 = float(fbh) - 2.0f * dpr;
+    const float handle = 6.0f * dpr;
+    for (const Label& l : labels) {
+        if (!(l.end > startSec && l.start < end)) continue;
+        const float x0 = float((std::max(l.start, startSec) - startSec) * pps);
+        const float x1 = std::max(x0 + px, float((std::min(l.end, end) - startSec) * pps));
+
+        quad(x0, y0, x1, y1, kSpanEdge);
+        if (x1 - x0 > 2.0f * px) {
+            quad(x0 + px, y0 + px, x1 - px, y1 - px, kSpanFill);
+        }
+        if (x1 - x0 > 2.0f * handle + 2.0f * px) {
+            quad(x0 + px, y0 + px, x0 + handle, y1 - px, kSpanHandle);
+            quad(x1 - handle, y0 + px, x1 - px, y1 - px, kSpanHandle);
+        }
+        const std::string t = elide(l.text, x1 - x0 - 2.0f * handle - 4.0f * dpr);
+        if (!t.empty()) {
+            text((x0 + x1 - textWidth(t)) * 0.5f, (y0 + y1 - lineHeight) * 0.5f, t, kTickColor);
+        }
+    }
+
+    instanceCount = int(instances.size() / kFloatsPerInstance);
+    builtWidth = fbw;
+    builtHeight = fbh;
+    builtDpr = dpr;
+    dirty = false;
+}
+
+void TimelineOverlay::Draw(Renderer& renderer, int fb_width, int fb_height, float dpr) {
+    if (fb_width <= 0 || fb_height <= 0) return;
+
+    if (!shader) {
+        shader = make_unique<Shader>("resources/shader/Label.shader");
+        shader->Bind();
+        shader->SetUniform1i("u_Atlas", kAtlasUnit);
+        shader->Unbind();
+
+        layout.Pushs(4);   // rect
+        layout.Pushs(4);   // uv
+        layout.Pushs(4);   // colour
+        layout.SetDivisor(1);
+        va = make_unique<VertexArray>();
+        vb = make_unique<VertexBuffer>(nullptr, 0, GL_DYNAMIC_DRAW);
+        va->AddBuffer(*vb, layout);
+        va->Unbind();
+        vb->Unbind();
+    }
+    if (atlasDpr != dpr) buildAtlas(dpr);
+    if (dirty || fb_width != builtWidth || fb_height != builtHeight || dpr != builtDpr) {
+        build(fb_width, fb_height, dpr);
+        // whole buffer respecified (orphaned), the VAO keeps pointing at the same name
+        vb->UpdateData(instances.data(), GLuint(instances.size() * sizeof(float)));
+        vb->Unbind();
+    }
+    if (instanceCount == 0) return;
+
+    GLCall(glEnable(GL_BLEND));
+    GLCall(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+    atlas->Bind(kAtlasUnit);
+    shader->Bind();
+    shader->SetUniform1i("u_Atlas", kAtlasUnit);
+    shader->SetUniform2f("u_Viewport", float(fb_width), float(fb_height));
+    renderer.DrawInstanced(*va, *shader, 4, instanceCount);
+    va->Unbind();
+    atlas->Unbind();
+    shader->Unbind();
+    GLCall(glDisable(GL_BLEND));
+}
@@ -2,7 +2,7 @@
 #define FRAME_MEDIA_GL_H
 #pragma once
 
-#include <mutex>
+#include <atomic>
 #include <memory>
 #include "vertex_array.h"
 #include "vertex_buffer.h"
@@ -10,6 +10,10 @@
 #include "shader.h"
 #include "renderer.h"
 #include "texture.h"
+#include "streaming_texture.h"
+#include "frame_triple_buffer.h"
+#include "gl_profiler.h"
+#include "gl_state_cache.h"
 
 #include <QOpenGLWidget>
 struct MdlTextCoordMatrix {
@@ -28,6 +32,51 @@ public:
     void updateText(int width, int height, const std::vector<uint8_t>& data);
 
     void submitFrame(int w, int h, std::shared_ptr<const std::vector<uint8_t>> pix);
+    // any thread, lock-free: the newest frame waits in a triple buffer and paintGL takes it,
+    // so at most one upload per repaint; frames replaced before a repaint are skipped
+    // play_sec is the audio clock at the call, pts_sec when the frame is due on that clock;
+    // linesize = bytes per row of pix when rows are padded (0 = w * 4), uploaded as is
+    void pushFrame(int w, int h, std::shared_ptr<const std::vector<uint8_t>> pix, double play_sec, double pts_sec,
+                   int linesize = 0);
+    uint64_t skippedFrames() const { return frames.skipped(); }
+    // true: frames go through the PBO ring, false: plain glTexSubImage2D (for comparison)
+    void setStreamingUpload(bool on) { streamingUpload = on; }
+    // true: a pushed frame is held until the vsync nearest its pts, false: shown on the next repaint
+    void setFramePacing(bool on) { framePacing = on; }
+
+    // presentation telemetry since the widget was made or the last resetPresentStats(); times in ms
+    struct PresentStats {
+        uint64_t presented = 0;
+        uint64_t dropped = 0;        // replaced before they reached the screen
+        uint64_t late = 0;           // on screen more than one refresh after their target
+        double refresh_ms = 0.0;     // estimated display refresh interval
+        double mean_error_ms = 0.0;  // actual - target present time
+        double judder_ms = 0.0;      // standard deviation of that error
+        double max_error_ms = 0.0;
+    };
+    struct PresentRecord {
+        double pts_sec;
+        double target_ms;            // steady clock time the frame was due
+        double actual_ms;            // frameSwapped after its upload
+    };
+    PresentStats presentStats() const;
+    void resetPresentStats();
+    // last kPresentLogSize frames, oldest first
+    std::vector<PresentRecord> presentLog() const;
+
+    // per region CPU / GPU times of paintGL (upload, draw, swap); overlay draws their percentiles on top
+    void setProfiling(bool on, bool overlay = false);
+    // percentiles as CSV; false when not profiling or the file cannot be written
+    bool dumpProfile(const QString& path) const;
+    std::vector<GlProfiler::RegionStats> profileStats() const {
+        return profiler ? profiler->Stats() : std::vector<GlProfiler::RegionStats>();
+    }
+    // GLCall invocations and redundant state changes the state cache skipped in the last paintGL
+    GlStateCache::FrameStats glCallStats() const { return lastGlCalls; }
+
+signals:
+    // from paintGL, once the frame due at pts_sec is being drawn
+    void framePresented(double pts_sec);
 
 protected:
     void initializeGL() override;
@@ -35,6 +84,7 @@ protected:
     void paintGL() override;
 private slots:
     void cleanup();
+    void onFrameSwapped();
 private:
     bool initObjGl = false;
     bool cleaned_ = false;
@@ -42,6 +92,56 @@ private:
 
     std::unique_ptr<Renderer> renderer;
     std::unique_ptr<Texture> texture;
+    std::unique_ptr<StreamingTexture> streamTexture;
+    bool streamingUpload = true;
+    bool showStream = false;   // streamTexture holds the picture; updateText switches back to texture
+
+    struct VideoFrame {
+        int w = 0, h = 0;
+        std::shared_ptr<const std::vector<uint8_t>> pix;
+        int linesize = 0;
+        double play_sec = 0.0;
+        double pts_sec = 0.0;
+        double clock_ms = 0.0;       // steady clock at pushFrame, pairs with play_sec
+    };
+    TripleBuffer<VideoFrame> frames;
+    std::atomic<bool> repaintQueued{false};   // one update() in flight for any number of pushFrame calls
+
+    // vsync pacing, GUI thread only
+    bool framePacing = true;
+    VideoFrame pending;              // taken from frames, waiting for its vsync
+    double lastSwapMs = -1.0;
+    double refreshMs = 1000.0 / 60.0;
+    double awaitingTargetMs = -1.0;  // target of the frame uploaded in the last paint, -1 when none
+    double awaitingPts = 0.0;
+    uint64_t pendingDropped = 0;
+
+    struct PresentAcc {
+        uint64_t presented = 0, late = 0;
+        double sum = 0.0, sum_sq = 0.0, max_abs = 0.0;
+        uint64_t skipped_at_start = 0, dropped_at_start = 0;
+    } presentAcc;
+    std::vector<PresentRecord> presentRing;
+    size_t presentRingNext = 0;
+    static const int kPresentLogSize = 600;
+    double nextVsyncMs(double now_ms) const;
+
+    // CPU time spent uploading frames, logged every kUploadLogFrames while profiling
+    struct UploadTiming {
+        uint64_t frames = 0;
+        double sum_ms = 0.0;
+        double max_ms = 0.0;
+        uint64_t skipped_at_start = 0;
+    } uploadTiming;
+    static const int kUploadLogFrames = 300;
+    GlStateCache::FrameStats lastGlCalls;   // of the last paintGL, see glCallStats()
+
+    // created / dropped by paintGL (context current) as profiling is switched
+    std::unique_ptr<GlProfiler> profiler;
+    bool profiling = false;
+    bool profileOverlay = false;
+    double paintEndMs = -1.0;   // "swap" runs from here to frameSwapped
+    void drawProfileOverlay();
 
     std::unique_ptr<VertexBuffer> vb;
     std::unique_ptr<VertexArray> va;
@@ -52,6 +152,7 @@ private:
 
     // func
     void initMainRenderObject();
+    void uploadFrame(int w, int h, const uint8_t* pix, int linesize = 0);   // context current
     MdlTextCoordMatrix createAspectRatioMatrix(const int& view_port_w, const int& view_port_h, const int& img_w, const int& img_h);
 };
 
@@ -0,0 +1,51 @@
+#ifndef FRAME_TRIPLE_BUFFER_H
+#define FRAME_TRIPLE_BUFFER_H
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Lock-free single producer / single consumer triple buffer, latest wins.
+//
+// The producer fills back() and publish()es it; the consumer calls acquire()
+// and reads front(). Three slots, so neither side ever waits: publish swaps
+// the back slot with the middle one, acquire swaps the middle one with the
+// front. A frame published again before the consumer took the previous one
+// replaces it, and skipped() counts those.
+template<typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() : middle_(1), back_(2), front_(0) {}
+
+    // producer side
+    T& back() { return slots_[back_]; }
+    void publish() {
+        const uint8_t prev = middle_.exchange(uint8_t(back_ | kFresh), std::memory_order_acq_rel);
+        back_ = prev & kIndex;
+        if (prev & kFresh) skipped_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // consumer side: true when a newer frame is now in front()
+    bool acquire() {
+        if (!(middle_.load(std::memory_order_relaxed) & kFresh)) return false;
+        const uint8_t prev = middle_.exchange(front_, std::memory_order_acq_rel);
+        front_ = prev & kIndex;
+        return true;
+    }
+    const T& front() const { return slots_[front_]; }
+    T& front() { return slots_[front_]; }
+
+    uint64_t skipped() const { return skipped_.load(std::memory_order_relaxed); }
+
+private:
+    static const uint8_t kIndex = 0x3;
+    static const uint8_t kFresh = 0x4;   // middle holds a frame the consumer has not taken
+
+    T slots_[3];
+    std::atomic<uint8_t> middle_;
+    uint8_t back_;    // producer only
+    uint8_t front_;   // consumer only
+    std::atomic<uint64_t> skipped_{0};
+};
+
+#endif // FRAME_TRIPLE_BUFFER_H
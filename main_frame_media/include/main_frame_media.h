@@ -36,11 +36,7 @@ private:
     QPointer<QSlider> mediaSlider;
     std::unique_ptr<IMediaCallback>    media_callback;
 
-    std::mutex frame_mtx_;
-    int pendingFrameW_ = 0, pendingFrameH_ = 0;
-    std::shared_ptr<const std::vector<uint8_t>> pendingFramePix_;
-    std::atomic<int> play_ms_{0};
-    std::atomic_bool hasFramePending_{false};
+    std::atomic<int> play_ms_{0};   // last decoded position
 
     bool userScrubbing_ = false;
     bool isPlaying_ = false;
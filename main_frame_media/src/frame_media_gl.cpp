@@ -6,8 +6,17 @@
 
 #include <QSurfaceFormat>
 #include <QOpenGLContext>
+#include <QGuiApplication>
+#include <QScreen>
+#include <QPainter>
 
 #include <QDebug>
+#include "gl_state_cache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
 
 // Only if you're stuck with C++11
 template<typename T, typename... Args>
@@ -25,6 +34,10 @@ static void* qtGetProc(const char* name) {
 #endif
 }
 
+static double steadyMs() {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 GlFrameMedia::GlFrameMedia(QWidget* parent) : QOpenGLWidget(parent) {
     QSurfaceFormat fmt;
     fmt.setVersion(3, 3);
@@ -50,8 +63,11 @@ void GlFrameMedia::cleanup() {
     }
 
     // Destroy ALL objects that might call gl* in their destructors:
+    profiler.reset();
     renderer.reset();
     shader.reset();
+    streamTexture.reset();
+    texture.reset();
     vb.reset();
     ib.reset();
     va.reset();
@@ -66,25 +82,138 @@ void GlFrameMedia::updateText(int width, int height, const std::vector<uint8_t>&
 
         // makeCurrent();
         texture->updateText(width, height, data, 4);
+        showStream = false;
         // doneCurrent();
         update();
     }
 }
 
 void GlFrameMedia::submitFrame(int w, int h, std::shared_ptr<const std::vector<uint8_t>> pix) {
-    /*
-    {
-        std::lock_guard<std::mutex> lk(frame_mtx_);
-        pendingFrameW_ = w;
-        pendingFrameH_ = h;
-        pendingFramePix_ = std::move(pix);
+    if (!va || !pix || pix->size() < size_t(w) * size_t(h) * 4) return;
+
+    makeCurrent();
+    uploadFrame(w, h, pix->data());
+    doneCurrent();
+    update();
+}
+
+void GlFrameMedia::pushFrame(int w, int h, std::shared_ptr<const std::vector<uint8_t>> pix, double play_sec, double pts_sec,
+                             int linesize) {
+    VideoFrame& f = frames.back();
+    f.w = w;
+    f.h = h;
+    f.pix = std::move(pix);
+    f.linesize = linesize > 0 ? linesize : w * 4;
+    f.play_sec = play_sec;
+    f.pts_sec = pts_sec;
+    f.clock_ms = steadyMs();
+    frames.publish();
+
+    if (!repaintQueued.exchange(true)) {
+        QMetaObject::invokeMethod(this, [this] { update(); }, Qt::QueuedConnection);
     }
-    hasFramePending_.store(true, std::memory_order_release);
-    */
-    if (va) {
-        texture->updateText(w, h, *pix, 4);
-        update();
+}
+
+void GlFrameMedia::uploadFrame(int w, int h, const uint8_t* pix, int linesize) {
+    const auto t0 = std::chrono::steady_clock::now();
+    if (streamingUpload) {
+        if (!streamTexture) streamTexture = make_unique<StreamingTexture>(w, h, TextureFormat::RGBA8);
+        // copy into the mapped PBO and queue the texture copy, no wait on the driver
+        streamTexture->Upload(w, h, pix, linesize);
+    } else {
+        // padded rows straight from the decoder buffer via GL_UNPACK_ROW_LENGTH
+        texture->updateText(w, h, static_cast<const void*>(pix), TextureFormat::RGBA8, linesize / 4);
+    }
+    showStream = streamingUpload;
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+    uploadTiming.frames++;
+    uploadTiming.sum_ms += ms;
+    uploadTiming.max_ms = std::max(uploadTiming.max_ms, ms);
+    if (uploadTiming.frames % kUploadLogFrames == 0) {
+        const uint64_t skipped = frames.skipped();
+        if (profiling) {
+            qDebug() << "Frame upload" << (streamingUpload ? (streamTexture->IsPersistent() ? "pbo/persistent" : "pbo/orphan") : "sync")
+                     << w << "x" << h << "avg" << uploadTiming.sum_ms / double(uploadTiming.frames)
+                     << "ms max" << uploadTiming.max_ms << "ms skipped" << int(skipped - uploadTiming.skipped_at_start);
+        }
+        uploadTiming = UploadTiming();
+        uploadTiming.skipped_at_start = skipped;
+    }
+}
+
+double GlFrameMedia::nextVsyncMs(double now_ms) const {
+    if (lastSwapMs < 0.0) return now_ms;
+    const double k = std::max(1.0, std::ceil((now_ms - lastSwapMs) / refreshMs));
+    return lastSwapMs + k * refreshMs;
+}
+
+void GlFrameMedia::onFrameSwapped() {
+    const double now = steadyMs();
+    if (profiler && paintEndMs >= 0.0) profiler->AddCpuSample("swap", now - paintEndMs);
+    if (lastSwapMs >= 0.0) {
+        // back to back swaps only; idle gaps say nothing about the refresh rate
+        const double d = now - lastSwapMs;
+        if (d > refreshMs * 0.5 && d < refreshMs * 1.5) refreshMs += (d - refreshMs) * 0.05;
+    }
+    lastSwapMs = now;
+
+    if (awaitingTargetMs >= 0.0) {
+        const double err = now - awaitingTargetMs;
+        presentAcc.presented++;
+        presentAcc.sum += err;
+        presentAcc.sum_sq += err * err;
+        presentAcc.max_abs = std::max(presentAcc.max_abs, std::fabs(err));
+        if (err > refreshMs) presentAcc.late++;
+
+        const PresentRecord rec = { awaitingPts, awaitingTargetMs, now };
+        if (presentRing.size() < size_t(kPresentLogSize)) presentRing.push_back(rec);
+        else presentRing[presentRingNext] = rec;
+        presentRingNext = (presentRingNext + 1) % size_t(kPresentLogSize);
+        awaitingTargetMs = -1.0;
+
+        if (profiling && presentAcc.presented % kUploadLogFrames == 0) {
+            // cumulative: only resetPresentStats() starts a new window
+            const PresentStats st = presentStats();
+            qDebug() << "Present" << int(st.presented) << "frames, refresh" << st.refresh_ms
+                     << "ms, error mean" << st.mean_error_ms << "ms judder" << st.judder_ms
+                     << "ms max" << st.max_error_ms << "ms, late" << int(st.late) << "dropped" << int(st.dropped);
+        }
+    }
+
+    // a frame is waiting for a later vsync: look again after the next one
+    if (pending.pix) update();
+}
+
+GlFrameMedia::PresentStats GlFrameMedia::presentStats() const {
+    PresentStats st;
+    st.presented = presentAcc.presented;
+    st.late = presentAcc.late;
+    st.dropped = (frames.skipped() - presentAcc.skipped_at_start) + (pendingDropped - presentAcc.dropped_at_start);
+    st.refresh_ms = refreshMs;
+    if (st.presented > 0) {
+        const double n = double(st.presented);
+        st.mean_error_ms = presentAcc.sum / n;
+        st.judder_ms = std::sqrt(std::max(0.0, presentAcc.sum_sq / n - st.mean_error_ms * st.mean_error_ms));
+        st.max_error_ms = presentAcc.max_abs;
+    }
+    return st;
+}
+
+void GlFrameMedia::resetPresentStats() {
+    presentAcc = PresentAcc();
+    presentAcc.skipped_at_start = frames.skipped();
+    presentAcc.dropped_at_start = pendingDropped;
+}
+
+std::vector<GlFrameMedia::PresentRecord> GlFrameMedia::presentLog() const {
+    std::vector<PresentRecord> out;
+    out.reserve(presentRing.size());
+    const size_t start = presentRing.size() < size_t(kPresentLogSize) ? 0 : presentRingNext;
+    for (size_t i = 0; i < presentRing.size(); ++i) {
+        out.push_back(presentRing[(start + i) % presentRing.size()]);
     }
+    return out;
 }
 
 void GlFrameMedia::initializeGL() {
@@ -94,6 +223,10 @@ void GlFrameMedia::initializeGL() {
     qDebug() << "GL:" << (const char*)glGetString(GL_VERSION);
     connect(context(), &QOpenGLContext::aboutToBeDestroyed,
             this, &GlFrameMedia::cleanup, Qt::DirectConnection);
+    connect(this, &QOpenGLWidget::frameSwapped, this, &GlFrameMedia::onFrameSwapped);
+    if (QScreen* screen = QGuiApplication::primaryScreen()) {
+        if (screen->refreshRate() > 1.0) refreshMs = 1000.0 / screen->refreshRate();
+    }
 
     initMainRenderObject();
     renderer = make_unique<Renderer>();
@@ -122,23 +255,102 @@ void GlFrameMedia::resizeGL(int w, int h) {
 }
 
 void GlFrameMedia::paintGL() {
-    renderer->Clear();
+    // cleared first: a frame pushed from here on queues the next repaint
+    repaintQueued.store(false);
+    if (profiling && !profiler) profiler = make_unique<GlProfiler>();
+    else if (!profiling && profiler) profiler.reset();
+    if (profiler) profiler->BeginFrame();
+    GlStateCache::BeginFrame();
+    if (frames.acquire()) {
+        // a frame still waiting for its vsync was overtaken by a newer one
+        if (pending.pix) ++pendingDropped;
+        pending = frames.front();
+    }
+    if (pending.pix) {
+        // steady clock time the frame is due, from the audio clock sampled at pushFrame
+        double target_ms = pending.clock_ms + (pending.pts_sec - pending.play_sec) * 1000.0;
+        bool due = true;
+        if (framePacing) {
+            // show it at the vsync nearest its target
+            due = nextVsyncMs(steadyMs()) >= target_ms - refreshMs * 0.5;
+        } else {
+            target_ms = steadyMs();
+        }
+        if (due) {
+            // the last row needs no padding after it
+            const size_t need = size_t(pending.linesize) * size_t(std::max(0, pending.h - 1)) + size_t(pending.w) * 4;
+            if (va && pending.h > 0 && pending.linesize >= pending.w * 4 && pending.pix->size() >= need) {
+                GlProfiler::Scope prof(profiler.get(), "upload");
+                uploadFrame(pending.w, pending.h, pending.pix->data(), pending.linesize);
+                awaitingTargetMs = target_ms;
+                awaitingPts = pending.pts_sec;
+                emit framePresented(pending.pts_sec);
+            }
+            pending = VideoFrame();
+        }
+    }
 
-    shader->Bind();
-    texture->Bind(0);
+    {
+        GlProfiler::Scope prof(profiler.get(), "draw");
+        renderer->Clear();
 
-    shader->SetUniform1i("u_Texture", 0);
+        shader->Bind();
+        if (showStream && streamTexture) streamTexture->Bind(0);
+        else texture->Bind(0);
 
-    renderer->Draw(*va, *ib, *shader);
+        shader->SetUniform1i("u_Texture", 0);
 
-    ib->Unbind();
-    va->Unbind();
-    shader->Unbind();
+        renderer->Draw(*va, *ib, *shader);
+
+        ib->Unbind();
+        va->Unbind();
+        shader->Unbind();
+    }
+    GlStateCache::EndFrame();
+    lastGlCalls = GlStateCache::LastFrame();
+    if (profiler) {
+        profiler->EndFrame();
+        paintEndMs = steadyMs();
+        if (profileOverlay) drawProfileOverlay();
+    }
+}
+
+void GlFrameMedia::setProfiling(bool on, bool overlay) {
+    profiling = on;
+    profileOverlay = on && overlay;
+    update();
+}
+
+bool GlFrameMedia::dumpProfile(const QString& path) const {
+    return profiler && profiler->DumpCsv(path.toStdString());
+}
+
+void GlFrameMedia::drawProfileOverlay() {
+    // QPainter after the GL draws; the next paintGL starts from a forgotten state cache anyway
+    QPainter painter(this);
+    QFont font("Monospace");
+    font.setStyleHint(QFont::TypeWriter);
+    font.setPointSize(8);
+    painter.setFont(font);
+    painter.setPen(Qt::yellow);
+    painter.drawText(rect().adjusted(6, 4, -6, -4), Qt::AlignTop | Qt::AlignLeft,
+                     QString::fromStdString(profiler->Summary()));
 }
 
 void GlFrameMedia::initMainRenderObject() {
 
-    MdlImageByte img = Texture::loadImageByte("/home/virus/Pictures/f_1.png", false);
+    MdlImageByte img;
+    try {
+        img = Texture::loadImageByte("/home/virus/Pictures/f_1.png", false);
+    } catch (const std::runtime_error& e) {
+        // not on this machine (or headless): a black 16:9 placeholder until the first frame
+        qDebug() << e.what();
+        img.width = 16;
+        img.height = 9;
+        img.channels = 4;
+        img.pixels.assign(size_t(img.width) * size_t(img.height) * 4, 0);
+        for (size_t i = 3; i < img.pixels.size(); i += 4) img.pixels[i] = 255;
+    }
     // MdlImageByte img = Texture::loadImageByte("/home/virus/Pictures/shot0002.png");
     this->obj_width = img.width;
     this->obj_height = img.height;
@@ -75,6 +75,15 @@ MainFrameMedia::MainFrameMedia(QWidget* parent) : QFrame(parent), media_callback
         glFrameMedia = new GlFrameMedia(panel);
         glFrameMedia->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
         parent_of_gl->addWidget(glFrameMedia, 1);
+
+        // slider follows what is on screen, not what was decoded last
+        connect(glFrameMedia, &GlFrameMedia::framePresented, this, [this](double sec) {
+            if (!mediaSlider || mediaSlider->isSliderDown()) return;
+            QSignalBlocker b(*mediaSlider);
+
+            this->play_sec = sec;
+            mediaSlider->setValue(int(sec * 1000.0));
+        });
     }
 }
 
@@ -245,8 +254,8 @@ void MainFrameMedia::onPlayPauseMedia() {
 
                 double duration = this->audio_obj.num_sample() / this->audio_obj.sample_rate;
                 ffmpeg_reader_player->media_load_chunk_playback(
-                    [this](int w, int h, std::shared_ptr<const std::vector<uint8_t>> pixels, int channel,
-                           const double& play_sec, bool done){
+                    [this](int w, int h, std::shared_ptr<const std::vector<uint8_t>> pixels, int linesize, int channel,
+                           const double& play_sec, const double& pts_sec, bool done){
 
                         if (done) {
                             qDebug() << "End";
@@ -267,42 +276,10 @@ void MainFrameMedia::onPlayPauseMedia() {
                         }
                         //media_callback->update_played_audio(play_sec);
 
-                        {
-                            std::lock_guard<std::mutex> lk(frame_mtx_);
-                            pendingFrameW_ = w;
-                            pendingFrameH_ = h;
-                            play_ms_.store(int(play_sec * 1000.0), std::memory_order_relaxed);
-                            pendingFramePix_ = std::move(pixels);
-                        }
-
-                        if (!hasFramePending_.exchange(true)) {
-                            // start update
-                            media_callback->update_played_audio(play_sec);
-                            // qDebug() << "Update: " << std::to_string(play_sec).c_str();
-                            int w, h;
-                            std::shared_ptr<const std::vector<uint8_t>> pix;
-                            {
-                                std::lock_guard<std::mutex> lk(frame_mtx_);
-                                w = pendingFrameW_;
-                                h = pendingFrameH_;
-                                pix = pendingFramePix_;
-                            }
-
-                            if (pix) {
-                                if (!glFrameMedia) return;
-
-                                QMetaObject::invokeMethod(this, [this, w, h, pix] {
-                                        glFrameMedia->submitFrame(w, h, std::move(pix));
-
-                                        if (!mediaSlider || mediaSlider->isSliderDown()) return;
-                                        QSignalBlocker b(*mediaSlider);
-
-                                        this->play_sec = play_ms_.load(std::memory_order_relaxed) / 1000.0;
-                                        mediaSlider->setValue(play_ms_.load(std::memory_order_relaxed));
-                                    }, Qt::QueuedConnection);
-                            }
-                            hasFramePending_.store(false);
-                        }
+                        play_ms_.store(int(play_sec * 1000.0), std::memory_order_relaxed);
+                        media_callback->update_played_audio(play_sec);
+                        // latest wins: no lock and no queued lambda per frame, paintGL pulls it
+                        if (pixels && glFrameMedia) glFrameMedia->pushFrame(w, h, std::move(pixels), play_sec, pts_sec, linesize);
 
                 }, [this](const double& start_sec, const std::string& message) {
                         /*
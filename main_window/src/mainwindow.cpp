@@ -105,6 +105,19 @@ void MainWindow::createMenu() {
     open->setShortcuts(QKeySequence::Open);
     connect(open, &QAction::triggered, this, &MainWindow::onOpenFile);
 
+    // labels of the open media; CSV or JSON by extension
+    const QString labelFilter = "Labels (*.csv *.json);;CSV (*.csv);;JSON (*.json)";
+    QAction *importLabels = file->addAction("Import Labels...");
+    connect(importLabels, &QAction::triggered, this, [this, labelFilter] {
+        const QString path = QFileDialog::getOpenFileName(this, tr("Import Labels"), QDir::homePath(), labelFilter);
+        if (!path.isEmpty() && glSpecView) glSpecView->importLabels(path);
+    });
+    QAction *exportLabels = file->addAction("Export Labels...");
+    connect(exportLabels, &QAction::triggered, this, [this, labelFilter] {
+        const QString path = QFileDialog::getSaveFileName(this, tr("Export Labels"), QDir::homePath() + "/labels.csv", labelFilter);
+        if (!path.isEmpty() && glSpecView) glSpecView->exportLabels(path);
+    });
+
     file->addSeparator();
     file->addAction(tr("E&xit"), this, &QWidget::close, QKeySequence::Quit);
 
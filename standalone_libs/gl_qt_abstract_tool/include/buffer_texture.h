@@ -0,0 +1,37 @@
+#ifndef BUFFER_TEXTURE_H
+#define BUFFER_TEXTURE_H
+#pragma once
+
+#include "gl_glad_helper.h"
+
+#include <cstddef>
+
+// GL_TEXTURE_BUFFER: a plain buffer object read in shaders with texelFetch(samplerBuffer, i).
+// One dimensional and much larger than a 2D texture row (GL_MAX_TEXTURE_BUFFER_SIZE texels),
+// no filtering / mipmaps. internal_format is a sized format such as GL_RGBA16F or GL_R32F.
+class BufferTexture {
+private:
+    GLuint bufferID;
+    GLuint textureID;
+    GLenum internalFormat;
+    size_t bytes;
+public:
+    BufferTexture(const void* data, size_t size_bytes, GLenum internal_format, GLenum usage = GL_STATIC_DRAW);
+    ~BufferTexture();
+
+    BufferTexture(const BufferTexture&) = delete;
+    BufferTexture& operator=(const BufferTexture&) = delete;
+
+    // reallocates when size_bytes differs, otherwise sub-data
+    void UpdateData(const void* data, size_t size_bytes);
+
+    void Bind(unsigned int slot = 0) const;
+    void Unbind() const;
+
+    inline size_t GetBytes() const { return bytes; }
+
+    // texels a buffer texture may address on this context
+    static GLint MaxTexels();
+};
+
+#endif // BUFFER_TEXTURE_H
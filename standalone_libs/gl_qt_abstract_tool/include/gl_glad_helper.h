@@ -2,6 +2,7 @@
 #define GL_GLAD_HELPER_H
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <glad/glad.h>
 
@@ -23,6 +24,8 @@ public:
         std::string fragment;
     };
     static void GLClearError();
+    // GLCall invocations so far (each one starts with GLClearError), for per-frame counters
+    static uint64_t CallCount();
     static bool GlLogCall(const char* function, const char* file, int line);
     static GLboolean check_error_glsl(const GLuint& shader, const std::string &shader_name);
     static GLuint compile_shader(const std::string& vertexShader, const std::string& fragmentShader);
@@ -0,0 +1,124 @@
+#ifndef GL_PROFILER_H
+#define GL_PROFILER_H
+#pragma once
+
+#include "gl_glad_helper.h"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Named CPU / GPU timing regions for a paint path.
+//
+// A region measures steady_clock time on the CPU and, when timer queries are
+// there (GL 3.3 / ARB_timer_query), GPU time between two glQueryCounter
+// timestamps. Query results are never waited for: a frame's queries sit in a
+// ring of kFrames and are read back at a later BeginFrame() once available; if
+// the ring comes around before the GPU is done, that frame's GPU samples are
+// dropped (DroppedGpuFrames()).
+//
+// Every region keeps its last `window` samples, Stats() gives percentiles over
+// them. BeginFrame/EndFrame open the region "frame" around everything.
+//
+// One profiler per context; all calls with that context current.
+class GlProfiler {
+public:
+    struct RegionStats {
+        std::string name;
+        size_t cpu_samples = 0;
+        double cpu_p50 = 0.0, cpu_p95 = 0.0, cpu_p99 = 0.0, cpu_max = 0.0;   // ms
+        size_t gpu_samples = 0;                                             // 0 without timer queries
+        double gpu_p50 = 0.0, gpu_p95 = 0.0, gpu_p99 = 0.0, gpu_max = 0.0;
+    };
+
+    // RAII region; does nothing for a null profiler, so call sites need no branch
+    class Scope {
+    public:
+        Scope(GlProfiler* profiler, const char* name)
+            : profiler(profiler), token(profiler ? profiler->BeginRegion(name) : -1) {}
+        ~Scope() { if (profiler) profiler->EndRegion(token); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        GlProfiler* profiler;
+        int token;
+    };
+
+    explicit GlProfiler(int window = 240);
+    ~GlProfiler();
+
+    GlProfiler(const GlProfiler&) = delete;
+    GlProfiler& operator=(const GlProfiler&) = delete;
+
+    static bool HasTimerQuery();
+    inline bool IsGpuTiming() const { return gpuTiming; }
+
+    void BeginFrame();
+    void EndFrame();
+
+    // regions may nest; EndRegion takes what BeginRegion returned
+    int BeginRegion(const char* name);
+    void EndRegion(int token);
+    // a CPU time measured elsewhere (e.g. paint end -> frameSwapped)
+    void AddCpuSample(const char* name, double ms);
+
+    // regions in first use order
+    std::vector<RegionStats> Stats() const;
+    // one line per region, for an overlay
+    std::string Summary() const;
+    // Stats() as CSV; false when the file cannot be written
+    bool DumpCsv(const std::string& path) const;
+
+    inline uint64_t Frames() const { return frames; }
+    inline uint64_t DroppedGpuFrames() const { return droppedGpuFrames; }
+
+private:
+    static const int kFrames = 4;
+
+    struct Window {
+        std::vector<double> samples;
+        size_t next = 0;
+        void add(double v, size_t cap);
+    };
+    struct Region {
+        std::string name;
+        Window cpu;
+        Window gpu;
+    };
+    struct Open {
+        int region;
+        std::chrono::steady_clock::time_point t0;
+        int query;          // index of the begin timestamp in the frame's pool, -1 without GPU timing
+    };
+    struct Timed {
+        int region;
+        int q0, q1;
+    };
+    struct FrameQueries {
+        std::vector<GLuint> pool;
+        int used = 0;
+        std::vector<Timed> timed;
+        bool pending = false;   // ended, results not read yet
+    };
+
+    int region(const char* name);
+    int timestamp();            // next query of the current frame, issued now
+    void collect();             // reads back every finished frame
+
+    size_t window;
+    bool gpuTiming;
+    bool inFrame = false;
+    int frameToken = -1;
+    int current = 0;
+    uint64_t frames = 0;
+    uint64_t droppedGpuFrames = 0;
+
+    std::vector<Region> regions;
+    std::unordered_map<std::string, int> regionIndex;
+    std::vector<Open> open;
+    FrameQueries ring[kFrames];
+};
+
+#endif // GL_PROFILER_H
@@ -0,0 +1,50 @@
+#ifndef GL_STATE_CACHE_H
+#define GL_STATE_CACHE_H
+#pragma once
+
+#include "gl_glad_helper.h"
+
+#include <cstdint>
+
+// Shadow of the GL binding state (program, vertex array, element buffer per vertex
+// array, 2D / buffer texture per unit, active unit) so repeated binds are dropped.
+//
+// Only trusted between BeginFrame() and EndFrame() (e.g. the body of paintGL):
+// BeginFrame forgets everything, so state changed by Qt or another context in
+// between cannot leak in. Outside a frame every call goes straight to GL.
+// Inside a frame the Unbind() of Shader / VertexArray / IndexBuffer / Texture is
+// skipped, the next Bind() replaces the binding anyway; EndFrame unbinds the
+// vertex array so setup code outside a frame cannot edit it by accident.
+//
+// GL thread only, one frame at a time.
+class GlStateCache {
+public:
+    struct FrameStats {
+        uint64_t gl_calls = 0;   // GLCall invocations between BeginFrame and EndFrame
+        uint64_t skipped = 0;    // binds / unbinds / uniform updates that were redundant
+    };
+
+    static void BeginFrame();
+    static void EndFrame();
+    static bool InFrame();
+    static const FrameStats& LastFrame();
+
+    static void UseProgram(GLuint program);
+    static void BindVertexArray(GLuint vao);
+    static void BindElementBuffer(GLuint buffer);            // recorded for the bound vertex array
+    static void ActiveTexture(unsigned int unit);
+    static void BindTexture(GLenum target, GLuint texture);  // on the active unit
+    static void BindTexture(unsigned int unit, GLenum target, GLuint texture);
+
+    // true (and counted) when an Unbind() can be left out
+    static bool SkipUnbind();
+    static void CountSkipped();
+
+    // names being deleted, so a recycled name is not mistaken for a bound one
+    static void ForgetProgram(GLuint program);
+    static void ForgetVertexArray(GLuint vao);
+    static void ForgetTexture(GLuint texture);
+    static void ForgetBuffer(GLuint buffer);
+};
+
+#endif // GL_STATE_CACHE_H
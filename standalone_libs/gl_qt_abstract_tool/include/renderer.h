@@ -9,7 +9,11 @@
 class Renderer {
 public:
     void Draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, GLenum mode = GL_TRIANGLES);
-    void DrawWithoutIndexBuffer(const VertexArray& va, const Shader& shader, const int &count, GLenum mode = GL_POINTS);
+    // first: vertex the draw starts at (e.g. StreamingVertexBuffer::Commit())
+    void DrawWithoutIndexBuffer(const VertexArray& va, const Shader& shader, const int &count, GLenum mode = GL_POINTS, GLint first = 0);
+    // count vertices per instance (e.g. 4 for a gl_VertexID quad), per instance data from a layout with a divisor
+    void DrawInstanced(const VertexArray& va, const Shader& shader, const int &count, const int &instances,
+                       GLenum mode = GL_TRIANGLE_STRIP);
     void Clear() const;
 };
 
@@ -13,6 +13,12 @@ private:
     std::string filepath;
     GLuint program;
     std::unordered_map<std::string, int> uniformsLocationCache;
+    // last value sent per location; the program keeps it, so an equal value is not sent again
+    struct UniformValue {
+        size_t size = 0;
+        float data[16];
+    };
+    std::unordered_map<int, UniformValue> uniformsValueCache;
 public:
     Shader(const std::string& file_path);
     ~Shader();
@@ -24,11 +30,14 @@ public:
     void SetUniform1i(const std::string& name, int value);
     void SetUniform1f(const std::string& name, float value);
     void SetUniform1iv(const std::string& name, const std::vector<int>& values);
+    void SetUniform2f(const std::string& name, float v0, float v1);
     void SetUniform4f(const std::string& name, float v0, float v1, float v2, float v3);
     void SetUniformMat4f(const std::string& name, const glm::mat4& matrix);
 private:
     // bool CompileShader();
     int GetUniformLocation(const std::string& name);
+    // true when loc already holds value (program must be bound)
+    bool uniformUnchanged(int loc, const void* value, size_t bytes);
 };
 
 #endif // SHADER_H
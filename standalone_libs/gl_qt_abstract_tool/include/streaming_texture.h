@@ -0,0 +1,85 @@
+#ifndef STREAMING_TEXTURE_H
+#define STREAMING_TEXTURE_H
+#pragma once
+
+#include "gl_glad_helper.h"
+#include "texture.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Texture fed through a ring of pixel unpack buffers (PBOs) so a frame upload
+// returns as soon as the pixels are in GL owned memory; the PBO -> texture copy
+// runs asynchronously on the GPU side.
+//
+// With GL 4.4 / ARB_buffer_storage every slot is mapped once (persistent, coherent)
+// and guarded by a fence (a fence that does not signal within 1 s falls back to
+// glFinish, the storage is immutable); otherwise each upload orphans its slot with glBufferData
+// and maps it with MAP_INVALIDATE_BUFFER.
+//
+// All calls need the GL context current. The pointer from MapNext() may be filled
+// from any thread before Commit() when IsPersistent() is true.
+class StreamingTexture {
+public:
+    struct Stats {
+        uint64_t uploads = 0;
+        uint64_t fence_waits = 0;   // MapNext had to block on a slot still in flight
+        uint64_t fence_timeouts = 0;  // ... and the fence did not signal in 1 s: glFinish before the write
+        double last_ms = 0.0;       // CPU time of the last Upload()
+        double avg_ms = 0.0;        // running mean
+        double max_ms = 0.0;
+    };
+
+    StreamingTexture(int width, int height, TextureFormat fmt = TextureFormat::RGBA8, int slots = 3);
+    ~StreamingTexture();
+
+    StreamingTexture(const StreamingTexture&) = delete;
+    StreamingTexture& operator=(const StreamingTexture&) = delete;
+
+    // next free slot, GetFrameBytes() bytes of tightly packed rows
+    void* MapNext();
+    // queue the slot filled since MapNext() for the texture
+    void Commit();
+    // MapNext + copy + Commit; reallocates when the size changes. row_bytes = source stride when rows
+    // are padded (0 = tightly packed), the slot is always filled tight
+    void Upload(int width, int height, const void* data, int row_bytes = 0);
+
+    void Resize(int width, int height);
+    void SetFilter(GLenum filter) { texture->SetFilter(filter); }
+
+    void Bind(unsigned int slot = 0) const { texture->Bind(slot); }
+    void Unbind() const { texture->Unbind(); }
+
+    inline int GetWidth() const { return width; }
+    inline int GetHeight() const { return height; }
+    inline size_t GetFrameBytes() const { return frameBytes; }
+    inline bool IsPersistent() const { return persistent; }
+    inline const Stats& GetStats() const { return stats; }
+
+    static bool HasBufferStorage();
+
+private:
+    struct Slot {
+        GLuint pbo = 0;
+        void* mapped = nullptr;   // persistent mapping, nullptr in orphan mode
+        GLsync fence = nullptr;
+    };
+
+    void createSlots();
+    void destroySlots();
+
+    std::unique_ptr<Texture> texture;
+    TextureFormat format;
+    int width, height;
+    size_t frameBytes;
+    bool persistent;
+
+    std::vector<Slot> slots;
+    int current = -1;   // slot handed out by MapNext, -1 when none
+    int next = 0;
+
+    Stats stats;
+};
+
+#endif // STREAMING_TEXTURE_H
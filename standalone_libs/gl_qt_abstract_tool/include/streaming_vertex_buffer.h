@@ -0,0 +1,91 @@
+#ifndef STREAMING_VERTEX_BUFFER_H
+#define STREAMING_VERTEX_BUFFER_H
+#pragma once
+
+#include "gl_glad_helper.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// GL_ARRAY_BUFFER for geometry that is rewritten every view / frame.
+//
+// With GL 4.4 / ARB_buffer_storage the buffer is split into `segments` equal
+// ranges, mapped once (persistent, coherent); each write takes the next range
+// and EndFrame() fences the ranges written or drawn this frame, so a range is
+// only reused once the GPU is done with it (a fence that does not signal within
+// 1 s falls back to glFinish, the storage is immutable). Data drawn again in a later frame
+// without a new write has to be passed to MarkDrawn(), or its range is not
+// fenced for that draw. Otherwise every write orphans the whole buffer
+// (glBufferData(nullptr)) and maps it with MAP_INVALIDATE_BUFFER.
+//
+// Capacity grows geometrically (x2) when a write does not fit. Growing in
+// persistent mode needs a new buffer object, so GetGeneration() changes and the
+// vertex array has to be pointed at it again (VertexArray::AddBuffer).
+//
+// Draw with the first vertex returned by Commit() / Write(). Context current for all calls.
+class StreamingVertexBuffer {
+public:
+    struct Stats {
+        uint64_t writes = 0;
+        uint64_t reallocs = 0;
+        uint64_t fence_waits = 0;    // MapNext had to block on a range still in flight
+        uint64_t fence_timeouts = 0; // ... and the fence did not signal in 1 s: glFinish before the write
+        size_t frame_bytes = 0;      // streamed since the last EndFrame()
+        size_t last_frame_bytes = 0; // of the previous frame
+        uint64_t total_bytes = 0;
+    };
+
+    // stride: bytes per vertex, ranges start on a whole vertex
+    StreamingVertexBuffer(GLuint stride, size_t initial_bytes = 64 * 1024, int segments = 3);
+    ~StreamingVertexBuffer();
+
+    StreamingVertexBuffer(const StreamingVertexBuffer&) = delete;
+    StreamingVertexBuffer& operator=(const StreamingVertexBuffer&) = delete;
+
+    // room for `bytes` to fill before Commit(); nullptr when mapping failed
+    void* MapNext(size_t bytes);
+    // returns the first vertex of the data filled since MapNext()
+    GLint Commit();
+    // MapNext + copy + Commit
+    GLint Write(const void* data, size_t bytes);
+    // the range holding `first` (from Commit() / Write()) is read by a draw this frame
+    void MarkDrawn(GLint first);
+    // after the draws that read this frame's data
+    void EndFrame();
+
+    void Bind() const;
+    void Unbind() const;
+
+    inline GLuint GetStride() const { return stride; }
+    inline size_t GetCapacity() const { return segmentBytes; }   // largest single write without growing
+    inline uint32_t GetGeneration() const { return generation; }
+    inline bool IsPersistent() const { return persistent; }
+    inline const Stats& GetStats() const { return stats; }
+
+private:
+    struct Segment {
+        GLsync fence = nullptr;
+        bool used = false;      // written or drawn since the last EndFrame()
+    };
+
+    void create(size_t segment_bytes);
+    void destroy();
+    void grow(size_t bytes);
+
+    GLuint rendererID = 0;
+    GLuint stride;
+    size_t segmentBytes = 0;
+    bool persistent;
+    char* mapped = nullptr;     // persistent mapping of the whole buffer
+
+    std::vector<Segment> segments;
+    int current = -1;           // range handed out by MapNext, -1 when none
+    int next = 0;
+    size_t pendingBytes = 0;
+    uint32_t generation = 0;
+
+    Stats stats;
+};
+
+#endif // STREAMING_VERTEX_BUFFER_H
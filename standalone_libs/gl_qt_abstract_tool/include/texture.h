@@ -16,7 +16,9 @@ struct MdlImageByte {
 enum class TextureFormat {
     R8,
     RGB8,
-    RGBA8
+    RGBA8,
+    R16F,
+    R32F
 };
 
 class Texture {
@@ -29,7 +31,19 @@ private:
     GLint internalFormat;
     GLenum format;
 
+    GLenum type = GL_UNSIGNED_BYTE;
+    bool immutable = false;   // storage from glTexStorage2D, a new size needs a new texture name
+
+    // (re)allocates width x height of the current format and uploads data when given
+    void allocate(const void* data, int row_pixels);
+
     static void getGLFormat(TextureFormat fmt, GLint& internalFormat, GLenum& format) {
+        GLenum type;
+        getGLFormat(fmt, internalFormat, format, type);
+    }
+
+    static void getGLFormat(TextureFormat fmt, GLint& internalFormat, GLenum& format, GLenum& type) {
+        type = GL_UNSIGNED_BYTE;
         switch (fmt) {
         case TextureFormat::R8:
             internalFormat = GL_R8;
@@ -43,6 +57,16 @@ private:
             internalFormat = GL_RGBA8;
             format = GL_RGBA;
             break;
+        case TextureFormat::R16F:
+            internalFormat = GL_R16F;
+            format = GL_RED;
+            type = GL_HALF_FLOAT;
+            break;
+        case TextureFormat::R32F:
+            internalFormat = GL_R32F;
+            format = GL_RED;
+            type = GL_FLOAT;
+            break;
         }
     }
 
@@ -53,8 +77,25 @@ public:
     Texture(int width_pixel, int height_pixel, const std::vector<float>& tileXYZ);
     Texture(int width, int height, const std::vector<uint8_t>& data, int channel = 1);
     void updateText(int width, int height, const std::vector<uint8_t>& data, int channel = 1);
+    // raw texels in fmt layout (e.g. uint16_t halves for R16F); sub-image upload while size/format match.
+    // Storage is immutable (glTexStorage2D) where available. row_pixels = row length of data when it is
+    // wider than width, e.g. a padded decoder linesize / bytes per pixel (0 = tightly packed)
+    Texture(int width, int height, const void* data, TextureFormat fmt);
+    void updateText(int width, int height, const void* data, TextureFormat fmt, int row_pixels = 0);
     ~Texture();
 
+    // GL_NEAREST / GL_LINEAR for both min and mag
+    void SetFilter(GLenum filter);
+    // GL_CLAMP_TO_EDGE / GL_REPEAT per axis
+    void SetWrap(GLenum wrap_s, GLenum wrap_t);
+    // texels [x, x + w) x [y, y + h) in the current format; row_pixels = row length of data when it
+    // is wider than w (0 = tightly packed)
+    void UpdateRegion(int x, int y, int w, int h, const void* data, int row_pixels = 0);
+
+    static int BytesPerPixel(TextureFormat fmt);
+    // GL 4.2 / ARB_texture_storage
+    static bool HasTexStorage();
+
     void Bind(unsigned int slot = 0) const;
     void Unbind() const;
 
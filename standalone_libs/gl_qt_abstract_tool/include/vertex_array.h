@@ -3,6 +3,7 @@
 
 #include <glad/glad.h>
 #include "vertex_buffer.h"
+#include "streaming_vertex_buffer.h"
 #include "vertex_buffer_layout.h"
 
 class VertexArray {
@@ -13,8 +14,12 @@ public:
     ~VertexArray();
 
     void AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout) const;
+    // again whenever vb.GetGeneration() changes
+    void AddBuffer(const StreamingVertexBuffer& vb, const VertexBufferLayout& layout) const;
     void Bind() const;
     void Unbind() const;
+private:
+    void setAttributes(const VertexBufferLayout& layout) const;
 };
 
 #endif // VERTEX_ARRAY_H
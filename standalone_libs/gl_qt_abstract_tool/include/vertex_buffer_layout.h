@@ -25,8 +25,9 @@ class VertexBufferLayout {
 private:
     std::vector<VertexBufferElement> elements;
     GLuint stride;
+    GLuint divisor;
 public:
-    VertexBufferLayout() : stride(0) {
+    VertexBufferLayout() : stride(0), divisor(0) {
     }
 
     template<typename T>
@@ -43,6 +44,9 @@ public:
 
     inline std::vector<VertexBufferElement> GetElements() const {return elements;}
     inline GLuint GetStride() const {return stride;}
+    // 1: every attribute of this layout advances per instance (glVertexAttribDivisor), 0: per vertex
+    inline void SetDivisor(GLuint d) {divisor = d;}
+    inline GLuint GetDivisor() const {return divisor;}
 };
 
 #endif // VERTEX_BUFFER_LAYOUT_H
@@ -1,14 +1,39 @@
 #shader vertex
 #version 330 core
 
-layout(location=0) in vec2 aPos;
-layout(location=1) in vec4 aCol;
+// One instance per quad, no per-vertex data: corners come from gl_VertexID
+// (triangle strip of 4). Rects are in framebuffer pixels, y down.
+
+layout(location=0) in vec4 aRect;   // x0, y0, x1, y1
+layout(location=1) in vec4 aUv;     // glyph rect in the atlas; u0 < 0: solid quad
+layout(location=2) in vec4 aCol;
+
+uniform vec2 u_Viewport;            // framebuffer size in pixels
+
+out vec2 vUv;
 out vec4 vCol;
-void main() { gl_Position = vec4(aPos, 0.0, 1.0); vCol = aCol; }
+flat out int vSolid;
+
+void main() {
+    vec2 c = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1));
+    vec2 p = mix(aRect.xy, aRect.zw, c);
+    vUv = mix(aUv.xy, aUv.zw, c);
+    vCol = aCol;
+    vSolid = aUv.x < 0.0 ? 1 : 0;
+    gl_Position = vec4(p.x / u_Viewport.x * 2.0 - 1.0, 1.0 - p.y / u_Viewport.y * 2.0, 0.0, 1.0);
+}
 
 #shader fragment
 #version 330 core
 
+in vec2 vUv;
 in vec4 vCol;
+flat in int vSolid;
 out vec4 FragColor;
-void main() { FragColor = vCol; }
\ No newline at end of file
+
+uniform sampler2D u_Atlas;          // R8 glyph coverage
+
+void main() {
+    float a = vSolid == 1 ? 1.0 : texture(u_Atlas, vUv).r;
+    FragColor = vec4(vCol.rgb, vCol.a * a);
+}
@@ -125,8 +125,23 @@ vec3 ocean(float t) {
 
 uniform int u_Colormap;
 
+// texel -> dB (dB = texel * u_Scale + u_Offset), then [u_MinDb, u_MaxDb] -> [0,1]
+uniform float u_Scale;
+uniform float u_Offset;
+uniform float u_MinDb;
+uniform float u_MaxDb;
+uniform float u_Contrast; // gamma on the normalised value, 1.0 = linear
+
+// horizontal window into the texture: u = u_UOffset + x * u_USpan (0 / 1 for a plain texture;
+// a ring texture wraps with GL_REPEAT)
+uniform float u_UOffset;
+uniform float u_USpan;
+
 void main() {
-    float intensity = texture(u_Texture, v_TexCoord).r;
+    vec2 uv = vec2(u_UOffset + v_TexCoord.x * u_USpan, v_TexCoord.y);
+    float db = texture(u_Texture, uv).r * u_Scale + u_Offset;
+    float intensity = clamp((db - u_MinDb) / max(u_MaxDb - u_MinDb, 1e-3), 0.0, 1.0);
+    intensity = pow(intensity, max(u_Contrast, 1e-3));
     vec3 color;
 
     if (u_Colormap == 1) {
@@ -0,0 +1,63 @@
+#shader vertex
+#version 330 core
+
+// No vertex attributes: 2 vertices per pixel column, the envelope of column
+// gl_VertexID / 2 is reduced here from one level of the peak pyramid.
+// u_Peaks texel = (min, max, rms, 0) of one block of source samples.
+
+uniform samplerBuffer u_Peaks;
+uniform int   u_Base;     // first texel of the level
+uniform int   u_Count;    // entries in the level
+uniform int   u_E0;       // entry under the left edge of the view
+uniform float u_Frac;     // view start - u_E0, in entries
+uniform float u_Step;     // entries per pixel column (>= 1)
+uniform int   u_Cols;
+uniform float u_Gain;
+uniform int   u_Mode;     // 0: min/max lines, 1: +-rms band (triangle strip)
+
+const int kMaxEntries = 32;
+
+void main() {
+    int col = gl_VertexID / 2;
+    int side = gl_VertexID - col * 2;
+
+    // same entry range as PeakIndex::project
+    float a = u_Frac + u_Step * float(col);
+    int e0 = min(u_E0 + int(floor(a)), u_Count - 1);
+    int e1 = max(e0 + 1, min(u_E0 + int(ceil(a + u_Step)), u_Count));
+    e1 = min(e1, e0 + kMaxEntries);
+
+    vec4 p = texelFetch(u_Peaks, u_Base + e0);
+    float mn = p.x;
+    float mx = p.y;
+    float sq = p.z * p.z;
+    for (int e = e0 + 1; e < e1; ++e) {
+        vec4 q = texelFetch(u_Peaks, u_Base + e);
+        mn = min(mn, q.x);
+        mx = max(mx, q.y);
+        sq += q.z * q.z;
+    }
+
+    float y;
+    if (u_Mode == 0) {
+        y = side == 0 ? mn : mx;
+    } else {
+        float r = sqrt(sq / float(e1 - e0));
+        y = side == 0 ? -r : r;
+    }
+    y = clamp(y * u_Gain, -1.0, 1.0);
+
+    float x = u_Cols > 1 ? float(col) / float(u_Cols - 1) * 2.0 - 1.0 : 0.0;
+    gl_Position = vec4(x, y, 0.0, 1.0);
+}
+
+#shader fragment
+#version 330 core
+
+out vec4 color;
+
+uniform vec4 u_Color;
+
+void main() {
+    color = u_Color;
+}
@@ -0,0 +1,48 @@
+#include "buffer_texture.h"
+#include "gl_state_cache.h"
+
+BufferTexture::BufferTexture(const void* data, size_t size_bytes, GLenum internal_format, GLenum usage)
+    : bufferID(0), textureID(0), internalFormat(internal_format), bytes(size_bytes) {
+
+    GLCall(glGenBuffers(1, &bufferID));
+    GLCall(glBindBuffer(GL_TEXTURE_BUFFER, bufferID));
+    GLCall(glBufferData(GL_TEXTURE_BUFFER, GLsizeiptr(size_bytes), data, usage));
+    GLCall(glBindBuffer(GL_TEXTURE_BUFFER, 0));
+
+    GLCall(glGenTextures(1, &textureID));
+    GlStateCache::BindTexture(GL_TEXTURE_BUFFER, textureID);
+    GLCall(glTexBuffer(GL_TEXTURE_BUFFER, internalFormat, bufferID));
+    GlStateCache::BindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+BufferTexture::~BufferTexture() {
+    GlStateCache::ForgetTexture(textureID);
+    GLCall(glDeleteTextures(1, &textureID));
+    GLCall(glDeleteBuffers(1, &bufferID));
+}
+
+void BufferTexture::UpdateData(const void* data, size_t size_bytes) {
+    GLCall(glBindBuffer(GL_TEXTURE_BUFFER, bufferID));
+    if (size_bytes != bytes) {
+        GLCall(glBufferData(GL_TEXTURE_BUFFER, GLsizeiptr(size_bytes), data, GL_STATIC_DRAW));
+        bytes = size_bytes;
+    } else {
+        GLCall(glBufferSubData(GL_TEXTURE_BUFFER, 0, GLsizeiptr(size_bytes), data));
+    }
+    GLCall(glBindBuffer(GL_TEXTURE_BUFFER, 0));
+}
+
+void BufferTexture::Bind(unsigned int slot /*= 0*/) const {
+    GlStateCache::BindTexture(slot, GL_TEXTURE_BUFFER, textureID);
+}
+
+void BufferTexture::Unbind() const {
+    if (GlStateCache::SkipUnbind()) return;
+    GlStateCache::BindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+GLint BufferTexture::MaxTexels() {
+    GLint n = 0;
+    GLCall(glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &n));
+    return n;
+}
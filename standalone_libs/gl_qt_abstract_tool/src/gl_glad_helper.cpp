@@ -16,10 +16,17 @@
 x;\
     ASSERT(GlLogCall(#x, __FILE__, __LINE__))
 
+static uint64_t g_callCount = 0;
+
     void GlGladHelper::GLClearError() {
+    ++g_callCount;
     while (glGetError() != GL_NO_ERROR);
 }
 
+uint64_t GlGladHelper::CallCount() {
+    return g_callCount;
+}
+
 bool GlGladHelper::GlLogCall(const char *function, const char *file, int line) {
     while (GLenum error = glGetError()) {
         std::cerr << "OpenGL ERROR: " << "(" << error << ")" << " " << function << " " << file << " ~ " << line << std::endl;
@@ -0,0 +1,196 @@
+#include "gl_profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+namespace {
+
+void percentiles(std::vector<double> v, size_t& n, double& p50, double& p95, double& p99, double& mx) {
+    n = v.size();
+    if (v.empty()) return;
+    std::sort(v.begin(), v.end());
+    // nearest rank
+    const auto at = [&v](double p) {
+        const size_t r = size_t(std::ceil(p * double(v.size())));
+        return v[std::min(v.size() - 1, r > 0 ? r - 1 : 0)];
+    };
+    p50 = at(0.50);
+    p95 = at(0.95);
+    p99 = at(0.99);
+    mx = v.back();
+}
+
+}
+
+void GlProfiler::Window::add(double v, size_t cap) {
+    if (samples.size() < cap) {
+        samples.push_back(v);
+    } else {
+        samples[next] = v;
+        next = (next + 1) % cap;
+    }
+}
+
+GlProfiler::GlProfiler(int window)
+    : window(size_t(std::max(1, window))), gpuTiming(HasTimerQuery()) {}
+
+GlProfiler::~GlProfiler() {
+    for (FrameQueries& f : ring) {
+        if (!f.pool.empty()) {
+            GLCall(glDeleteQueries(GLsizei(f.pool.size()), f.pool.data()));
+        }
+    }
+}
+
+bool GlProfiler::HasTimerQuery() {
+    bool ok = false;
+#ifdef GL_VERSION_3_3
+    ok = ok || GLAD_GL_VERSION_3_3;
+#endif
+#ifdef GL_ARB_timer_query
+    ok = ok || GLAD_GL_ARB_timer_query;
+#endif
+    return ok;
+}
+
+int GlProfiler::region(const char* name) {
+    std::unordered_map<std::string, int>::const_iterator it = regionIndex.find(name);
+    if (it != regionIndex.end()) return it->second;
+    const int id = int(regions.size());
+    regions.push_back(Region());
+    regions.back().name = name;
+    regionIndex[name] = id;
+    return id;
+}
+
+int GlProfiler::timestamp() {
+    FrameQueries& f = ring[current];
+    if (f.used == int(f.pool.size())) {
+        // grow the pool by what this frame needs, queries are reused every kFrames
+        const size_t add = std::max<size_t>(8, f.pool.size());
+        f.pool.resize(f.pool.size() + add);
+        GLCall(glGenQueries(GLsizei(add), f.pool.data() + f.used));
+    }
+    const int q = f.used++;
+    GLCall(glQueryCounter(f.pool[size_t(q)], GL_TIMESTAMP));
+    return q;
+}
+
+void GlProfiler::collect() {
+    for (int i = 0; i < kFrames; ++i) {
+        FrameQueries& f = ring[i];
+        if (!f.pending || f.used == 0) continue;
+        // timestamps complete in order, the last one answers for the frame
+        GLint available = 0;
+        GLCall(glGetQueryObjectiv(f.pool[size_t(f.used - 1)], GL_QUERY_RESULT_AVAILABLE, &available));
+        if (!available) continue;
+
+        for (const Timed& t : f.timed) {
+            GLuint64 a = 0, b = 0;
+            GLCall(glGetQueryObjectui64v(f.pool[size_t(t.q0)], GL_QUERY_RESULT, &a));
+            GLCall(glGetQueryObjectui64v(f.pool[size_t(t.q1)], GL_QUERY_RESULT, &b));
+            regions[size_t(t.region)].gpu.add(b > a ? double(b - a) * 1e-6 : 0.0, window);
+        }
+        f.pending = false;
+    }
+}
+
+void GlProfiler::BeginFrame() {
+    if (inFrame) EndFrame();
+    if (gpuTiming) {
+        collect();
+        current = (current + 1) % kFrames;
+        FrameQueries& f = ring[current];
+        if (f.pending) ++droppedGpuFrames;   // GPU more than kFrames behind
+        f.pending = false;
+        f.used = 0;
+        f.timed.clear();
+    }
+    open.clear();
+    inFrame = true;
+    frameToken = BeginRegion("frame");
+}
+
+void GlProfiler::EndFrame() {
+    if (!inFrame) return;
+    // regions left open by an early return end here
+    while (!open.empty() && int(open.size()) - 1 > frameToken) EndRegion(int(open.size()) - 1);
+    EndRegion(frameToken);
+    inFrame = false;
+    ++frames;
+    if (gpuTiming) ring[current].pending = !ring[current].timed.empty();
+}
+
+int GlProfiler::BeginRegion(const char* name) {
+    Open o;
+    o.region = region(name);
+    o.query = (gpuTiming && inFrame) ? timestamp() : -1;
+    o.t0 = std::chrono::steady_clock::now();
+    open.push_back(o);
+    return int(open.size()) - 1;
+}
+
+void GlProfiler::EndRegion(int token) {
+    if (token < 0 || token >= int(open.size())) return;
+    const Open& o = open[size_t(token)];
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - o.t0).count();
+    regions[size_t(o.region)].cpu.add(ms, window);
+    if (o.query >= 0) {
+        Timed t;
+        t.region = o.region;
+        t.q0 = o.query;
+        t.q1 = timestamp();
+        ring[current].timed.push_back(t);
+    }
+    // scopes end innermost first
+    if (token == int(open.size()) - 1) open.pop_back();
+}
+
+void GlProfiler::AddCpuSample(const char* name, double ms) {
+    regions[size_t(region(name))].cpu.add(ms, window);
+}
+
+std::vector<GlProfiler::RegionStats> GlProfiler::Stats() const {
+    std::vector<RegionStats> out;
+    out.reserve(regions.size());
+    for (const Region& r : regions) {
+        RegionStats s;
+        s.name = r.name;
+        percentiles(r.cpu.samples, s.cpu_samples, s.cpu_p50, s.cpu_p95, s.cpu_p99, s.cpu_max);
+        percentiles(r.gpu.samples, s.gpu_samples, s.gpu_p50, s.gpu_p95, s.gpu_p99, s.gpu_max);
+        out.push_back(s);
+    }
+    return out;
+}
+
+std::string GlProfiler::Summary() const {
+    std::string out;
+    char line[160];
+    for (const RegionStats& s : Stats()) {
+        if (s.gpu_samples > 0) {
+            std::snprintf(line, sizeof(line), "%-10s cpu %6.2f /%6.2f  gpu %6.2f /%6.2f ms (p50/p99)\n",
+                          s.name.c_str(), s.cpu_p50, s.cpu_p99, s.gpu_p50, s.gpu_p99);
+        } else {
+            std::snprintf(line, sizeof(line), "%-10s cpu %6.2f /%6.2f ms (p50/p99)\n",
+                          s.name.c_str(), s.cpu_p50, s.cpu_p99);
+        }
+        out += line;
+    }
+    if (droppedGpuFrames > 0) out += "gpu frames dropped " + std::to_string(droppedGpuFrames) + "\n";
+    return out;
+}
+
+bool GlProfiler::DumpCsv(const std::string& path) const {
+    std::ofstream f(path);
+    if (!f) return false;
+    f << "region,cpu_samples,cpu_p50_ms,cpu_p95_ms,cpu_p99_ms,cpu_max_ms,"
+         "gpu_samples,gpu_p50_ms,gpu_p95_ms,gpu_p99_ms,gpu_max_ms\n";
+    for (const RegionStats& s : Stats()) {
+        f << s.name << ',' << s.cpu_samples << ',' << s.cpu_p50 << ',' << s.cpu_p95 << ',' << s.cpu_p99 << ','
+          << s.cpu_max << ',' << s.gpu_samples << ',' << s.gpu_p50 << ',' << s.gpu_p95 << ',' << s.gpu_p99 << ','
+          << s.gpu_max << '\n';
+    }
+    return bool(f);
+}
@@ -0,0 +1,160 @@
+#include "gl_state_cache.h"
+
+#include <unordered_map>
+
+namespace {
+
+const GLuint kUnknown = 0xFFFFFFFFu;
+const unsigned int kUnits = 32;
+
+struct State {
+    bool in_frame = false;
+    uint64_t calls_at_begin = 0;
+    GlStateCache::FrameStats frame;
+    GlStateCache::FrameStats last;
+
+    GLuint program = kUnknown;
+    GLuint vao = kUnknown;
+    unsigned int active_unit = kUnknown;
+    GLuint tex2d[kUnits];
+    GLuint texBuffer[kUnits];
+    std::unordered_map<GLuint, GLuint> ebo;   // vertex array -> element buffer
+
+    void forget() {
+        program = kUnknown;
+        vao = kUnknown;
+        active_unit = kUnknown;
+        for (unsigned int i = 0; i < kUnits; ++i) {
+            tex2d[i] = kUnknown;
+            texBuffer[i] = kUnknown;
+        }
+        ebo.clear();
+    }
+};
+
+State& state() {
+    static State s;
+    return s;
+}
+
+GLuint* textureSlot(State& s, GLenum target) {
+    if (s.active_unit >= kUnits) return nullptr;
+    switch (target) {
+    case GL_TEXTURE_2D:     return &s.tex2d[s.active_unit];
+    case GL_TEXTURE_BUFFER: return &s.texBuffer[s.active_unit];
+    default:                return nullptr;
+    }
+}
+
+}
+
+void GlStateCache::BeginFrame() {
+    State& s = state();
+    s.forget();
+    s.in_frame = true;
+    s.frame = FrameStats();
+    s.calls_at_begin = GlGladHelper::CallCount();
+}
+
+void GlStateCache::EndFrame() {
+    State& s = state();
+    if (!s.in_frame) return;
+    if (s.vao != 0) {
+        GLCall(glBindVertexArray(0));
+    }
+    s.frame.gl_calls = GlGladHelper::CallCount() - s.calls_at_begin;
+    s.last = s.frame;
+    s.in_frame = false;
+    s.forget();
+}
+
+bool GlStateCache::InFrame() {
+    return state().in_frame;
+}
+
+const GlStateCache::FrameStats& GlStateCache::LastFrame() {
+    return state().last;
+}
+
+void GlStateCache::UseProgram(GLuint program) {
+    State& s = state();
+    if (s.in_frame && s.program == program) { ++s.frame.skipped; return; }
+    GLCall(glUseProgram(program));
+    if (s.in_frame) s.program = program;
+}
+
+void GlStateCache::BindVertexArray(GLuint vao) {
+    State& s = state();
+    if (s.in_frame && s.vao == vao) { ++s.frame.skipped; return; }
+    GLCall(glBindVertexArray(vao));
+    if (s.in_frame) s.vao = vao;
+}
+
+void GlStateCache::BindElementBuffer(GLuint buffer) {
+    State& s = state();
+    if (s.in_frame && s.vao != kUnknown) {
+        std::unordered_map<GLuint, GLuint>::iterator it = s.ebo.find(s.vao);
+        if (it != s.ebo.end() && it->second == buffer) { ++s.frame.skipped; return; }
+    }
+    GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer));
+    // element buffer binding is vertex array state
+    if (s.in_frame && s.vao != kUnknown) s.ebo[s.vao] = buffer;
+}
+
+void GlStateCache::ActiveTexture(unsigned int unit) {
+    State& s = state();
+    if (s.in_frame && s.active_unit == unit) { ++s.frame.skipped; return; }
+    GLCall(glActiveTexture(GL_TEXTURE0 + unit));
+    if (s.in_frame) s.active_unit = unit;
+}
+
+void GlStateCache::BindTexture(GLenum target, GLuint texture) {
+    State& s = state();
+    GLuint* slot = s.in_frame ? textureSlot(s, target) : nullptr;
+    if (slot && *slot == texture) { ++s.frame.skipped; return; }
+    GLCall(glBindTexture(target, texture));
+    if (slot) *slot = texture;
+}
+
+void GlStateCache::BindTexture(unsigned int unit, GLenum target, GLuint texture) {
+    ActiveTexture(unit);
+    BindTexture(target, texture);
+}
+
+bool GlStateCache::SkipUnbind() {
+    State& s = state();
+    if (!s.in_frame) return false;
+    ++s.frame.skipped;
+    return true;
+}
+
+void GlStateCache::CountSkipped() {
+    State& s = state();
+    if (s.in_frame) ++s.frame.skipped;
+}
+
+void GlStateCache::ForgetProgram(GLuint program) {
+    State& s = state();
+    if (s.program == program) s.program = kUnknown;
+}
+
+void GlStateCache::ForgetVertexArray(GLuint vao) {
+    State& s = state();
+    if (s.vao == vao) s.vao = kUnknown;
+    s.ebo.erase(vao);
+}
+
+void GlStateCache::ForgetTexture(GLuint texture) {
+    State& s = state();
+    for (unsigned int i = 0; i < kUnits; ++i) {
+        if (s.tex2d[i] == texture) s.tex2d[i] = kUnknown;
+        if (s.texBuffer[i] == texture) s.texBuffer[i] = kUnknown;
+    }
+}
+
+void GlStateCache::ForgetBuffer(GLuint buffer) {
+    State& s = state();
+    for (std::unordered_map<GLuint, GLuint>::iterator it = s.ebo.begin(); it != s.ebo.end(); ++it) {
+        if (it->second == buffer) it->second = kUnknown;
+    }
+}
@@ -1,20 +1,23 @@
 #include "index_buffer.h"
 #include "gl_glad_helper.h"
+#include "gl_state_cache.h"
 
 IndexBuffer::IndexBuffer(const GLuint *data, GLuint count): count(count) {
     glGenBuffers(1, &rendererID);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, rendererID);
+    GlStateCache::BindElementBuffer(rendererID);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(GLuint), data, GL_STATIC_DRAW);
 }
 
 IndexBuffer::~IndexBuffer() {
+    GlStateCache::ForgetBuffer(rendererID);
     GLCall(glDeleteBuffers(1, &rendererID));
 }
 
 void IndexBuffer::Bind() const {
-    GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, rendererID));
+    GlStateCache::BindElementBuffer(rendererID);
 }
 
 void IndexBuffer::Unbind() const {
-    GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
+    if (GlStateCache::SkipUnbind()) return;
+    GlStateCache::BindElementBuffer(0);
 }
@@ -7,12 +7,18 @@ void Renderer::Draw(const VertexArray &va, const IndexBuffer &ib, const Shader &
     GLCall(glDrawElements(mode, ib.GetCount(), GL_UNSIGNED_INT, nullptr));
 }
 
-void Renderer::DrawWithoutIndexBuffer(const VertexArray &va, const Shader &shader, const int &count, GLenum mode) {
+void Renderer::DrawWithoutIndexBuffer(const VertexArray &va, const Shader &shader, const int &count, GLenum mode, GLint first) {
     shader.Bind();
     va.Bind();
-    GLCall(glDrawArrays(mode, 0, count));
+    GLCall(glDrawArrays(mode, first, count));
 }
 
+void Renderer::DrawInstanced(const VertexArray &va, const Shader &shader, const int &count, const int &instances, GLenum mode) {
+    if (instances <= 0) return;
+    shader.Bind();
+    va.Bind();
+    GLCall(glDrawArraysInstanced(mode, 0, count, instances));
+}
 
 void Renderer::Clear() const {
     GLCall(glClearColor(0.1f, 0.1f, 0.1f, 1.0f));
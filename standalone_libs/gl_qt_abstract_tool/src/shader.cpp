@@ -1,5 +1,8 @@
 #include "shader.h"
 #include "gl_glad_helper.h"
+#include "gl_state_cache.h"
+
+#include <cstring>
 
 Shader::Shader(const std::string &file_path) : filepath(file_path), program(0) {
     GlGladHelper::ShaderSource shader_source = GlGladHelper::load_shaders(file_path);
@@ -10,23 +13,52 @@ Shader::Shader(const std::string &file_path) : filepath(file_path), program(0) {
 }
 
 Shader::~Shader() {
+    GlStateCache::ForgetProgram(program);
     GLCall(glDeleteProgram(program));
 }
 
+bool Shader::uniformUnchanged(int loc, const void* value, size_t bytes) {
+    if (loc == -1) return true; // GL would ignore it anyway
+    UniformValue& v = uniformsValueCache[loc];
+    if (v.size == bytes && std::memcmp(v.data, value, bytes) == 0) {
+        GlStateCache::CountSkipped();
+        return true;
+    }
+    v.size = bytes;
+    std::memcpy(v.data, value, bytes);
+    return false;
+}
+
 void Shader::SetUniform1i(const std::string& name, int value) {
-    GLCall(glUniform1i(glGetUniformLocation(program, name.c_str()), value));
+    const int loc = GetUniformLocation(name);
+    if (uniformUnchanged(loc, &value, sizeof(value))) return;
+    GLCall(glUniform1i(loc, value));
 }
 
 void Shader::SetUniform1f(const std::string &name, float value) {
-    GLCall(glUniform1f(GetUniformLocation(name), value));
+    const int loc = GetUniformLocation(name);
+    if (uniformUnchanged(loc, &value, sizeof(value))) return;
+    GLCall(glUniform1f(loc, value));
+}
+
+void Shader::SetUniform2f(const std::string &name, float v0, float v1) {
+    const int loc = GetUniformLocation(name);
+    const float v[2] = { v0, v1 };
+    if (uniformUnchanged(loc, v, sizeof(v))) return;
+    GLCall(glUniform2f(loc, v0, v1));
 }
 
 void Shader::SetUniform4f(const std::string &name, float v0, float v1, float v2, float v3) {
-    GLCall(glUniform4f(GetUniformLocation(name), v0, v1, v2, v3));
+    const int loc = GetUniformLocation(name);
+    const float v[4] = { v0, v1, v2, v3 };
+    if (uniformUnchanged(loc, v, sizeof(v))) return;
+    GLCall(glUniform4f(loc, v0, v1, v2, v3));
 }
 
 void Shader::SetUniformMat4f(const std::string &name, const glm::mat4 &matrix) {
-    GLCall(glUniformMatrix4fv(GetUniformLocation(name), 1, GL_FALSE, &matrix[0][0]));
+    const int loc = GetUniformLocation(name);
+    if (uniformUnchanged(loc, &matrix[0][0], sizeof(float) * 16)) return;
+    GLCall(glUniformMatrix4fv(loc, 1, GL_FALSE, &matrix[0][0]));
 }
 
 GLint Shader::GetUniformLocation(const std::string& name) {
@@ -51,9 +83,10 @@ GLint Shader::GetUniformLocation(const std::string& name) {
 }
 
 void Shader::Bind() const {
-    GLCall(glUseProgram(program));
+    GlStateCache::UseProgram(program);
 }
 
 void Shader::Unbind() const {
-    GLCall(glUseProgram(0));
+    if (GlStateCache::SkipUnbind()) return;
+    GlStateCache::UseProgram(0);
 }
@@ -0,0 +1,171 @@
+#include "streaming_texture.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+StreamingTexture::StreamingTexture(int width, int height, TextureFormat fmt, int slots)
+    : format(fmt), width(width), height(height),
+      frameBytes(size_t(width) * size_t(height) * size_t(Texture::BytesPerPixel(fmt))),
+      persistent(HasBufferStorage()),
+      slots(size_t(std::max(2, slots))) {
+
+    texture.reset(new Texture(width, height, static_cast<const void*>(nullptr), fmt));
+    createSlots();
+}
+
+StreamingTexture::~StreamingTexture() {
+    destroySlots();
+}
+
+bool StreamingTexture::HasBufferStorage() {
+    bool ok = false;
+#ifdef GL_VERSION_4_4
+    ok = ok || GLAD_GL_VERSION_4_4;
+#endif
+#ifdef GL_ARB_buffer_storage
+    ok = ok || GLAD_GL_ARB_buffer_storage;
+#endif
+    return ok;
+}
+
+void StreamingTexture::createSlots() {
+    for (Slot& s : slots) {
+        GLCall(glGenBuffers(1, &s.pbo));
+        GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, s.pbo));
+#if defined(GL_VERSION_4_4) || defined(GL_ARB_buffer_storage)
+        if (persistent) {
+            const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            GLCall(glBufferStorage(GL_PIXEL_UNPACK_BUFFER, GLsizeiptr(frameBytes), nullptr, flags));
+            GLCall(s.mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, GLsizeiptr(frameBytes), flags));
+            if (!s.mapped) {
+                // storage is immutable: start over with plain buffers
+                persistent = false;
+                destroySlots();
+                createSlots();
+                return;
+            }
+            continue;
+        }
+#endif
+        GLCall(glBufferData(GL_PIXEL_UNPACK_BUFFER, GLsizeiptr(frameBytes), nullptr, GL_STREAM_DRAW));
+    }
+    GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+}
+
+void StreamingTexture::destroySlots() {
+    for (Slot& s : slots) {
+        if (s.fence) {
+            GLCall(glDeleteSync(s.fence));
+            s.fence = nullptr;
+        }
+        if (s.pbo) {
+            if (s.mapped) {
+                GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, s.pbo));
+                GLCall(glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER));
+                s.mapped = nullptr;
+            }
+            GLCall(glDeleteBuffers(1, &s.pbo));
+            s.pbo = 0;
+        }
+    }
+    GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+    current = -1;
+    next = 0;
+}
+
+void StreamingTexture::Resize(int w, int h) {
+    if (w == width && h == height) return;
+    destroySlots();
+    width = w;
+    height = h;
+    frameBytes = size_t(w) * size_t(h) * size_t(Texture::BytesPerPixel(format));
+    persistent = HasBufferStorage();
+    texture->updateText(w, h, nullptr, format);
+    createSlots();
+}
+
+void* StreamingTexture::MapNext() {
+    current = next;
+    next = (next + 1) % int(slots.size());
+    Slot& s = slots[size_t(current)];
+
+    if (persistent) {
+        if (s.fence) {
+            // the GPU may still be reading this slot (only when the ring is outrun)
+            GLenum r;
+            GLCall(r = glClientWaitSync(s.fence, 0, 0));
+            if (r == GL_TIMEOUT_EXPIRED) {
+                ++stats.fence_waits;
+                GLCall(r = glClientWaitSync(s.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(1000000000)));
+            }
+            if (r != GL_ALREADY_SIGNALED && r != GL_CONDITION_SATISFIED) {
+                // immutable storage cannot be orphaned: drain the GPU before the slot is overwritten
+                ++stats.fence_timeouts;
+                GLCall(glFinish());
+            }
+            GLCall(glDeleteSync(s.fence));
+            s.fence = nullptr;
+        }
+        return s.mapped;
+    }
+
+    // orphan: the driver hands back fresh storage if the old one is still in use
+    void* p;
+    GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, s.pbo));
+    GLCall(glBufferData(GL_PIXEL_UNPACK_BUFFER, GLsizeiptr(frameBytes), nullptr, GL_STREAM_DRAW));
+    GLCall(p = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, GLsizeiptr(frameBytes),
+                                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+    GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+    if (!p) current = -1;
+    return p;
+}
+
+void StreamingTexture::Commit() {
+    if (current < 0) return;
+    Slot& s = slots[size_t(current)];
+    current = -1;
+
+    GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, s.pbo));
+    if (!persistent) {
+        GLCall(glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER));
+    }
+    // with an unpack buffer bound the data pointer is an offset into it
+    texture->updateText(width, height, nullptr, format);
+    GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+
+    if (persistent) {
+        GLCall(s.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+    }
+}
+
+void StreamingTexture::Upload(int w, int h, const void* data, int row_bytes) {
+    const auto t0 = std::chrono::steady_clock::now();
+
+    Resize(w, h);
+    const int bpp = Texture::BytesPerPixel(format);
+    const size_t row = size_t(w) * size_t(bpp);
+    void* dst = MapNext();
+    if (dst) {
+        // the copy into the slot happens anyway, it drops the padding on the way
+        if (row_bytes <= 0 || size_t(row_bytes) == row) {
+            std::memcpy(dst, data, frameBytes);
+        } else {
+            const uint8_t* src = static_cast<const uint8_t*>(data);
+            uint8_t* out = static_cast<uint8_t*>(dst);
+            for (int y = 0; y < h; ++y) {
+                std::memcpy(out + size_t(y) * row, src + size_t(y) * size_t(row_bytes), row);
+            }
+        }
+        Commit();
+    } else {
+        // mapping failed, plain synchronous path
+        texture->updateText(w, h, data, format, row_bytes > 0 ? row_bytes / bpp : 0);
+    }
+
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    ++stats.uploads;
+    stats.last_ms = ms;
+    stats.avg_ms += (ms - stats.avg_ms) / double(stats.uploads);
+    stats.max_ms = std::max(stats.max_ms, ms);
+}
@@ -0,0 +1,185 @@
+#include "streaming_vertex_buffer.h"
+#include "streaming_texture.h"
+
+#include <algorithm>
+#include <cstring>
+
+StreamingVertexBuffer::StreamingVertexBuffer(GLuint stride, size_t initial_bytes, int segments)
+    : stride(std::max<GLuint>(1, stride)),
+      persistent(StreamingTexture::HasBufferStorage()),
+      segments(size_t(std::max(2, segments))) {
+
+    create(initial_bytes);
+}
+
+StreamingVertexBuffer::~StreamingVertexBuffer() {
+    destroy();
+}
+
+void StreamingVertexBuffer::create(size_t segment_bytes) {
+    // whole vertices per range, so a range start is a valid first vertex
+    segment_bytes = std::max<size_t>(segment_bytes, stride);
+    segmentBytes = (segment_bytes + stride - 1) / stride * stride;
+
+    GLCall(glGenBuffers(1, &rendererID));
+    GLCall(glBindBuffer(GL_ARRAY_BUFFER, rendererID));
+#if defined(GL_VERSION_4_4) || defined(GL_ARB_buffer_storage)
+    if (persistent) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        const GLsizeiptr total = GLsizeiptr(segmentBytes * segments.size());
+        GLCall(glBufferStorage(GL_ARRAY_BUFFER, total, nullptr, flags));
+        GLCall(mapped = static_cast<char*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, total, flags)));
+        if (!mapped) {
+            // storage is immutable: start over with an orphaned buffer
+            GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
+            GLCall(glDeleteBuffers(1, &rendererID));
+            rendererID = 0;
+            persistent = false;
+            create(segmentBytes);
+            return;
+        }
+    }
+#endif
+    if (!persistent) {
+        GLCall(glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(segmentBytes), nullptr, GL_STREAM_DRAW));
+    }
+    GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
+    ++generation;
+}
+
+void StreamingVertexBuffer::destroy() {
+    for (Segment& s : segments) {
+        if (s.fence) {
+            GLCall(glDeleteSync(s.fence));
+        }
+        s = Segment();
+    }
+    if (rendererID) {
+        if (mapped) {
+            GLCall(glBindBuffer(GL_ARRAY_BUFFER, rendererID));
+            GLCall(glUnmapBuffer(GL_ARRAY_BUFFER));
+            GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
+            mapped = nullptr;
+        }
+        GLCall(glDeleteBuffers(1, &rendererID));
+        rendererID = 0;
+    }
+    current = -1;
+    next = 0;
+}
+
+void StreamingVertexBuffer::grow(size_t bytes) {
+    const size_t target = std::max(bytes, segmentBytes * 2);
+    ++stats.reallocs;
+    if (persistent) {
+        // immutable storage: new buffer object (GL keeps the old one alive until the GPU is done)
+        destroy();
+        create(target);
+    } else {
+        segmentBytes = (target + stride - 1) / stride * stride;
+        GLCall(glBindBuffer(GL_ARRAY_BUFFER, rendererID));
+        GLCall(glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(segmentBytes), nullptr, GL_STREAM_DRAW));
+        GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
+    }
+}
+
+void* StreamingVertexBuffer::MapNext(size_t bytes) {
+    if (bytes == 0) return nullptr;
+    if (bytes > segmentBytes) grow(bytes);
+    pendingBytes = bytes;
+
+    if (persistent) {
+        current = next;
+        next = (next + 1) % int(segments.size());
+        Segment& s = segments[size_t(current)];
+        if (s.fence) {
+            GLenum r;
+            GLCall(r = glClientWaitSync(s.fence, 0, 0));
+            if (r == GL_TIMEOUT_EXPIRED) {
+                ++stats.fence_waits;
+                GLCall(r = glClientWaitSync(s.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(1000000000)));
+            }
+            if (r != GL_ALREADY_SIGNALED && r != GL_CONDITION_SATISFIED) {
+                // cannot orphan immutable storage: drain the GPU before the range is overwritten
+                ++stats.fence_timeouts;
+                GLCall(glFinish());
+            }
+            GLCall(glDeleteSync(s.fence));
+            s.fence = nullptr;
+        }
+        return mapped + size_t(current) * segmentBytes;
+    }
+
+    // orphan: the driver hands back fresh storage if the old one is still in use
+    void* p;
+    current = 0;
+    GLCall(glBindBuffer(GL_ARRAY_BUFFER, rendererID));
+    GLCall(glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(segmentBytes), nullptr, GL_STREAM_DRAW));
+    GLCall(p = glMapBufferRange(GL_ARRAY_BUFFER, 0, GLsizeiptr(bytes),
+                                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+    if (!p) current = -1;
+    return p;
+}
+
+GLint StreamingVertexBuffer::Commit() {
+    if (current < 0) return 0;
+    const int seg = current;
+    current = -1;
+
+    if (!persistent) {
+        GLCall(glBindBuffer(GL_ARRAY_BUFFER, rendererID));
+        GLCall(glUnmapBuffer(GL_ARRAY_BUFFER));
+    }
+    segments[size_t(seg)].used = true;
+
+    ++stats.writes;
+    stats.frame_bytes += pendingBytes;
+    stats.total_bytes += pendingBytes;
+    return GLint(size_t(seg) * segmentBytes / stride);
+}
+
+GLint StreamingVertexBuffer::Write(const void* data, size_t bytes) {
+    void* dst = MapNext(bytes);
+    if (dst) {
+        std::memcpy(dst, data, bytes);
+        return Commit();
+    }
+    if (bytes == 0) return 0;
+
+    // mapping failed (orphan mode only), plain upload
+    GLCall(glBindBuffer(GL_ARRAY_BUFFER, rendererID));
+    GLCall(glBufferSubData(GL_ARRAY_BUFFER, 0, GLsizeiptr(bytes), data));
+    ++stats.writes;
+    stats.frame_bytes += bytes;
+    stats.total_bytes += bytes;
+    return 0;
+}
+
+void StreamingVertexBuffer::MarkDrawn(GLint first) {
+    if (!persistent || first < 0 || segmentBytes == 0) return;
+    const size_t seg = size_t(first) * stride / segmentBytes;
+    if (seg < segments.size()) segments[seg].used = true;
+}
+
+void StreamingVertexBuffer::EndFrame() {
+    for (Segment& s : segments) {
+        if (!s.used) continue;
+        s.used = false;
+        if (persistent) {
+            if (s.fence) {
+                GLCall(glDeleteSync(s.fence));
+            }
+            GLCall(s.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+        }
+    }
+    stats.last_frame_bytes = stats.frame_bytes;
+    stats.frame_bytes = 0;
+}
+
+void StreamingVertexBuffer::Bind() const {
+    GLCall(glBindBuffer(GL_ARRAY_BUFFER, rendererID));
+}
+
+void StreamingVertexBuffer::Unbind() const {
+    GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
+}
@@ -1,4 +1,5 @@
 #include "texture.h"
+#include "gl_state_cache.h"
 #include <iostream>
 #define STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_WRITE_IMPLEMENTATION
@@ -30,7 +31,7 @@ Texture::Texture(const std::string &file_path) : rendererID(0), file_path(file_p
     }
 
     GLCall(glGenTextures(1, &rendererID));
-    GLCall(glBindTexture(GL_TEXTURE_2D, rendererID));
+    GlStateCache::BindTexture(GL_TEXTURE_2D, rendererID);
 
     GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
     GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
@@ -39,7 +40,7 @@ Texture::Texture(const std::string &file_path) : rendererID(0), file_path(file_p
     GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE)); // y
 
     GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, localBuffer));
-    GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+    GlStateCache::BindTexture(GL_TEXTURE_2D, 0);
 
     if (localBuffer) {
         stbi_image_free(localBuffer);
@@ -49,7 +50,7 @@ Texture::Texture(const std::string &file_path) : rendererID(0), file_path(file_p
 Texture::Texture(int width, int height, const float *data) : rendererID(0), width(width), height(height), bitPerPixel(32) {
 
     GLCall(glGenTextures(1, &rendererID));
-    GLCall(glBindTexture(GL_TEXTURE_2D, rendererID));
+    GlStateCache::BindTexture(GL_TEXTURE_2D, rendererID);
 
     GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
     GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
@@ -70,7 +71,7 @@ Texture::Texture(int width, int height, const float *data) : rendererID(0), widt
         data
         ));
 
-    GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+    GlStateCache::BindTexture(GL_TEXTURE_2D, 0);
 
 }
 
@@ -93,7 +94,7 @@ void Texture::updateText(int width, int height, const float *data) {
 Texture::Texture(int width_pixel, int height_pixel, const std::vector<float>& tileXYZ) : rendererID(0), width(width_pixel), height(height_pixel), bitPerPixel(32) {
 
     GLCall(glGenTextures(1, &rendererID));
-    GLCall(glBindTexture(GL_TEXTURE_2D, rendererID));
+    GlStateCache::BindTexture(GL_TEXTURE_2D, rendererID);
 
     GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
     GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
@@ -121,7 +122,7 @@ Texture::Texture(int width_pixel, int height_pixel, const std::vector<float>& ti
         tileZ.data()
         ));
 
-    GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+    GlStateCache::BindTexture(GL_TEXTURE_2D, 0);
 
 }
 
@@ -140,7 +141,7 @@ Texture::Texture(int width, int height, const std::vector<uint8_t>& data, int ch
     this->format = format;
 
     GLCall(glGenTextures(1, &rendererID));
-    GLCall(glBindTexture(GL_TEXTURE_2D, rendererID));
+    GlStateCache::BindTexture(GL_TEXTURE_2D, rendererID);
 
     GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR)); // preserve pixel edges
     GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
@@ -161,12 +162,12 @@ Texture::Texture(int width, int height, const std::vector<uint8_t>& data, int ch
         data.data()))
         ;
     // GLCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
-    GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+    GlStateCache::BindTexture(GL_TEXTURE_2D, 0);
 }
 
 void Texture::updateText(int w, int h, const std::vector<uint8_t>& data, int channel)
 {
-    GLCall(glBindTexture(GL_TEXTURE_2D, rendererID));
+    GlStateCache::BindTexture(GL_TEXTURE_2D, rendererID);
 
     // (optional but safe)
     GLCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
@@ -175,18 +176,7 @@ void Texture::updateText(int w, int h, const std::vector<uint8_t>& data, int cha
     if (w != width || h != height) {
         width = w;
         height = h;
-
-        GLCall(glTexImage2D(
-            GL_TEXTURE_2D,
-            0,
-            internalFormat,
-            width,
-            height,
-            0,
-            format,
-            GL_UNSIGNED_BYTE,
-            nullptr  // allocate only
-            ));
+        allocate(nullptr, 0);
     }
 
     // Upload pixels (no realloc)
@@ -201,7 +191,129 @@ void Texture::updateText(int w, int h, const std::vector<uint8_t>& data, int cha
         data.data()
         ));
 
-    GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+    GlStateCache::BindTexture(GL_TEXTURE_2D, 0);
+}
+
+Texture::Texture(int width, int height, const void* data, TextureFormat fmt) : rendererID(0), width(width), height(height) {
+
+    getGLFormat(fmt, internalFormat, format, type);
+    bitPerPixel = (type == GL_FLOAT) ? 32 : (type == GL_HALF_FLOAT) ? 16 : 8;
+
+    GLCall(glGenTextures(1, &rendererID));
+    GlStateCache::BindTexture(GL_TEXTURE_2D, rendererID);
+
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+
+    // 1 and 2 byte rows are rarely 4 byte aligned
+    GLCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+    allocate(data, 0);
+
+    GlStateCache::BindTexture(GL_TEXTURE_2D, 0);
+}
+
+bool Texture::HasTexStorage() {
+    bool ok = false;
+#ifdef GL_VERSION_4_2
+    ok = ok || GLAD_GL_VERSION_4_2;
+#endif
+#ifdef GL_ARB_texture_storage
+    ok = ok || GLAD_GL_ARB_texture_storage;
+#endif
+    return ok;
+}
+
+void Texture::allocate(const void* data, int row_pixels) {
+    // bound on GL_TEXTURE_2D, unpack alignment set by the caller
+    if (!HasTexStorage()) {
+        if (row_pixels > 0) {
+            GLCall(glPixelStorei(GL_UNPACK_ROW_LENGTH, row_pixels));
+        }
+        GLCall(glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, data));
+        if (row_pixels > 0) {
+            GLCall(glPixelStorei(GL_UNPACK_ROW_LENGTH, 0));
+        }
+        return;
+    }
+
+    if (immutable) {
+        // immutable storage cannot be resized: swap in a fresh name with the same sampling state
+        GLint minFilter, magFilter, wrapS, wrapT;
+        GLCall(glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, &minFilter));
+        GLCall(glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, &magFilter));
+        GLCall(glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, &wrapS));
+        GLCall(glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, &wrapT));
+
+        GlStateCache::ForgetTexture(rendererID);
+        GLCall(glDeleteTextures(1, &rendererID));
+        GLCall(glGenTextures(1, &rendererID));
+        GlStateCache::BindTexture(GL_TEXTURE_2D, rendererID);
+
+        GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter));
+        GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, magFilter));
+        GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapS));
+        GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrapT));
+    }
+
+#if defined(GL_VERSION_4_2) || defined(GL_ARB_texture_storage)
+    // one level, nothing here samples mipmaps
+    GLCall(glTexStorage2D(GL_TEXTURE_2D, 1, GLenum(internalFormat), width, height));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0));
+    immutable = true;
+#endif
+    if (data) {
+        if (row_pixels > 0) {
+            GLCall(glPixelStorei(GL_UNPACK_ROW_LENGTH, row_pixels));
+        }
+        GLCall(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, type, data));
+        if (row_pixels > 0) {
+            GLCall(glPixelStorei(GL_UNPACK_ROW_LENGTH, 0));
+        }
+    }
+}
+
+void Texture::updateText(int w, int h, const void* data, TextureFormat fmt, int row_pixels)
+{
+    GLint newInternalFormat;
+    GLenum newFormat, newType;
+    getGLFormat(fmt, newInternalFormat, newFormat, newType);
+
+    GlStateCache::BindTexture(GL_TEXTURE_2D, rendererID);
+    GLCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+
+    if (w != width || h != height || newInternalFormat != internalFormat) {
+        width = w;
+        height = h;
+        internalFormat = newInternalFormat;
+        format = newFormat;
+        type = newType;
+        bitPerPixel = (type == GL_FLOAT) ? 32 : (type == GL_HALF_FLOAT) ? 16 : 8;
+
+        allocate(data, row_pixels);
+    } else {
+        // with an unpack buffer bound, data is an offset into it (nullptr included)
+        if (row_pixels > 0) {
+            GLCall(glPixelStorei(GL_UNPACK_ROW_LENGTH, row_pixels));
+        }
+        GLCall(glTexSubImage2D(
+            GL_TEXTURE_2D,
+            0,
+            0, 0,
+            width,
+            height,
+            format,
+            type,
+            data
+            ));
+        if (row_pixels > 0) {
+            GLCall(glPixelStorei(GL_UNPACK_ROW_LENGTH, 0));
+        }
+    }
+
+    GlStateCache::BindTexture(GL_TEXTURE_2D, 0);
 }
 
 /*
@@ -226,16 +338,56 @@ void Texture::updateText(int width, int height, const std::vector<uint8_t>& data
 */
 
 Texture::~Texture() {
+    GlStateCache::ForgetTexture(rendererID);
     GLCall(glDeleteTextures(1, &rendererID));
 }
 
+void Texture::SetFilter(GLenum filter) {
+    GlStateCache::BindTexture(GL_TEXTURE_2D, rendererID);
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter));
+    GlStateCache::BindTexture(GL_TEXTURE_2D, 0);
+}
+
+void Texture::SetWrap(GLenum wrap_s, GLenum wrap_t) {
+    GlStateCache::BindTexture(GL_TEXTURE_2D, rendererID);
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap_s));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap_t));
+    GlStateCache::BindTexture(GL_TEXTURE_2D, 0);
+}
+
+void Texture::UpdateRegion(int x, int y, int w, int h, const void* data, int row_pixels) {
+    if (w <= 0 || h <= 0) return;
+    GlStateCache::BindTexture(GL_TEXTURE_2D, rendererID);
+    GLCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+    if (row_pixels > 0) {
+        GLCall(glPixelStorei(GL_UNPACK_ROW_LENGTH, row_pixels));
+    }
+    GLCall(glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h, format, type, data));
+    if (row_pixels > 0) {
+        GLCall(glPixelStorei(GL_UNPACK_ROW_LENGTH, 0));
+    }
+    GlStateCache::BindTexture(GL_TEXTURE_2D, 0);
+}
+
+int Texture::BytesPerPixel(TextureFormat fmt) {
+    switch (fmt) {
+    case TextureFormat::R8:    return 1;
+    case TextureFormat::RGB8:  return 3;
+    case TextureFormat::R16F:  return 2;
+    case TextureFormat::RGBA8:
+    case TextureFormat::R32F:  return 4;
+    }
+    return 4;
+}
+
 void Texture::Bind(unsigned int slot /*= 0*/) const {
-    GLCall(glActiveTexture(GL_TEXTURE0 + slot));
-    GLCall(glBindTexture(GL_TEXTURE_2D, rendererID));
+    GlStateCache::BindTexture(slot, GL_TEXTURE_2D, rendererID);
 }
 
 void Texture::Unbind() const {
-    GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+    if (GlStateCache::SkipUnbind()) return;
+    GlStateCache::BindTexture(GL_TEXTURE_2D, 0);
 }
 
 MdlImageByte Texture::loadImageByte(const std::string& filename, bool flipVertical) {
@@ -1,31 +1,47 @@
 #include "vertex_array.h"
 #include "gl_glad_helper.h"
+#include "gl_state_cache.h"
 
 VertexArray::VertexArray() : rendererID(0) {
     GLCall(glGenVertexArrays(1, &rendererID));
 }
 
 VertexArray::~VertexArray() {
+    GlStateCache::ForgetVertexArray(rendererID);
     GLCall(glDeleteVertexArrays(1, &rendererID));
 }
 
 void VertexArray::AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout) const {
     Bind();
     vb.Bind();
+    setAttributes(layout);
+}
+
+void VertexArray::AddBuffer(const StreamingVertexBuffer& vb, const VertexBufferLayout& layout) const {
+    Bind();
+    vb.Bind();
+    setAttributes(layout);
+}
+
+void VertexArray::setAttributes(const VertexBufferLayout& layout) const {
     const auto& elements = layout.GetElements();
     unsigned int offset = 0;
     for (unsigned int i = 0; i < elements.size(); ++i) {
         const auto& element = elements[i];
         GLCall(glEnableVertexAttribArray(i));
         GLCall(glVertexAttribPointer(i, element.count, element.type, element.normalized, layout.GetStride(), (void*)offset));
+        if (layout.GetDivisor() != 0) {
+            GLCall(glVertexAttribDivisor(i, layout.GetDivisor()));
+        }
         offset += element.count * VertexBufferElement::GetSizeOfType(element.type);
     }
 }
 
 void VertexArray::Bind() const {
-    GLCall(glBindVertexArray(rendererID));
+    GlStateCache::BindVertexArray(rendererID);
 }
 
 void VertexArray::Unbind() const {
-    GLCall(glBindVertexArray(0));
+    if (GlStateCache::SkipUnbind()) return;
+    GlStateCache::BindVertexArray(0);
 }
@@ -0,0 +1,51 @@
+#ifndef DB_KERNEL_H
+#define DB_KERNEL_H
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace raiden {
+
+// Fused power -> dB -> (optional) unit-range mapping.
+// Same result as internal_tools::power_to_db, the DB_FLOOR / NaN clamp and
+// internal_tools::db_to_unit chained together, but done in one vectorised pass
+// (plus one read-only max reduction when the reference is the max).
+struct DbParams {
+    bool  ref_is_max = true;
+    float ref_value  = 1.0f;
+    float amin       = 1e-10f;
+    float top_db     = 80.0f;    // < 0 disables the dynamic range clip
+    float floor_db   = -80.0f;   // NaN / -inf / anything lower lands here
+    bool  to_unit    = true;
+    float min_db     = -80.0f;   // unit mapping range [min_db, max_db] -> [0, 1]
+    float max_db     = 0.0f;
+};
+
+class db_kernel {
+public:
+    enum class Isa { Scalar, SSE2, AVX2, NEON };
+
+    // in place over a contiguous buffer (e.g. Matrixf::data())
+    static void power_to_db(float* data, size_t n, const DbParams& p = DbParams());
+
+    // max(data[i], amin); NaN counts as amin
+    static float reduce_max(const float* data, size_t n, float amin);
+
+    // log10 approximation used by the kernel (exposed for error checks).
+    // |fast_log10(x) - log10(x)| < 4e-6 (~4e-5 dB) for x in [1e-32, 1e32], < 4.5e-6 over all
+    // normal x > 0 (a float near +-38 is only good to 1.9e-6 itself).
+    static float fast_log10(float x);
+
+    // ISA picked at runtime for this machine
+    static Isa active_isa();
+    // what this build and CPU can run; set_isa() switches power_to_db / reduce_max to one of them
+    // (tests and benchmarks; not while another thread is in the kernel). False if unavailable
+    static std::vector<Isa> available_isas();
+    static bool set_isa(Isa isa);
+    static const char* isa_name(Isa isa);
+};
+
+}
+
+#endif // DB_KERNEL_H
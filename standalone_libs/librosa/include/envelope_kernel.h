@@ -0,0 +1,34 @@
+#ifndef ENVELOPE_KERNEL_H
+#define ENVELOPE_KERNEL_H
+#pragma once
+
+#include "db_kernel.h"
+
+#include <cstddef>
+
+namespace raiden {
+
+// Waveform vertex generation for audio::project_visible_adapt_wave, writing
+// straight into caller memory (a reused vector, or a mapped GL buffer).
+// Output is interleaved (x, y) floats:
+//   n <= pixel_w : one vertex per sample, for GL_LINE_STRIP
+//   n >  pixel_w : (x, min), (x, max) per pixel, for GL_LINES
+class envelope_kernel {
+public:
+    // floats write_vertices() needs for n samples at pixel_w columns
+    static size_t vertex_floats(size_t n, int pixel_w);
+
+    // returns the vertex count (floats written / 2); out must hold vertex_floats(n, pixel_w).
+    // y = clamp(x * gain, -1, 1); NaN samples are skipped in envelope mode
+    static int write_vertices(const float* x, size_t n, int pixel_w, float gain, float* out);
+
+    // min / max over n > 0 samples, NaN ignored (+inf / -inf when every sample is NaN)
+    static void minmax(const float* x, size_t n, float& mn, float& mx);
+
+    // same runtime pick as db_kernel (AVX2 when the CPU has it)
+    static db_kernel::Isa active_isa() { return db_kernel::active_isa(); }
+};
+
+}
+
+#endif // ENVELOPE_KERNEL_H
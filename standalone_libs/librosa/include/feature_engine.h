@@ -0,0 +1,70 @@
+#ifndef FEATURE_ENGINE_H
+#define FEATURE_ENGINE_H
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "peak_index.h"
+
+namespace raiden {
+
+class SignalReader;
+
+// Per-hop frame features, one entry per `hop` source samples (non overlapping frames).
+// Columnar so an overlay can take a slice of a single feature without touching the others.
+struct AudioFeatures {
+    int sr = 0;
+    int hop = 0;
+    int64_t total_samples = 0;
+    float global_peak = 0.0f;   // max |x| over the whole signal
+
+    std::vector<float> rms;
+    std::vector<float> peak;      // max |x| in the frame (amplitude envelope)
+    std::vector<float> mean_abs;  // mean |x| (decimated amplitude time series)
+    std::vector<float> zcr;       // sign changes / frame length
+    std::vector<float> crest;     // peak / rms, 0 for silent frames
+
+    PeakIndex peaks;              // min/max/rms summary, filled in the same streaming pass
+
+    size_t size() const { return rms.size(); }
+    // frame index covering a time in seconds, clamped to [0, size() - 1]; 0 when empty, so check
+    // size() before indexing
+    size_t frameAt(double sec) const;
+};
+
+// Streaming analyser: push() any chunk size, every sample is read once and all
+// features come out of the same SIMD loop (SSE2 / NEON, scalar tail).
+class FeatureEngine {
+public:
+    explicit FeatureEngine(int sr, int hop = 512);
+
+    void push(const float* x, size_t n);
+    AudioFeatures finish();   // flushes a trailing partial frame
+
+    // whole file of reader.path() through a second reader of its own (own SNDFILE*, two block cache),
+    // so the one pass neither evicts the shared reader's cache nor queues on its lock; empty if cancelled
+    static AudioFeatures analyze(SignalReader& reader, int hop = 512, const std::atomic<bool>* cancel = nullptr);
+
+private:
+    struct Acc {
+        float sum_sq = 0.0f;
+        float sum_abs = 0.0f;
+        float max_abs = 0.0f;
+        int   crossings = 0;
+    };
+    static void accumulate(const float* x, size_t n, float prev, Acc& acc);
+    void emit(const Acc& acc, size_t n);
+
+    AudioFeatures out_;
+    Acc acc_;
+    size_t in_frame_ = 0;   // samples already in acc_
+    float prev_ = 0.0f;     // last sample seen, for zero crossings across chunk edges
+    bool has_prev_ = false;
+};
+
+}
+
+#endif // FEATURE_ENGINE_H
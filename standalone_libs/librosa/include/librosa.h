@@ -4,6 +4,8 @@
 #pragma once
 
 #include <obj_audio.h>
+#include "resampler.h"
+#include "peak_index.h"
 #include <string>
 #include <vector>
 
@@ -11,7 +13,12 @@ namespace raiden {
 
 class audio {
 public:
-    static Signal load(const std::string& path, const int& sr=-1, const bool& mono=true, const float& offset=0.f, const float& duration=-1.0f);
+    static Signal load(const std::string& path, const int& sr=-1, const bool& mono=true, const float& offset=0.f, const float& duration=-1.0f,
+                       const ResampleQuality& quality=ResampleQuality::SincBest);
+    // same window as load(), resampled through a caller-owned StreamResampler so consecutive
+    // windows share filter state (falls back to load() when no resampling is needed)
+    static Signal loadStream(const std::string& path, StreamResampler& resampler, const int& sr, const bool& mono=true,
+                             const float& offset=0.f, const float& duration=-1.0f);
     static Signal loadBufferToWaveMono(std::vector<uint8_t> data, int sample_rate);
 // outsider util helper func
 public:
@@ -19,7 +26,18 @@ public:
                           double overlap_frac, int n_fft, int n_hop, bool center=false);
     static std::vector<SpecViewPortNDC> project_visible_segments_to_ndc(const std::vector<SpecViewPort> &all, double view_start_sec, double view_span_sec);
     static SignalAdaptGl project_visible_adapt_wave(const std::vector<float> &audio_wave, int pixel_w, const float& global_peak);
+    // same vertices written into caller memory (reused scratch, mapped GL buffer), no allocation;
+    // out needs envelope_kernel::vertex_floats(n, pixel_w) floats. Returns the vertex count
+    static int project_visible_adapt_wave_into(const float* audio_wave, size_t n, int pixel_w, const float& global_peak,
+                                               float* out);
+    // same envelope from a PeakIndex in O(pixels); gl_draw_count == 0 when the view is finer
+    // than the index (fall back to the sample version)
+    static SignalAdaptGl project_visible_adapt_wave(const PeakIndex& index, double view_start_sec, double view_span_sec,
+                                                    int pixel_w, const float& global_peak);
     static float to_ndc(float t, double view_start_sec, double view_span_sec);
+    // per-hop feature column (e.g. AudioFeatures::rms) -> symmetric band vertices for the visible span
+    static std::vector<float> project_feature_band(const std::vector<float>& column, int hop, int sr,
+                                                   double view_start_sec, double view_span_sec, const float& global_peak);
 };
 
 }
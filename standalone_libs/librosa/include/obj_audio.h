@@ -12,6 +12,7 @@ struct Signal {
 struct SignalAdaptGl {
     std::vector<float> adapt_audio_wave;
     int gl_draw_count;
+    std::vector<float> rms_band; // optional overlay: (x, +rms), (x, -rms) pairs for a triangle strip
 };
 
 struct SpecViewPort {
@@ -47,6 +48,24 @@ struct SpectrogramTileOverlap {
     int hop_frames;
     int framesPerChunk;
     std::vector<float> data;
+    int fft_count; // STFT frames (FFTs) evaluated to build this window
+};
+
+// Quantised spectrogram: dB = texel * scale + offset.
+// U8 texels are normalised to [0,1] (as GL samples GL_R8), F16 texels hold the value itself.
+enum class SpecSampleFormat {
+    U8,
+    F16
+};
+
+struct SpectrogramQ {
+    int width = 0;
+    int height = 0;
+    SpecSampleFormat format = SpecSampleFormat::U8;
+    float scale = 1.0f;
+    float offset = 0.0f;
+    std::vector<uint8_t> data; // width * height * bytesPerSample, row-major
+    int bytesPerSample() const { return format == SpecSampleFormat::F16 ? 2 : 1; }
 };
 
 struct SpectrogramByte {
@@ -55,6 +74,14 @@ struct SpectrogramByte {
     std::vector<uint8_t> data;
 };
 
+// libsamplerate converter tiers: Linear / SincFast for drawing, SincBest for analysis and export
+enum class ResampleQuality {
+    Linear,     // SRC_LINEAR
+    SincFast,   // SRC_SINC_FASTEST
+    SincMedium, // SRC_SINC_MEDIUM_QUALITY
+    SincBest    // SRC_SINC_BEST_QUALITY
+};
+
 // View Mode
 enum class ViewSignalDataMode {
     WaveForm,
@@ -62,5 +89,11 @@ enum class ViewSignalDataMode {
     STFT
 };
 
+// How a spectrogram window is computed
+enum class SpecWindowMode {
+    Overlap, // overlapped 0.5 s chunks, averaged (loadMelOverlap)
+    Direct   // one STFT across the whole window (loadMelDirect)
+};
+
 
 #endif // OBJ_AUDIO_H
@@ -0,0 +1,59 @@
+#ifndef PEAK_INDEX_H
+#define PEAK_INDEX_H
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace raiden {
+
+// Audacity style summary of a whole signal: min / max / rms per block of `spp`
+// source samples, at 64, 1024, 16384 and 262144 samples per entry (16x apart, so a
+// view never reads more than 16 entries per pixel). Built once while streaming the
+// file; a waveform view then reads O(pixels) entries instead of O(samples).
+// The finest level keeps the default few-second views on the index.
+class PeakIndex {
+public:
+    struct Level {
+        int spp = 0;                 // source samples per entry
+        std::vector<float> min, max, rms;
+        size_t size() const { return min.size(); }
+    };
+    static const int kLevels = 4;
+
+    explicit PeakIndex(int sr = 0);
+
+    void push(const float* x, size_t n);
+    void finish();                   // flushes partial entries
+
+    int sampleRate() const { return sr_; }
+    int64_t totalSamples() const { return total_; }
+    float globalPeak() const { return global_peak_; } // max |x|
+    const Level& level(int i) const { return levels_[i]; }
+    bool empty() const { return levels_[0].size() == 0; }
+
+    // per-pixel min/max (and rms when out_rms != nullptr) over source samples [s0, s1).
+    // Uses the coarsest level that still has at least one entry per pixel; false when the
+    // view is finer than the first level (caller should fall back to the samples).
+    bool project(int64_t s0, int64_t s1, int pixel_w, float* out_min, float* out_max, float* out_rms = nullptr) const;
+
+private:
+    struct Acc {
+        float mn = 0.0f, mx = 0.0f;
+        double sum_sq = 0.0;
+        size_t n = 0;
+        void add(float a_mn, float a_mx, double a_sq, size_t a_n);
+    };
+    void emit(int lvl, const Acc& acc);
+
+    int sr_;
+    int64_t total_ = 0;
+    float global_peak_ = 0.0f;
+    Level levels_[kLevels];
+    Acc acc_[kLevels];
+};
+
+}
+
+#endif // PEAK_INDEX_H
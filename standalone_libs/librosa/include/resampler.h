@@ -0,0 +1,64 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+#pragma once
+
+#include "obj_audio.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace raiden {
+
+// Mono resampler that keeps one libsamplerate SRC_STATE alive across calls.
+// Windows asked for in order (scrolling, the DL export loop) continue the same
+// filter state, so window edges are sample continuous and the sinc priming is
+// paid once per seek instead of once per window.
+class StreamResampler {
+public:
+    // fill buf with up to n mono source frames starting at absolute source frame pos;
+    // return how many were written, 0 at end of stream
+    typedef std::function<size_t(int64_t pos, float* buf, size_t n)> SourceFn;
+
+    explicit StreamResampler(ResampleQuality quality = ResampleQuality::SincFast);
+    ~StreamResampler();
+
+    StreamResampler(const StreamResampler&) = delete;
+    StreamResampler& operator=(const StreamResampler&) = delete;
+
+    // output frames [out_start, out_start + out_count) on the dst_sr grid.
+    // Shorter than out_count only at end of stream.
+    std::vector<float> read(int64_t out_start, size_t out_count, int src_sr, int dst_sr, const SourceFn& source);
+
+    void reset();
+    void setQuality(ResampleQuality quality);
+    ResampleQuality quality() const { return quality_; }
+
+    int64_t seeks() const { return seeks_; }              // times the state had to be re-primed
+    int64_t framesIn() const { return frames_in_; }       // source frames pushed since construction
+
+    static int srcConverter(ResampleQuality quality);
+
+private:
+    void seek(int64_t out_start);
+    bool pull(const SourceFn& source);
+
+    void* state_ = nullptr;          // SRC_STATE*
+    ResampleQuality quality_;
+    int src_sr_ = 0, dst_sr_ = 0;
+    int64_t in_step_ = 1, out_step_ = 1; // src/gcd, dst/gcd: seek points where both grids meet
+
+    int64_t in_pos_ = 0;             // next source frame to feed
+    int64_t fifo_start_ = 0;         // absolute output frame of fifo_[0]
+    std::vector<float> fifo_;
+    std::vector<float> in_buf_, out_buf_;
+    bool eof_ = false;
+
+    int64_t seeks_ = 0;
+    int64_t frames_in_ = 0;
+};
+
+}
+
+#endif // RESAMPLER_H
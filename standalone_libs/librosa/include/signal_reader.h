@@ -0,0 +1,92 @@
+#ifndef SIGNAL_READER_H
+#define SIGNAL_READER_H
+#pragma once
+
+#include "obj_audio.h"
+#include "resampler.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace raiden {
+
+// Long-lived reader for one audio file. Keeps the SNDFILE* open and an LRU of
+// decoded mono blocks (source rate), so window reads from the display and DL
+// workers stop paying sf_open/seek/decode per window. Safe to share between threads:
+// a miss decodes outside the cache lock (one decode at a time on the file, a block
+// being decoded is waited for rather than decoded twice), so hits never queue
+// behind a decode.
+class SignalReader {
+public:
+    struct Stats {
+        int64_t hits = 0;
+        int64_t misses = 0;
+        int64_t decoded_frames = 0;
+        size_t  cached_blocks = 0;
+    };
+
+    // nullptr if the file cannot be opened. mono=false keeps channel 0 (same as audio::load)
+    static std::shared_ptr<SignalReader> open(const std::string& path, bool mono = true,
+                                              size_t block_frames = 65536, size_t max_blocks = 64);
+    ~SignalReader();
+
+    SignalReader(const SignalReader&) = delete;
+    SignalReader& operator=(const SignalReader&) = delete;
+
+    const std::string& path() const { return path_; }
+    int sampleRate() const { return src_sr_; }
+    int channels() const { return channels_; }
+    int64_t frames() const { return frames_; }
+    bool mono() const { return mono_; }
+    size_t blockFrames() const { return block_frames_; }
+
+    // mono source frames [pos, pos + n) into buf; returns how many were available
+    size_t readFrames(int64_t pos, float* buf, size_t n);
+
+    // window in seconds, same shape as audio::load. With a resampler the caller's
+    // filter state is reused across calls; without one a one-shot conversion is done.
+    Signal read(float offset, float duration, int sr = -1, StreamResampler* resampler = nullptr,
+                ResampleQuality quality = ResampleQuality::SincBest);
+    // same, addressed in output frames at sr: sample exact however far into the file
+    Signal readSamples(int64_t out_start, int64_t out_count, int sr = -1, StreamResampler* resampler = nullptr,
+                       ResampleQuality quality = ResampleQuality::SincBest);
+
+    Stats stats() const;
+
+private:
+    typedef std::shared_ptr<const std::vector<float>> Block;
+
+    SignalReader() = default;
+    Block block(int64_t index, std::unique_lock<std::mutex>& lk);   // mtx_ held, dropped while decoding
+    Block decode(int64_t index);         // file_mtx_ held
+
+    std::string path_;
+    void* file_ = nullptr;               // SNDFILE*
+    bool mono_ = true;
+    int src_sr_ = 0;
+    int channels_ = 0;
+    int64_t frames_ = 0;
+    size_t block_frames_ = 65536;
+    size_t max_blocks_ = 64;
+
+    mutable std::mutex mtx_;             // cache, in-flight set and stats
+    std::condition_variable decoded_;    // an in-flight block finished (or failed)
+    std::list<int64_t> lru_;             // front = most recent
+    std::unordered_map<int64_t, std::pair<Block, std::list<int64_t>::iterator>> blocks_;
+    std::unordered_set<int64_t> inflight_;
+    Stats stats_;
+
+    std::mutex file_mtx_;                // SNDFILE* seek + read, interleaved_
+    std::vector<float> interleaved_;
+};
+
+}
+
+#endif // SIGNAL_READER_H
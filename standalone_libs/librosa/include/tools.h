@@ -17,9 +17,37 @@ public:
     static SpectrogramTile loadMelSpec(const std::vector<float>& data, const int &sr=22050, int n_fft = 1024, int n_hop = 256, int n_mels = 512,
                                        float fmin = 0.0f, float fmax = -1.0f);
 
-    static SpectrogramTileOverlap loadStftOverlap(const std::vector<float>& data, const int &sr=22050, int n_fft = 1024, int n_hop = 256);
+    // build_tile: also fill width/height/data with the 10x10 magnified tile (left empty otherwise;
+    // the native matrix is always in .spectrogram)
+    static SpectrogramTileOverlap loadStftOverlap(const std::vector<float>& data, const int &sr=22050, int n_fft = 1024, int n_hop = 256,
+                                                  bool build_tile = false);
+    // ref_power > 0 (loadMelOverlap / loadMelDirect): dB against that fixed power instead of the max of
+    // each chunk / window, and no top_db clip, only the floor
     static SpectrogramTileOverlap loadMelOverlap(const std::vector<float>& data, const int &sr=22050, int n_fft = 1024, int n_hop = 256, int n_mels = 512,
-                                                 float fmin = 0.0f, float fmax = -1.0f, float segment_sec = 0.5f, float overlap_ratio = 0.5f, bool to_unit = true);
+                                                 float fmin = 0.0f, float fmax = -1.0f, float segment_sec = 0.5f, float overlap_ratio = 0.5f, bool to_unit = true,
+                                                 bool build_tile = false, float ref_power = 0.0f);
+    // single centred STFT over the whole window: frame i is centred on sample i*n_hop (n_fft/2 reflect
+    // padding only at the window edges), 1 + size / n_hop frames; empty below n_fft/2 + 1 samples
+    static SpectrogramTileOverlap loadMelDirect(const std::vector<float>& data, const int &sr=22050, int n_fft = 1024, int n_hop = 256, int n_mels = 512,
+                                                float fmin = 0.0f, float fmax = -1.0f, bool to_unit = true, bool build_tile = false,
+                                                float ref_power = 0.0f);
+    // frames [skip, skip + count) of a centred STFT over data, in dB against a fixed power reference so
+    // columns from separate calls line up (scrolling ring texture). ref_power <= 0: melReferencePower().
+    // Frames past the end of data are dropped (width < count).
+    static Spectrogram loadMelFrames(const std::vector<float>& data, const int &sr, int n_fft, int n_hop, int n_mels,
+                                     int skip, int count, float ref_power = 0.0f, float fmin = 0.0f, float fmax = -1.0f);
+    // mel power of a sine at amplitude peak (unit-sum STFT window, unnormalised filters), i.e. its 0 dB
+    // level; with the file's global peak it is a reference that does not depend on the window
+    static float melReferencePower(float peak = 1.0f);
+    // number of FFTs loadMelOverlap would evaluate for a window of total_samples
+    static int countOverlapFft(int total_samples, const int &sr, int n_hop, float segment_sec = 0.5f, float overlap_ratio = 0.5f);
+
+    // dB floats -> U8 (clamped to [min_db, max_db]) or F16 (kept as is)
+    static SpectrogramQ quantizeSpectrogram(const std::vector<float>& db, int width, int height,
+                                            SpecSampleFormat format = SpecSampleFormat::U8,
+                                            float min_db = -80.0f, float max_db = 0.0f);
+    static uint16_t floatToHalf(float f);
+    static float halfToFloat(uint16_t h);
 
     static SpectrogramByte flatMatrixToByteImg(const std::vector<float>& flat, int height, int width, const std::string &file_name, bool is_db = false);
     static std::vector<float> extractSpectrogramSlice(
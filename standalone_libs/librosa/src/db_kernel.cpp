@@ -0,0 +1,431 @@
+#include "db_kernel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#define DB_KERNEL_X86 1
+#include <emmintrin.h>
+#if defined(__GNUC__)
+#define DB_KERNEL_AVX2 1
+#include <immintrin.h>
+#endif
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define DB_KERNEL_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace raiden {
+
+namespace {
+
+// Cephes logf: mantissa reduced to [sqrt(.5), sqrt(2)) then a degree 8 polynomial
+const float kSqrtHalf = 0.707106781186547524f;
+const float kP0 =  7.0376836292E-2f;
+const float kP1 = -1.1514610310E-1f;
+const float kP2 =  1.1676998740E-1f;
+const float kP3 = -1.2420140846E-1f;
+const float kP4 =  1.4249322787E-1f;
+const float kP5 = -1.6668057665E-1f;
+const float kP6 =  2.0000714765E-1f;
+const float kP7 = -2.4999993993E-1f;
+const float kP8 =  3.3333331174E-1f;
+const float kQ1 = -2.12194440e-4f;
+const float kQ2 =  0.693359375f;
+const float kLnToDb    = 4.342944819032518f;  // 10 / ln(10)
+const float kLnToLog10 = 0.4342944819032518f; // 1 / ln(10)
+
+struct KernelConsts {
+    float amin;
+    float ref_db;   // 10*log10(ref)
+    float lo;       // lower dB clamp (top_db / floor)
+    float hi;       // upper dB clamp (unit mode only)
+    float min_db;
+    float inv_range;
+    bool  to_unit;
+};
+
+inline float log_scalar(float x) {
+    uint32_t u;
+    std::memcpy(&u, &x, sizeof(u));
+    float e = float(int((u >> 23) & 0xff) - 126);
+    u = (u & 0x807fffffu) | 0x3f000000u;
+    float m;
+    std::memcpy(&m, &u, sizeof(m));
+
+    if (m < kSqrtHalf) {
+        e -= 1.0f;
+        m = m + m - 1.0f;
+    } else {
+        m = m - 1.0f;
+    }
+    const float z = m * m;
+    float y = kP0;
+    y = y * m + kP1;
+    y = y * m + kP2;
+    y = y * m + kP3;
+    y = y * m + kP4;
+    y = y * m + kP5;
+    y = y * m + kP6;
+    y = y * m + kP7;
+    y = y * m + kP8;
+    y = y * m * z;
+    y += e * kQ1;
+    y -= 0.5f * z;
+    return m + y + e * kQ2;
+}
+
+inline float db_scalar(float x, const KernelConsts& k) {
+    const float v  = (x > k.amin) ? x : k.amin;          // NaN -> amin
+    float db = log_scalar(v) * kLnToDb - k.ref_db;
+    db = (db > k.lo) ? db : k.lo;                        // NaN -> lo
+    if (k.to_unit) {
+        db = std::min(db, k.hi);
+        db = (db - k.min_db) * k.inv_range;
+    }
+    return db;
+}
+
+void kernel_scalar(float* x, size_t n, const KernelConsts& k) {
+    for (size_t i = 0; i < n; ++i) x[i] = db_scalar(x[i], k);
+}
+
+float max_scalar(const float* x, size_t n, float amin) {
+    float m = amin;
+    for (size_t i = 0; i < n; ++i) m = (x[i] > m) ? x[i] : m;
+    return m;
+}
+
+#ifdef DB_KERNEL_X86
+inline __m128 log_sse2(__m128 x) {
+    const __m128 one = _mm_set1_ps(1.0f);
+    __m128i emm0 = _mm_srli_epi32(_mm_castps_si128(x), 23);
+    x = _mm_and_ps(x, _mm_castsi128_ps(_mm_set1_epi32(int(0x807fffffu))));
+    x = _mm_or_ps(x, _mm_set1_ps(0.5f));
+    emm0 = _mm_sub_epi32(emm0, _mm_set1_epi32(126));
+    __m128 e = _mm_cvtepi32_ps(emm0);
+
+    const __m128 mask = _mm_cmplt_ps(x, _mm_set1_ps(kSqrtHalf));
+    const __m128 tmp = _mm_and_ps(x, mask);
+    x = _mm_sub_ps(x, one);
+    e = _mm_sub_ps(e, _mm_and_ps(one, mask));
+    x = _mm_add_ps(x, tmp);
+
+    const __m128 z = _mm_mul_ps(x, x);
+    __m128 y = _mm_set1_ps(kP0);
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(kP1));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(kP2));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(kP3));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(kP4));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(kP5));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(kP6));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(kP7));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(kP8));
+    y = _mm_mul_ps(_mm_mul_ps(y, x), z);
+    y = _mm_add_ps(y, _mm_mul_ps(e, _mm_set1_ps(kQ1)));
+    y = _mm_sub_ps(y, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+    x = _mm_add_ps(x, y);
+    return _mm_add_ps(x, _mm_mul_ps(e, _mm_set1_ps(kQ2)));
+}
+
+void kernel_sse2(float* x, size_t n, const KernelConsts& k) {
+    const __m128 amin   = _mm_set1_ps(k.amin);
+    const __m128 to_db  = _mm_set1_ps(kLnToDb);
+    const __m128 ref_db = _mm_set1_ps(k.ref_db);
+    const __m128 lo     = _mm_set1_ps(k.lo);
+    const __m128 hi     = _mm_set1_ps(k.hi);
+    const __m128 min_db = _mm_set1_ps(k.min_db);
+    const __m128 inv    = _mm_set1_ps(k.inv_range);
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 v  = _mm_max_ps(_mm_loadu_ps(x + i), amin);   // maxps returns 2nd operand on NaN
+        __m128 db = _mm_sub_ps(_mm_mul_ps(log_sse2(v), to_db), ref_db);
+        db = _mm_max_ps(db, lo);
+        if (k.to_unit) {
+            db = _mm_min_ps(db, hi);
+            db = _mm_mul_ps(_mm_sub_ps(db, min_db), inv);
+        }
+        _mm_storeu_ps(x + i, db);
+    }
+    for (; i < n; ++i) x[i] = db_scalar(x[i], k);
+}
+
+float max_sse2(const float* x, size_t n, float amin) {
+    const __m128 a = _mm_set1_ps(amin);
+    __m128 acc = a;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        acc = _mm_max_ps(acc, _mm_max_ps(_mm_loadu_ps(x + i), a));
+    float lanes[4];
+    _mm_storeu_ps(lanes, acc);
+    float m = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+    for (; i < n; ++i) m = (x[i] > m) ? x[i] : m;
+    return m;
+}
+#endif
+
+#ifdef DB_KERNEL_AVX2
+__attribute__((target("avx2")))
+inline __m256 log_avx2(__m256 x) {
+    const __m256 one = _mm256_set1_ps(1.0f);
+    __m256i emm0 = _mm256_srli_epi32(_mm256_castps_si256(x), 23);
+    x = _mm256_and_ps(x, _mm256_castsi256_ps(_mm256_set1_epi32(int(0x807fffffu))));
+    x = _mm256_or_ps(x, _mm256_set1_ps(0.5f));
+    emm0 = _mm256_sub_epi32(emm0, _mm256_set1_epi32(126));
+    __m256 e = _mm256_cvtepi32_ps(emm0);
+
+    const __m256 mask = _mm256_cmp_ps(x, _mm256_set1_ps(kSqrtHalf), _CMP_LT_OQ);
+    const __m256 tmp = _mm256_and_ps(x, mask);
+    x = _mm256_sub_ps(x, one);
+    e = _mm256_sub_ps(e, _mm256_and_ps(one, mask));
+    x = _mm256_add_ps(x, tmp);
+
+    const __m256 z = _mm256_mul_ps(x, x);
+    __m256 y = _mm256_set1_ps(kP0);
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(kP1));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(kP2));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(kP3));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(kP4));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(kP5));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(kP6));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(kP7));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(kP8));
+    y = _mm256_mul_ps(_mm256_mul_ps(y, x), z);
+    y = _mm256_add_ps(y, _mm256_mul_ps(e, _mm256_set1_ps(kQ1)));
+    y = _mm256_sub_ps(y, _mm256_mul_ps(z, _mm256_set1_ps(0.5f)));
+    x = _mm256_add_ps(x, y);
+    return _mm256_add_ps(x, _mm256_mul_ps(e, _mm256_set1_ps(kQ2)));
+}
+
+__attribute__((target("avx2")))
+void kernel_avx2(float* x, size_t n, const KernelConsts& k) {
+    const __m256 amin   = _mm256_set1_ps(k.amin);
+    const __m256 to_db  = _mm256_set1_ps(kLnToDb);
+    const __m256 ref_db = _mm256_set1_ps(k.ref_db);
+    const __m256 lo     = _mm256_set1_ps(k.lo);
+    const __m256 hi     = _mm256_set1_ps(k.hi);
+    const __m256 min_db = _mm256_set1_ps(k.min_db);
+    const __m256 inv    = _mm256_set1_ps(k.inv_range);
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 v  = _mm256_max_ps(_mm256_loadu_ps(x + i), amin);
+        __m256 db = _mm256_sub_ps(_mm256_mul_ps(log_avx2(v), to_db), ref_db);
+        db = _mm256_max_ps(db, lo);
+        if (k.to_unit) {
+            db = _mm256_min_ps(db, hi);
+            db = _mm256_mul_ps(_mm256_sub_ps(db, min_db), inv);
+        }
+        _mm256_storeu_ps(x + i, db);
+    }
+    for (; i < n; ++i) x[i] = db_scalar(x[i], k);
+}
+
+__attribute__((target("avx2")))
+float max_avx2(const float* x, size_t n, float amin) {
+    const __m256 a = _mm256_set1_ps(amin);
+    __m256 acc = a;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        acc = _mm256_max_ps(acc, _mm256_max_ps(_mm256_loadu_ps(x + i), a));
+    float lanes[8];
+    _mm256_storeu_ps(lanes, acc);
+    float m = amin;
+    for (int l = 0; l < 8; ++l) m = std::max(m, lanes[l]);
+    for (; i < n; ++i) m = (x[i] > m) ? x[i] : m;
+    return m;
+}
+#endif
+
+#ifdef DB_KERNEL_NEON
+// NaN-safe max: vmaxq_f32 propagates NaN, so select on a compare instead
+inline float32x4_t max_keep_b(float32x4_t a, float32x4_t b) {
+    return vbslq_f32(vcgtq_f32(a, b), a, b);
+}
+
+inline float32x4_t log_neon(float32x4_t x) {
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    uint32x4_t ux = vreinterpretq_u32_f32(x);
+    int32x4_t emm0 = vreinterpretq_s32_u32(vshrq_n_u32(ux, 23));
+    ux = vorrq_u32(vandq_u32(ux, vdupq_n_u32(0x807fffffu)), vdupq_n_u32(0x3f000000u));
+    x = vreinterpretq_f32_u32(ux);
+    float32x4_t e = vcvtq_f32_s32(vsubq_s32(emm0, vdupq_n_s32(126)));
+
+    const uint32x4_t mask = vcltq_f32(x, vdupq_n_f32(kSqrtHalf));
+    const float32x4_t tmp = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(x), mask));
+    x = vsubq_f32(x, one);
+    e = vsubq_f32(e, vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(one), mask)));
+    x = vaddq_f32(x, tmp);
+
+    const float32x4_t z = vmulq_f32(x, x);
+    float32x4_t y = vdupq_n_f32(kP0);
+    y = vaddq_f32(vmulq_f32(y, x), vdupq_n_f32(kP1));
+    y = vaddq_f32(vmulq_f32(y, x), vdupq_n_f32(kP2));
+    y = vaddq_f32(vmulq_f32(y, x), vdupq_n_f32(kP3));
+    y = vaddq_f32(vmulq_f32(y, x), vdupq_n_f32(kP4));
+    y = vaddq_f32(vmulq_f32(y, x), vdupq_n_f32(kP5));
+    y = vaddq_f32(vmulq_f32(y, x), vdupq_n_f32(kP6));
+    y = vaddq_f32(vmulq_f32(y, x), vdupq_n_f32(kP7));
+    y = vaddq_f32(vmulq_f32(y, x), vdupq_n_f32(kP8));
+    y = vmulq_f32(vmulq_f32(y, x), z);
+    y = vaddq_f32(y, vmulq_f32(e, vdupq_n_f32(kQ1)));
+    y = vsubq_f32(y, vmulq_f32(z, vdupq_n_f32(0.5f)));
+    x = vaddq_f32(x, y);
+    return vaddq_f32(x, vmulq_f32(e, vdupq_n_f32(kQ2)));
+}
+
+void kernel_neon(float* x, size_t n, const KernelConsts& k) {
+    const float32x4_t amin   = vdupq_n_f32(k.amin);
+    const float32x4_t to_db  = vdupq_n_f32(kLnToDb);
+    const float32x4_t ref_db = vdupq_n_f32(k.ref_db);
+    const float32x4_t lo     = vdupq_n_f32(k.lo);
+    const float32x4_t hi     = vdupq_n_f32(k.hi);
+    const float32x4_t min_db = vdupq_n_f32(k.min_db);
+    const float32x4_t inv    = vdupq_n_f32(k.inv_range);
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t v  = max_keep_b(vld1q_f32(x + i), amin);
+        float32x4_t db = vsubq_f32(vmulq_f32(log_neon(v), to_db), ref_db);
+        db = max_keep_b(db, lo);
+        if (k.to_unit) {
+            db = vminq_f32(db, hi);
+            db = vmulq_f32(vsubq_f32(db, min_db), inv);
+        }
+        vst1q_f32(x + i, db);
+    }
+    for (; i < n; ++i) x[i] = db_scalar(x[i], k);
+}
+
+float max_neon(const float* x, size_t n, float amin) {
+    const float32x4_t a = vdupq_n_f32(amin);
+    float32x4_t acc = a;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        acc = vmaxq_f32(acc, max_keep_b(vld1q_f32(x + i), a));
+    float lanes[4];
+    vst1q_f32(lanes, acc);
+    float m = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+    for (; i < n; ++i) m = (x[i] > m) ? x[i] : m;
+    return m;
+}
+#endif
+
+db_kernel::Isa detect_isa() {
+#if defined(DB_KERNEL_AVX2)
+    if (__builtin_cpu_supports("avx2")) return db_kernel::Isa::AVX2;
+#endif
+#if defined(DB_KERNEL_X86)
+    return db_kernel::Isa::SSE2;
+#elif defined(DB_KERNEL_NEON)
+    return db_kernel::Isa::NEON;
+#else
+    return db_kernel::Isa::Scalar;
+#endif
+}
+
+db_kernel::Isa& current_isa() {
+    static db_kernel::Isa isa = detect_isa();
+    return isa;
+}
+
+}
+
+db_kernel::Isa db_kernel::active_isa() {
+    return current_isa();
+}
+
+std::vector<db_kernel::Isa> db_kernel::available_isas() {
+    std::vector<Isa> out(1, Isa::Scalar);
+#if defined(DB_KERNEL_X86)
+    out.push_back(Isa::SSE2);
+#endif
+#if defined(DB_KERNEL_AVX2)
+    if (__builtin_cpu_supports("avx2")) out.push_back(Isa::AVX2);
+#endif
+#if defined(DB_KERNEL_NEON)
+    out.push_back(Isa::NEON);
+#endif
+    return out;
+}
+
+bool db_kernel::set_isa(Isa isa) {
+    const std::vector<Isa> ok = available_isas();
+    if (std::find(ok.begin(), ok.end(), isa) == ok.end()) return false;
+    current_isa() = isa;
+    return true;
+}
+
+const char* db_kernel::isa_name(Isa isa) {
+    switch (isa) {
+    case Isa::SSE2: return "sse2";
+    case Isa::AVX2: return "avx2";
+    case Isa::NEON: return "neon";
+    default:        return "scalar";
+    }
+}
+
+float db_kernel::fast_log10(float x) {
+    return log_scalar(x) * kLnToLog10;
+}
+
+float db_kernel::reduce_max(const float* data, size_t n, float amin) {
+    switch (active_isa()) {
+#ifdef DB_KERNEL_AVX2
+    case Isa::AVX2: return max_avx2(data, n, amin);
+#endif
+#ifdef DB_KERNEL_X86
+    case Isa::SSE2: return max_sse2(data, n, amin);
+#endif
+#ifdef DB_KERNEL_NEON
+    case Isa::NEON: return max_neon(data, n, amin);
+#endif
+    default:        return max_scalar(data, n, amin);
+    }
+}
+
+void db_kernel::power_to_db(float* data, size_t n, const DbParams& p) {
+    if (!data || n == 0) return;
+
+    const float amin  = std::max(p.amin, std::numeric_limits<float>::min());
+    const float s_max = reduce_max(data, n, amin);
+    const float ref   = p.ref_is_max ? s_max : std::max(p.ref_value, amin);
+
+    KernelConsts k;
+    k.amin   = amin;
+    k.ref_db = 10.0f * std::log10(ref);
+
+    // top_db: clip to [max_db - top_db, ...]; with ref == max the max is 0 dB
+    float lo = p.floor_db;
+    if (p.top_db >= 0.0f) {
+        const float max_db = 10.0f * std::log10(s_max) - k.ref_db;
+        lo = std::max(lo, max_db - p.top_db);
+    }
+    k.lo        = lo;
+    k.hi        = p.max_db;
+    k.min_db    = p.min_db;
+    k.inv_range = (p.max_db > p.min_db) ? 1.0f / (p.max_db - p.min_db) : 0.0f;
+    k.to_unit   = p.to_unit;
+    if (k.to_unit) k.lo = std::max(k.lo, p.min_db);
+
+    switch (active_isa()) {
+#ifdef DB_KERNEL_AVX2
+    case Isa::AVX2: kernel_avx2(data, n, k); break;
+#endif
+#ifdef DB_KERNEL_X86
+    case Isa::SSE2: kernel_sse2(data, n, k); break;
+#endif
+#ifdef DB_KERNEL_NEON
+    case Isa::NEON: kernel_neon(data, n, k); break;
+#endif
+    default:        kernel_scalar(data, n, k); break;
+    }
+}
+
+}
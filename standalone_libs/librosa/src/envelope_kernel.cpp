@@ -0,0 +1,189 @@
+#include "envelope_kernel.h"
+
+#include <algorithm>
+#include <limits>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#define ENVELOPE_KERNEL_X86 1
+#include <emmintrin.h>
+#if defined(__GNUC__)
+#define ENVELOPE_KERNEL_AVX2 1
+#include <immintrin.h>
+#endif
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define ENVELOPE_KERNEL_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace raiden {
+
+namespace {
+
+// the accumulators start at +inf / -inf and only take non NaN values
+// (v < lo ? v : lo), so a NaN sample never reaches the result
+
+void minmax_scalar(const float* x, size_t n, float& mn, float& mx) {
+    float lo = std::numeric_limits<float>::infinity(), hi = -lo;
+    for (size_t i = 0; i < n; ++i) {
+        const float v = x[i];
+        if (v < lo) lo = v;
+        if (v > hi) hi = v;
+    }
+    mn = lo;
+    mx = hi;
+}
+
+#ifdef ENVELOPE_KERNEL_X86
+void minmax_sse2(const float* x, size_t n, float& mn, float& mx) {
+    float lo = std::numeric_limits<float>::infinity(), hi = -lo;
+    size_t i = 0;
+    if (n >= 8) {
+        // min_ps(a, b) returns b when either is NaN
+        __m128 vlo = _mm_set1_ps(lo), vhi = _mm_set1_ps(hi);
+        __m128 vlo2 = vlo, vhi2 = vhi;
+        for (; i + 8 <= n; i += 8) {
+            const __m128 a = _mm_loadu_ps(x + i);
+            const __m128 b = _mm_loadu_ps(x + i + 4);
+            vlo  = _mm_min_ps(a, vlo);
+            vhi  = _mm_max_ps(a, vhi);
+            vlo2 = _mm_min_ps(b, vlo2);
+            vhi2 = _mm_max_ps(b, vhi2);
+        }
+        float l[4];
+        _mm_storeu_ps(l, _mm_min_ps(vlo, vlo2)); lo = std::min(std::min(l[0], l[1]), std::min(l[2], l[3]));
+        _mm_storeu_ps(l, _mm_max_ps(vhi, vhi2)); hi = std::max(std::max(l[0], l[1]), std::max(l[2], l[3]));
+    }
+    for (; i < n; ++i) {
+        const float v = x[i];
+        if (v < lo) lo = v;
+        if (v > hi) hi = v;
+    }
+    mn = lo;
+    mx = hi;
+}
+#endif
+
+#ifdef ENVELOPE_KERNEL_AVX2
+__attribute__((target("avx2")))
+void minmax_avx2(const float* x, size_t n, float& mn, float& mx) {
+    float lo = std::numeric_limits<float>::infinity(), hi = -lo;
+    size_t i = 0;
+    if (n >= 16) {
+        __m256 vlo = _mm256_set1_ps(lo), vhi = _mm256_set1_ps(hi);
+        __m256 vlo2 = vlo, vhi2 = vhi;
+        for (; i + 16 <= n; i += 16) {
+            const __m256 a = _mm256_loadu_ps(x + i);
+            const __m256 b = _mm256_loadu_ps(x + i + 8);
+            vlo  = _mm256_min_ps(a, vlo);
+            vhi  = _mm256_max_ps(a, vhi);
+            vlo2 = _mm256_min_ps(b, vlo2);
+            vhi2 = _mm256_max_ps(b, vhi2);
+        }
+        float l[8];
+        _mm256_storeu_ps(l, _mm256_min_ps(vlo, vlo2));
+        for (int k = 0; k < 8; ++k) lo = std::min(lo, l[k]);
+        _mm256_storeu_ps(l, _mm256_max_ps(vhi, vhi2));
+        for (int k = 0; k < 8; ++k) hi = std::max(hi, l[k]);
+    }
+    for (; i < n; ++i) {
+        const float v = x[i];
+        if (v < lo) lo = v;
+        if (v > hi) hi = v;
+    }
+    mn = lo;
+    mx = hi;
+}
+#endif
+
+#ifdef ENVELOPE_KERNEL_NEON
+void minmax_neon(const float* x, size_t n, float& mn, float& mx) {
+    float lo = std::numeric_limits<float>::infinity(), hi = -lo;
+    size_t i = 0;
+    if (n >= 4) {
+        // vminq/vmaxq propagate NaN, select instead
+        float32x4_t vlo = vdupq_n_f32(lo), vhi = vdupq_n_f32(hi);
+        for (; i + 4 <= n; i += 4) {
+            const float32x4_t v = vld1q_f32(x + i);
+            vlo = vbslq_f32(vcltq_f32(v, vlo), v, vlo);
+            vhi = vbslq_f32(vcgtq_f32(v, vhi), v, vhi);
+        }
+        float l[4];
+        vst1q_f32(l, vlo); lo = std::min(std::min(l[0], l[1]), std::min(l[2], l[3]));
+        vst1q_f32(l, vhi); hi = std::max(std::max(l[0], l[1]), std::max(l[2], l[3]));
+    }
+    for (; i < n; ++i) {
+        const float v = x[i];
+        if (v < lo) lo = v;
+        if (v > hi) hi = v;
+    }
+    mn = lo;
+    mx = hi;
+}
+#endif
+
+typedef void (*MinMaxFn)(const float*, size_t, float&, float&);
+
+MinMaxFn pick_minmax() {
+    switch (envelope_kernel::active_isa()) {
+#ifdef ENVELOPE_KERNEL_AVX2
+    case db_kernel::Isa::AVX2: return minmax_avx2;
+#endif
+#ifdef ENVELOPE_KERNEL_X86
+    case db_kernel::Isa::SSE2: return minmax_sse2;
+#endif
+#ifdef ENVELOPE_KERNEL_NEON
+    case db_kernel::Isa::NEON: return minmax_neon;
+#endif
+    default:                   return minmax_scalar;
+    }
+}
+
+inline float clamp_unit(float v) {
+    return std::max(-1.f, std::min(1.f, v));
+}
+
+}
+
+void envelope_kernel::minmax(const float* x, size_t n, float& mn, float& mx) {
+    static const MinMaxFn fn = pick_minmax();
+    fn(x, n, mn, mx);
+}
+
+size_t envelope_kernel::vertex_floats(size_t n, int pixel_w) {
+    if (n == 0 || pixel_w <= 0) return 0;
+    return n <= size_t(pixel_w) ? n * 2 : size_t(pixel_w) * 4;
+}
+
+int envelope_kernel::write_vertices(const float* x, size_t n, int pixel_w, float gain, float* out) {
+    if (!x || !out || n == 0 || pixel_w <= 0) return 0;
+
+    if (n <= size_t(pixel_w)) {
+        // high resolution: one vertex per sample (LINE_STRIP)
+        for (size_t i = 0; i < n; ++i) {
+            out[2 * i]     = (n > 1) ? (float)i / (float)(n - 1) * 2.f - 1.f : -1.f;
+            out[2 * i + 1] = clamp_unit(x[i] * gain);
+        }
+        return int(n);
+    }
+
+    // envelope: per pixel min/max (LINES); the last pixel takes the remainder.
+    // gain > 0, so min(x) * gain == min(x * gain) and the scale is done once per pixel
+    const size_t spp = std::max<size_t>(1, n / size_t(pixel_w));
+    static const MinMaxFn fn = pick_minmax();
+    float* o = out;
+    for (int px = 0; px < pixel_w; ++px) {
+        const size_t s0 = size_t(px) * spp;
+        const size_t s1 = (px == pixel_w - 1) ? n : std::min(n, s0 + spp);
+        float vmin, vmax;
+        fn(x + s0, s1 - s0, vmin, vmax);
+        const float x_ndc = (pixel_w == 1) ? 0.f : ((float)px / (float)(pixel_w - 1) * 2.f - 1.f);
+        o[0] = x_ndc; o[1] = clamp_unit(vmin * gain);
+        o[2] = x_ndc; o[3] = clamp_unit(vmax * gain);
+        o += 4;
+    }
+    return pixel_w * 2;
+}
+
+}
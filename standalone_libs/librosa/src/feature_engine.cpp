@@ -0,0 +1,173 @@
+#include "feature_engine.h"
+#include "signal_reader.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define FEATURE_ENGINE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define FEATURE_ENGINE_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace raiden {
+
+size_t AudioFeatures::frameAt(double sec) const {
+    if (hop <= 0 || sr <= 0 || rms.empty() || !(sec > 0.0)) return 0;
+    // compare in double first, a time past the end must not overflow the cast
+    const double i = std::floor(sec * double(sr) / double(hop));
+    const size_t last = rms.size() - 1;
+    return i >= double(last) ? last : size_t(i);
+}
+
+FeatureEngine::FeatureEngine(int sr, int hop) {
+    out_.sr = sr;
+    out_.hop = std::max(1, hop);
+    out_.peaks = PeakIndex(sr);
+}
+
+// x[0] is compared against prev for the crossing count; sign test is x >= 0 (zero counts as positive)
+void FeatureEngine::accumulate(const float* x, size_t n, float prev, Acc& acc) {
+    size_t i = 0;
+    float sum_sq = 0.0f, sum_abs = 0.0f, max_abs = acc.max_abs;
+    int crossings = 0;
+
+#if defined(FEATURE_ENGINE_SSE2)
+    if (n >= 8) {
+        const __m128 sign = _mm_set1_ps(-0.0f);
+        const __m128 zero = _mm_setzero_ps();
+        __m128 vsq = zero, vabs = zero, vmax = _mm_set1_ps(max_abs);
+        // lane 0 of the shifted vector is prev, the rest come from x
+        __m128 vprev = _mm_set_ps(x[2], x[1], x[0], prev);
+        // max_ps(a, b) returns b when either is NaN: a NaN sample never becomes the peak, as in the scalar loop
+        for (; i + 4 <= n; i += 4) {
+            const __m128 v = _mm_loadu_ps(x + i);
+            if (i) vprev = _mm_loadu_ps(x + i - 1);
+            const __m128 a = _mm_andnot_ps(sign, v);
+            vsq  = _mm_add_ps(vsq, _mm_mul_ps(v, v));
+            vabs = _mm_add_ps(vabs, a);
+            vmax = _mm_max_ps(a, vmax);
+            const __m128 flip = _mm_xor_ps(_mm_cmpge_ps(v, zero), _mm_cmpge_ps(vprev, zero));
+            const int m = _mm_movemask_ps(flip);
+            crossings += (m & 1) + ((m >> 1) & 1) + ((m >> 2) & 1) + ((m >> 3) & 1);
+        }
+        float l[4];
+        _mm_storeu_ps(l, vsq);  sum_sq  = (l[0] + l[1]) + (l[2] + l[3]);
+        _mm_storeu_ps(l, vabs); sum_abs = (l[0] + l[1]) + (l[2] + l[3]);
+        _mm_storeu_ps(l, vmax); max_abs = std::max(std::max(l[0], l[1]), std::max(l[2], l[3]));
+    }
+#elif defined(FEATURE_ENGINE_NEON)
+    if (n >= 8) {
+        const float32x4_t zero = vdupq_n_f32(0.0f);
+        float32x4_t vsq = zero, vabs = zero, vmax = vdupq_n_f32(max_abs);
+        uint32x4_t vcross = vdupq_n_u32(0);
+        float first[4] = { prev, x[0], x[1], x[2] };
+        float32x4_t vprev = vld1q_f32(first);
+        // vmaxq propagates NaN, select instead (a NaN compares false and is skipped)
+        for (; i + 4 <= n; i += 4) {
+            const float32x4_t v = vld1q_f32(x + i);
+            if (i) vprev = vld1q_f32(x + i - 1);
+            const float32x4_t a = vabsq_f32(v);
+            vsq  = vmlaq_f32(vsq, v, v);
+            vabs = vaddq_f32(vabs, a);
+            vmax = vbslq_f32(vcgtq_f32(a, vmax), a, vmax);
+            const uint32x4_t flip = veorq_u32(vcgeq_f32(v, zero), vcgeq_f32(vprev, zero));
+            vcross = vaddq_u32(vcross, vshrq_n_u32(flip, 31));
+        }
+        float l[4];
+        vst1q_f32(l, vsq);  sum_sq  = (l[0] + l[1]) + (l[2] + l[3]);
+        vst1q_f32(l, vabs); sum_abs = (l[0] + l[1]) + (l[2] + l[3]);
+        vst1q_f32(l, vmax); max_abs = std::max(std::max(l[0], l[1]), std::max(l[2], l[3]));
+        uint32_t c[4];
+        vst1q_u32(c, vcross);
+        crossings = int(c[0] + c[1] + c[2] + c[3]);
+    }
+#endif
+
+    for (; i < n; ++i) {
+        const float v = x[i];
+        const float a = std::fabs(v);
+        const float p = i ? x[i - 1] : prev;
+        sum_sq += v * v;
+        sum_abs += a;
+        if (a > max_abs) max_abs = a;
+        crossings += ((v >= 0.0f) != (p >= 0.0f)) ? 1 : 0;
+    }
+
+    acc.sum_sq += sum_sq;
+    acc.sum_abs += sum_abs;
+    acc.max_abs = max_abs;
+    acc.crossings += crossings;
+}
+
+void FeatureEngine::emit(const Acc& acc, size_t n) {
+    const float inv = 1.0f / float(n);
+    const float rms = std::sqrt(acc.sum_sq * inv);
+    out_.rms.push_back(rms);
+    out_.peak.push_back(acc.max_abs);
+    out_.mean_abs.push_back(acc.sum_abs * inv);
+    out_.zcr.push_back(float(acc.crossings) * inv);
+    out_.crest.push_back(rms > 0.0f ? acc.max_abs / rms : 0.0f);
+    out_.global_peak = std::max(out_.global_peak, acc.max_abs);
+}
+
+void FeatureEngine::push(const float* x, size_t n) {
+    const size_t hop = size_t(out_.hop);
+    out_.total_samples += int64_t(n);
+    out_.peaks.push(x, n);   // chunk is still in cache
+    while (n > 0) {
+        const size_t take = std::min(n, hop - in_frame_);
+        // the first sample of the stream has no predecessor: compare it with itself
+        const float prev = has_prev_ ? prev_ : x[0];
+        accumulate(x, take, prev, acc_);
+        prev_ = x[take - 1];
+        has_prev_ = true;
+        in_frame_ += take;
+        x += take;
+        n -= take;
+        if (in_frame_ == hop) {
+            emit(acc_, hop);
+            acc_ = Acc();
+            in_frame_ = 0;
+        }
+    }
+}
+
+AudioFeatures FeatureEngine::finish() {
+    if (in_frame_ > 0) {
+        emit(acc_, in_frame_);
+        acc_ = Acc();
+        in_frame_ = 0;
+    }
+    out_.peaks.finish();
+    AudioFeatures out;
+    std::swap(out, out_);
+    out_.sr = out.sr;
+    out_.hop = out.hop;
+    out_.peaks = PeakIndex(out.sr);
+    has_prev_ = false;
+    return out;
+}
+
+AudioFeatures FeatureEngine::analyze(SignalReader& reader, int hop, const std::atomic<bool>* cancel) {
+    // sequential, every block read once: the shared LRU would only lose the interactive windows
+    std::shared_ptr<SignalReader> own = SignalReader::open(reader.path(), reader.mono(), reader.blockFrames(), 2);
+    SignalReader& src = own ? *own : reader;
+    FeatureEngine engine(src.sampleRate(), hop);
+    const size_t chunk = src.blockFrames();
+    std::vector<float> buf(chunk);
+    for (int64_t pos = 0; pos < src.frames(); ) {
+        if (cancel && cancel->load()) return AudioFeatures();
+        const size_t got = src.readFrames(pos, buf.data(), chunk);
+        if (got == 0) break;
+        engine.push(buf.data(), got);
+        pos += int64_t(got);
+    }
+    return engine.finish();
+}
+
+}
@@ -1,5 +1,6 @@
 #include "internal_tools.h"
 #include <iostream>
+#include <algorithm>
 
 namespace raiden {
 
@@ -102,18 +103,15 @@ Spectrogram internal_tools::buildTile(const Eigen::MatrixXf &data) {
     const int tileWidth = data.cols() * magnifyX;
     const int tileHeight = data.rows() * magnifyY;
 
-    std::vector<float> tileData;
-    tileData.reserve(tileWidth * tileHeight);
+    std::vector<float> tileData((size_t)tileWidth * (size_t)tileHeight);
 
     for (int row = 0; row < data.rows(); ++row) {
-        for (int y = 0; y < magnifyY; ++y) { // magnify vertically
-            for (int col = 0; col < data.cols(); ++col) {
-                float value = data(row, col);
-                for (int x = 0; x < magnifyX; ++x) { // magnify horizontally
-                    tileData.push_back(value);
-                }
-            }
-        }
+        // magnify horizontally once, then repeat that line magnifyY times
+        float* line = tileData.data() + (size_t)row * magnifyY * tileWidth;
+        for (int col = 0; col < data.cols(); ++col)
+            std::fill_n(line + (size_t)col * magnifyX, magnifyX, data(row, col));
+        for (int y = 1; y < magnifyY; ++y)
+            std::copy(line, line + tileWidth, line + (size_t)y * tileWidth);
     }
 
     return { tileWidth, tileHeight, tileData };
@@ -15,7 +15,8 @@
 
 namespace raiden {
 
-Signal audio::load(const std::string& path, const int& sr, const bool& mono, const float& offset, const float& duration) {
+Signal audio::load(const std::string& path, const int& sr, const bool& mono, const float& offset, const float& duration,
+                   const ResampleQuality& quality) {
     SF_INFO info{};
     int target_sr = sr;
     float duration_sec = duration;
@@ -90,7 +91,7 @@ Signal audio::load(const std::string& path, const int& sr, const bool& mono, con
         sd.src_ratio     = ratio;
         sd.end_of_input  = 1;
 
-        if (src_simple(&sd, SRC_SINC_BEST_QUALITY, 1) != 0) {
+        if (src_simple(&sd, StreamResampler::srcConverter(quality), 1) != 0) {
             return {{}, 0};
         }
         out.resize(static_cast<size_t>(sd.output_frames_gen));
@@ -100,6 +101,52 @@ Signal audio::load(const std::string& path, const int& sr, const bool& mono, con
     return { std::move(mono_buf), out_sr };
 }
 
+Signal audio::loadStream(const std::string& path, StreamResampler& resampler, const int& sr, const bool& mono,
+                         const float& offset, const float& duration) {
+    SF_INFO info{};
+    SNDFILE* f = sf_open(path.c_str(), SFM_READ, &info);
+    if (!f) return {{}, 0};
+
+    const int src_sr = info.samplerate;
+    const int ch     = info.channels;
+    if (sr <= 0 || sr == src_sr || src_sr <= 0 || ch <= 0) {
+        sf_close(f);
+        return load(path, sr, mono, offset, duration, resampler.quality());
+    }
+
+    const double ratio = double(sr) / double(src_sr);
+    const int64_t total_out = static_cast<int64_t>(std::floor(double(info.frames) * ratio));
+    const int64_t out_start = std::min<int64_t>(total_out, llround(std::max(0.f, offset) * double(sr)));
+    int64_t out_count = (duration < 0.f) ? (total_out - out_start) : llround(double(duration) * double(sr));
+    out_count = std::min<int64_t>(out_count, total_out - out_start);
+    if (out_count <= 0) { sf_close(f); return {{}, sr}; }
+
+    // mono source frames straight from the file, same downmix rule as load()
+    std::vector<float> interleaved;
+    StreamResampler::SourceFn source = [&](int64_t pos, float* buf, size_t n) -> size_t {
+        if (pos >= info.frames) return 0;
+        if (sf_seek(f, pos, SEEK_SET) < 0) return 0;
+        interleaved.resize(n * size_t(ch));
+        const sf_count_t got = sf_readf_float(f, interleaved.data(), sf_count_t(n));
+        if (got <= 0) return 0;
+        for (sf_count_t i = 0; i < got; ++i) {
+            const float* fr = interleaved.data() + size_t(i) * size_t(ch);
+            if (ch == 1 || !mono) {
+                buf[i] = fr[0];
+            } else {
+                float sum = 0.f;
+                for (int c = 0; c < ch; ++c) sum += fr[c];
+                buf[i] = sum / float(ch);
+            }
+        }
+        return size_t(got);
+    };
+
+    std::vector<float> out = resampler.read(out_start, size_t(out_count), src_sr, sr, source);
+    sf_close(f);
+    return { std::move(out), sr };
+}
+
 static inline int16_t read_s16_be(const uint8_t* p)
 {
     // p[0] = high byte, p[1] = low byte (big-endian)
@@ -0,0 +1,157 @@
+#include "peak_index.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define PEAK_INDEX_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define PEAK_INDEX_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace raiden {
+
+namespace {
+
+const int kSpp[PeakIndex::kLevels] = { 64, 1024, 16384, 262144 };
+
+void reduce(const float* x, size_t n, float& mn, float& mx, double& sum_sq) {
+    size_t i = 0;
+    float lo = x[0], hi = x[0], sq = 0.0f;
+#if defined(PEAK_INDEX_SSE2)
+    if (n >= 4) {
+        __m128 vlo = _mm_loadu_ps(x), vhi = vlo, vsq = _mm_setzero_ps();
+        for (; i + 4 <= n; i += 4) {
+            const __m128 v = _mm_loadu_ps(x + i);
+            vlo = _mm_min_ps(vlo, v);
+            vhi = _mm_max_ps(vhi, v);
+            vsq = _mm_add_ps(vsq, _mm_mul_ps(v, v));
+        }
+        float l[4];
+        _mm_storeu_ps(l, vlo); lo = std::min(std::min(l[0], l[1]), std::min(l[2], l[3]));
+        _mm_storeu_ps(l, vhi); hi = std::max(std::max(l[0], l[1]), std::max(l[2], l[3]));
+        _mm_storeu_ps(l, vsq); sq = (l[0] + l[1]) + (l[2] + l[3]);
+    }
+#elif defined(PEAK_INDEX_NEON)
+    if (n >= 4) {
+        float32x4_t vlo = vld1q_f32(x), vhi = vlo, vsq = vdupq_n_f32(0.0f);
+        for (; i + 4 <= n; i += 4) {
+            const float32x4_t v = vld1q_f32(x + i);
+            vlo = vminq_f32(vlo, v);
+            vhi = vmaxq_f32(vhi, v);
+            vsq = vmlaq_f32(vsq, v, v);
+        }
+        float l[4];
+        vst1q_f32(l, vlo); lo = std::min(std::min(l[0], l[1]), std::min(l[2], l[3]));
+        vst1q_f32(l, vhi); hi = std::max(std::max(l[0], l[1]), std::max(l[2], l[3]));
+        vst1q_f32(l, vsq); sq = (l[0] + l[1]) + (l[2] + l[3]);
+    }
+#endif
+    for (; i < n; ++i) {
+        lo = std::min(lo, x[i]);
+        hi = std::max(hi, x[i]);
+        sq += x[i] * x[i];
+    }
+    mn = lo;
+    mx = hi;
+    sum_sq = double(sq);
+}
+
+}
+
+void PeakIndex::Acc::add(float a_mn, float a_mx, double a_sq, size_t a_n) {
+    if (n == 0) { mn = a_mn; mx = a_mx; }
+    else { mn = std::min(mn, a_mn); mx = std::max(mx, a_mx); }
+    sum_sq += a_sq;
+    n += a_n;
+}
+
+PeakIndex::PeakIndex(int sr) : sr_(sr) {
+    for (int i = 0; i < kLevels; ++i) levels_[i].spp = kSpp[i];
+}
+
+void PeakIndex::emit(int lvl, const Acc& acc) {
+    Level& L = levels_[lvl];
+    L.min.push_back(acc.mn);
+    L.max.push_back(acc.mx);
+    L.rms.push_back(float(std::sqrt(acc.sum_sq / double(acc.n))));
+    // coarser levels are built from finished entries of the finer one
+    if (lvl + 1 < kLevels) {
+        Acc& up = acc_[lvl + 1];
+        up.add(acc.mn, acc.mx, acc.sum_sq, acc.n);
+        if (up.n >= size_t(levels_[lvl + 1].spp)) {
+            emit(lvl + 1, up);
+            up = Acc();
+        }
+    }
+}
+
+void PeakIndex::push(const float* x, size_t n) {
+    const size_t spp = size_t(levels_[0].spp);
+    total_ += int64_t(n);
+    while (n > 0) {
+        Acc& a = acc_[0];
+        const size_t take = std::min(n, spp - a.n);
+        float mn, mx;
+        double sq;
+        reduce(x, take, mn, mx, sq);
+        a.add(mn, mx, sq, take);
+        global_peak_ = std::max(global_peak_, std::max(std::fabs(mn), std::fabs(mx)));
+        x += take;
+        n -= take;
+        if (a.n == spp) {
+            emit(0, a);
+            a = Acc();
+        }
+    }
+}
+
+void PeakIndex::finish() {
+    for (int lvl = 0; lvl < kLevels; ++lvl) {
+        if (acc_[lvl].n == 0) continue;
+        const Acc a = acc_[lvl];
+        acc_[lvl] = Acc();
+        emit(lvl, a);
+        // the parent got a partial entry from emit; leave it for the next iteration to flush
+    }
+}
+
+bool PeakIndex::project(int64_t s0, int64_t s1, int pixel_w, float* out_min, float* out_max, float* out_rms) const {
+    if (pixel_w <= 0 || s1 <= s0 || empty()) return false;
+    const double spp = double(s1 - s0) / double(pixel_w);
+
+    int lvl = -1;
+    for (int i = kLevels - 1; i >= 0; --i) {
+        if (levels_[i].spp <= spp && levels_[i].size() > 0) { lvl = i; break; }
+    }
+    if (lvl < 0) return false;
+
+    const Level& L = levels_[lvl];
+    const int64_t count = int64_t(L.size());
+    for (int px = 0; px < pixel_w; ++px) {
+        const double a = double(s0) + spp * px;
+        const double b = a + spp;
+        int64_t e0 = int64_t(a) / L.spp;
+        int64_t e1 = int64_t(std::ceil(b / double(L.spp)));
+        e0 = std::min(e0, count - 1);
+        e1 = std::max(e0 + 1, std::min(e1, count));
+
+        float mn = L.min[size_t(e0)], mx = L.max[size_t(e0)];
+        double sq = double(L.rms[size_t(e0)]) * L.rms[size_t(e0)];
+        for (int64_t e = e0 + 1; e < e1; ++e) {
+            mn = std::min(mn, L.min[size_t(e)]);
+            mx = std::max(mx, L.max[size_t(e)]);
+            sq += double(L.rms[size_t(e)]) * L.rms[size_t(e)];
+        }
+        out_min[px] = mn;
+        out_max[px] = mx;
+        if (out_rms) out_rms[px] = float(std::sqrt(sq / double(e1 - e0)));
+    }
+    return true;
+}
+
+}
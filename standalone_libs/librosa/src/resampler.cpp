@@ -0,0 +1,153 @@
+#include "resampler.h"
+
+#include <samplerate.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace raiden {
+
+namespace {
+
+const size_t kBlock   = 4096; // source frames per pull
+const int    kPrimeMs = 20;   // history fed ahead of a seek target, longer than the best sinc half length
+
+int64_t gcd64(int64_t a, int64_t b) {
+    while (b) { int64_t t = a % b; a = b; b = t; }
+    return a;
+}
+
+}
+
+int StreamResampler::srcConverter(ResampleQuality quality) {
+    switch (quality) {
+    case ResampleQuality::Linear:     return SRC_LINEAR;
+    case ResampleQuality::SincFast:   return SRC_SINC_FASTEST;
+    case ResampleQuality::SincMedium: return SRC_SINC_MEDIUM_QUALITY;
+    default:
+    case ResampleQuality::SincBest:   return SRC_SINC_BEST_QUALITY;
+    }
+}
+
+StreamResampler::StreamResampler(ResampleQuality quality) : quality_(quality) {}
+
+StreamResampler::~StreamResampler() {
+    reset();
+}
+
+void StreamResampler::reset() {
+    if (state_) src_delete(static_cast<SRC_STATE*>(state_));
+    state_ = nullptr;
+    src_sr_ = dst_sr_ = 0;
+    fifo_.clear();
+    fifo_start_ = 0;
+    in_pos_ = 0;
+    eof_ = false;
+}
+
+void StreamResampler::setQuality(ResampleQuality quality) {
+    if (quality == quality_) return;
+    quality_ = quality;
+    reset();
+}
+
+void StreamResampler::seek(int64_t out_start) {
+    // restart a little before the target, on a frame where the input and output grids meet,
+    // so fifo_start_ stays an exact output index
+    const int64_t prime = int64_t(src_sr_) * kPrimeMs / 1000;
+    int64_t in_target = int64_t(std::floor(double(out_start) * src_sr_ / dst_sr_)) - prime;
+    if (in_target < 0) in_target = 0;
+    const int64_t k = in_target / in_step_;
+
+    in_pos_ = k * in_step_;
+    fifo_start_ = k * out_step_;
+    fifo_.clear();
+    eof_ = false;
+    src_reset(static_cast<SRC_STATE*>(state_));
+    ++seeks_;
+}
+
+bool StreamResampler::pull(const SourceFn& source) {
+    if (eof_) return false;
+
+    in_buf_.resize(kBlock);
+    const size_t got = source(in_pos_, in_buf_.data(), kBlock);
+    const bool end = (got == 0);
+
+    const double ratio = double(dst_sr_) / double(src_sr_);
+    out_buf_.resize(size_t(std::ceil(double(kBlock) * ratio)) + 64);
+
+    SRC_DATA sd{};
+    size_t used = 0;
+    do {
+        sd.data_in       = in_buf_.data() + used;
+        sd.input_frames  = long(got - used);
+        sd.data_out      = out_buf_.data();
+        sd.output_frames = long(out_buf_.size());
+        sd.src_ratio     = ratio;
+        sd.end_of_input  = end ? 1 : 0;
+        if (src_process(static_cast<SRC_STATE*>(state_), &sd) != 0) {
+            eof_ = true;
+            return false;
+        }
+        fifo_.insert(fifo_.end(), out_buf_.data(), out_buf_.data() + sd.output_frames_gen);
+        used += size_t(sd.input_frames_used);
+    } while (used < got || (end && sd.output_frames_gen > 0)); // at the end, drain the filter tail
+
+    in_pos_ += int64_t(got);
+    frames_in_ += int64_t(got);
+    if (end) eof_ = true;
+    return true;
+}
+
+std::vector<float> StreamResampler::read(int64_t out_start, size_t out_count, int src_sr, int dst_sr, const SourceFn& source) {
+    if (src_sr <= 0 || dst_sr <= 0 || out_count == 0 || out_start < 0) return {};
+
+    if (src_sr == dst_sr) {
+        std::vector<float> out(out_count);
+        size_t n = 0;
+        while (n < out_count) {
+            const size_t got = source(out_start + int64_t(n), out.data() + n, out_count - n);
+            if (got == 0) break;
+            n += got;
+        }
+        out.resize(n);
+        return out;
+    }
+
+    if (!state_ || src_sr != src_sr_ || dst_sr != dst_sr_) {
+        reset();
+        int err = 0;
+        state_ = src_new(srcConverter(quality_), 1, &err);
+        if (!state_) return {};
+        src_sr_ = src_sr;
+        dst_sr_ = dst_sr;
+        const int64_t g = gcd64(src_sr, dst_sr);
+        in_step_  = src_sr / g;
+        out_step_ = dst_sr / g;
+        seek(out_start);
+    } else {
+        // contiguous (or a short skip forward): keep the filter state
+        const int64_t fifo_end = fifo_start_ + int64_t(fifo_.size());
+        const int64_t max_skip = dst_sr_ / 2;
+        if (out_start < fifo_start_ || out_start > fifo_end + max_skip) seek(out_start);
+    }
+
+    const int64_t want_end = out_start + int64_t(out_count);
+    for (;;) {
+        // drop output that lies before the request
+        if (fifo_start_ < out_start) {
+            const size_t drop = size_t(std::min<int64_t>(int64_t(fifo_.size()), out_start - fifo_start_));
+            fifo_.erase(fifo_.begin(), fifo_.begin() + drop);
+            fifo_start_ += int64_t(drop);
+        }
+        if (fifo_start_ + int64_t(fifo_.size()) >= want_end || eof_) break;
+        if (!pull(source)) break;
+    }
+
+    if (fifo_start_ != out_start) return {};
+    const size_t avail = std::min(out_count, fifo_.size());
+    return std::vector<float>(fifo_.begin(), fifo_.begin() + avail);
+}
+
+}
@@ -0,0 +1,169 @@
+#include "signal_reader.h"
+
+#include <sndfile.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace raiden {
+
+std::shared_ptr<SignalReader> SignalReader::open(const std::string& path, bool mono, size_t block_frames, size_t max_blocks) {
+    SF_INFO info{};
+    SNDFILE* f = sf_open(path.c_str(), SFM_READ, &info);
+    if (!f) return nullptr;
+    if (info.samplerate <= 0 || info.channels <= 0) { sf_close(f); return nullptr; }
+
+    std::shared_ptr<SignalReader> r(new SignalReader());
+    r->path_ = path;
+    r->file_ = f;
+    r->mono_ = mono;
+    r->src_sr_ = info.samplerate;
+    r->channels_ = info.channels;
+    r->frames_ = info.frames;
+    r->block_frames_ = std::max<size_t>(1024, block_frames);
+    r->max_blocks_ = std::max<size_t>(2, max_blocks);
+    return r;
+}
+
+SignalReader::~SignalReader() {
+    if (file_) sf_close(static_cast<SNDFILE*>(file_));
+}
+
+SignalReader::Block SignalReader::decode(int64_t index) {
+    SNDFILE* f = static_cast<SNDFILE*>(file_);
+    const int64_t start = index * int64_t(block_frames_);
+    const int64_t want = std::min<int64_t>(int64_t(block_frames_), frames_ - start);
+    if (want <= 0 || sf_seek(f, start, SEEK_SET) < 0) return nullptr;
+
+    interleaved_.resize(size_t(want) * size_t(channels_));
+    const sf_count_t got = sf_readf_float(f, interleaved_.data(), want);
+    if (got <= 0) return nullptr;
+
+    std::shared_ptr<std::vector<float>> out = std::make_shared<std::vector<float>>(size_t(got));
+    float* dst = out->data();
+    if (channels_ == 1) {
+        std::copy_n(interleaved_.data(), size_t(got), dst);
+    } else if (mono_) {
+        const float inv = 1.0f / float(channels_);
+        for (sf_count_t i = 0; i < got; ++i) {
+            const float* fr = interleaved_.data() + size_t(i) * size_t(channels_);
+            float sum = 0.f;
+            for (int c = 0; c < channels_; ++c) sum += fr[c];
+            dst[i] = sum * inv;
+        }
+    } else {
+        for (sf_count_t i = 0; i < got; ++i)
+            dst[i] = interleaved_[size_t(i) * size_t(channels_)];
+    }
+    return out;
+}
+
+SignalReader::Block SignalReader::block(int64_t index, std::unique_lock<std::mutex>& lk) {
+    while (true) {
+        auto it = blocks_.find(index);
+        if (it != blocks_.end()) {
+            lru_.splice(lru_.begin(), lru_, it->second.second);
+            ++stats_.hits;
+            return it->second.first;
+        }
+        if (inflight_.count(index) == 0) break;
+        decoded_.wait(lk);   // another reader is decoding it
+    }
+    ++stats_.misses;
+    inflight_.insert(index);
+
+    lk.unlock();
+    Block b;
+    {
+        std::lock_guard<std::mutex> fl(file_mtx_);
+        b = decode(index);
+    }
+    lk.lock();
+
+    inflight_.erase(index);
+    decoded_.notify_all();
+    if (!b) return nullptr;
+
+    stats_.decoded_frames += int64_t(b->size());
+    lru_.push_front(index);
+    blocks_[index] = std::make_pair(b, lru_.begin());
+    while (blocks_.size() > max_blocks_) {
+        blocks_.erase(lru_.back());
+        lru_.pop_back();
+    }
+    return b;
+}
+
+size_t SignalReader::readFrames(int64_t pos, float* buf, size_t n) {
+    if (pos < 0 || pos >= frames_ || n == 0) return 0;
+    n = size_t(std::min<int64_t>(int64_t(n), frames_ - pos));
+
+    // grab the blocks under the lock, copy out of them after it is released
+    const int64_t first = pos / int64_t(block_frames_);
+    const int64_t last  = (pos + int64_t(n) - 1) / int64_t(block_frames_);
+    std::vector<Block> held;
+    held.reserve(size_t(last - first + 1));
+    {
+        std::unique_lock<std::mutex> lk(mtx_);
+        for (int64_t i = first; i <= last; ++i) {
+            Block b = block(i, lk);
+            if (!b) break;
+            held.push_back(std::move(b));
+        }
+    }
+
+    size_t done = 0;
+    for (size_t k = 0; k < held.size() && done < n; ++k) {
+        const int64_t block_start = (first + int64_t(k)) * int64_t(block_frames_);
+        const size_t from = size_t(pos + int64_t(done) - block_start);
+        if (from >= held[k]->size()) break;
+        const size_t take = std::min(n - done, held[k]->size() - from);
+        std::copy_n(held[k]->data() + from, take, buf + done);
+        done += take;
+    }
+    return done;
+}
+
+Signal SignalReader::read(float offset, float duration, int sr, StreamResampler* resampler, ResampleQuality quality) {
+    if (offset < 0.f) offset = 0.f;
+    const int out_sr = (sr > 0) ? sr : src_sr_;
+    const int64_t out_start = llround(double(offset) * out_sr);
+    const int64_t out_count = (duration < 0.f) ? -1 : llround(double(duration) * out_sr);
+    return readSamples(out_start, out_count, out_sr, resampler, quality);
+}
+
+Signal SignalReader::readSamples(int64_t out_start, int64_t out_count, int sr, StreamResampler* resampler,
+                                 ResampleQuality quality) {
+    const int out_sr = (sr > 0) ? sr : src_sr_;
+    const double ratio = double(out_sr) / double(src_sr_);
+
+    const int64_t total_out = (out_sr == src_sr_) ? frames_ : int64_t(std::floor(double(frames_) * ratio));
+    out_start = std::min<int64_t>(total_out, std::max<int64_t>(0, out_start));
+    if (out_count < 0) out_count = total_out - out_start;   // to the end
+    out_count = std::min<int64_t>(out_count, total_out - out_start);
+    if (out_count <= 0) return {{}, out_sr};
+
+    if (out_sr == src_sr_) {
+        std::vector<float> out(static_cast<size_t>(out_count));
+        out.resize(readFrames(out_start, out.data(), out.size()));
+        return { std::move(out), out_sr };
+    }
+
+    StreamResampler::SourceFn source = [this](int64_t pos, float* buf, size_t n) {
+        return readFrames(pos, buf, n);
+    };
+    if (resampler) {
+        return { resampler->read(out_start, size_t(out_count), src_sr_, out_sr, source), out_sr };
+    }
+    StreamResampler once(quality);
+    return { once.read(out_start, size_t(out_count), src_sr_, out_sr, source), out_sr };
+}
+
+SignalReader::Stats SignalReader::stats() const {
+    std::lock_guard<std::mutex> lk(mtx_);
+    Stats s = stats_;
+    s.cached_blocks = blocks_.size();
+    return s;
+}
+
+}
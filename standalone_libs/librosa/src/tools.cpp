@@ -1,6 +1,9 @@
 #include "tools.h"
 #include "define.h"
 #include "internal_tools.h"
+#include "db_kernel.h"
+
+#include <algorithm>
 
 namespace raiden {
 
@@ -100,7 +103,7 @@ SpectrogramTile tools::loadMelSpec(const std::vector<float> &data, const int &sr
 
 SpectrogramTileOverlap tools::loadStftOverlap(const std::vector<float>& data,
                                               const int& sr,
-                                              int n_fft, int n_hop) {
+                                              int n_fft, int n_hop, bool build_tile) {
     // ---- Parameters (debug-tunable) ----
     const float segment_sec   = 0.5f;   // seconds
     const float overlap_ratio = 0.5f;   // 50%
@@ -150,6 +153,7 @@ SpectrogramTileOverlap tools::loadStftOverlap(const std::vector<float>& data,
     // ---- Chunk loop ----
     std::vector<Matrixf> chunks;
     chunks.reserve(std::max(1, total_samples / std::max(1, hop_samples)));
+    int fft_total = 0;
 
     for (int start = 0; start + effective_segment_samples <= total_samples; start += hop_samples) {
         const int end = start + effective_segment_samples;
@@ -167,22 +171,9 @@ SpectrogramTileOverlap tools::loadStftOverlap(const std::vector<float>& data,
         }
 
         // dB pipeline with clamping to avoid NaNs
-        stftMagnitude = internal_tools::power_to_db(stftMagnitude);    // may yield -inf
-        // Clamp dB floor e.g. [-80, 0]
-        const float DB_FLOOR = -80.0f;
-        for (int r = 0; r < stftMagnitude.rows(); ++r)
-            for (int c = 0; c < stftMagnitude.cols(); ++c)
-                stftMagnitude(r, c) = std::max(DB_FLOOR, stftMagnitude(r, c));
-
-        stftMagnitude = internal_tools::db_to_unit(stftMagnitude);
-
-        // Replace NaN/Inf with 0
-        for (int r = 0; r < stftMagnitude.rows(); ++r) {
-            for (int c = 0; c < stftMagnitude.cols(); ++c) {
-                float v = stftMagnitude(r, c);
-                if (!(v == v) || !std::isfinite(v)) stftMagnitude(r, c) = 0.0f;
-            }
-        }
+        fft_total += (int)stftMagnitude.cols();
+        // power -> dB -> [-80, 0] clamp -> [0, 1] in one pass, NaN/Inf land on the floor
+        db_kernel::power_to_db(stftMagnitude.data(), (size_t)stftMagnitude.size());
 
         // Record
         if (!chunks.empty() && chunks.back().rows() != stftMagnitude.rows()) {
@@ -214,11 +205,14 @@ SpectrogramTileOverlap tools::loadStftOverlap(const std::vector<float>& data,
         for (int c = 0; c < width; ++c)
             normalizedData.push_back(magnitudes(r, c));
 
-    // ---- Build tile (guard tile shape) ----
-    Spectrogram tile_spec = internal_tools::buildTile(magnitudes);
-    if ((int)tile_spec.data.size() != tile_spec.width * tile_spec.height) {
-        //g_error("buildTile returned invalid buffer: w=%d h=%d size=%zu", tile_spec.width, tile_spec.height, tile_spec.data.size());
-        return {};
+    // ---- Build tile only on request (guard tile shape); the view samples the native matrix ----
+    Spectrogram tile_spec = { 0, 0, {} };
+    if (build_tile) {
+        tile_spec = internal_tools::buildTile(magnitudes);
+        if ((int)tile_spec.data.size() != tile_spec.width * tile_spec.height) {
+            //g_error("buildTile returned invalid buffer: w=%d h=%d size=%zu", tile_spec.width, tile_spec.height, tile_spec.data.size());
+            return {};
+        }
     }
 
     Spectrogram spec = { width, height, normalizedData };
@@ -229,7 +223,8 @@ SpectrogramTileOverlap tools::loadStftOverlap(const std::vector<float>& data,
         tile_spec.height,
         hop_frames,
         (int)chunks[0].cols(),   // frames_per_chunk (not assumed—read actual)
-        tile_spec.data
+        tile_spec.data,
+        fft_total
     };
 
     //g_message("[STFT] OUT: spec=%dx%d  tile=%dx%d  hopFrames=%d  framesPerChunk=%d", spec.width, spec.height, tile_spec.width, tile_spec.height, hop_frames, (int)chunks[0].cols());
@@ -241,7 +236,8 @@ SpectrogramTileOverlap tools::loadMelOverlap(const std::vector<float>& data,
                                              const int& sr,
                                              int n_fft, int n_hop,
                                              int n_mels, float fmin, float fmax,
-                                             float segment_sec, float overlap_ratio, bool to_unit)
+                                             float segment_sec, float overlap_ratio, bool to_unit, bool build_tile,
+                                             float ref_power)
 {
     // ---------- Basic guards ----------
     if (sr <= 0 || n_fft <= 0 || n_hop <= 0 || n_mels <= 0 || segment_sec <= 0.0f) {
@@ -323,6 +319,7 @@ SpectrogramTileOverlap tools::loadMelOverlap(const std::vector<float>& data,
 
     int locked_bins = -1;
     int locked_frames = -1;
+    int fft_total = 0;
 
     for (const auto& se : spans) {
         const int start = se.first;
@@ -337,6 +334,7 @@ SpectrogramTileOverlap tools::loadMelOverlap(const std::vector<float>& data,
             //g_error("STFT bins mismatch: got rows=%d expected=%d", (int)S.rows(), stft_bins_expected);
             return {};
         }
+        fft_total += (int)S.cols();
         if (locked_frames < 0) locked_frames = (int)S.cols();
         if ((int)S.cols() != locked_frames) {
             //g_warning("Chunk frame mismatch: cols=%d expected=%d (start=%d end=%d)",
@@ -344,18 +342,14 @@ SpectrogramTileOverlap tools::loadMelOverlap(const std::vector<float>& data,
         }
 
         Matrixf M = mel_filterbank * S;
-        M = internal_tools::power_to_db(M);
-
-        const float DB_FLOOR = -80.0f;
-        for (int r = 0; r < M.rows(); ++r)
-            for (int c = 0; c < M.cols(); ++c) {
-                float v = M(r, c);
-                if (!std::isfinite(v)) v = DB_FLOOR;
-                M(r, c) = std::max(DB_FLOOR, v);
-            }
-        if (to_unit) {
-            M = internal_tools::db_to_unit(M);
+        DbParams db;
+        db.to_unit = to_unit;
+        if (ref_power > 0.0f) {
+            db.ref_is_max = false;
+            db.ref_value = ref_power;
+            db.top_db = -1.0f;
         }
+        db_kernel::power_to_db(M.data(), (size_t)M.size(), db);
 
         if (locked_bins < 0) locked_bins = (int)M.rows();
         if ((int)M.rows() != locked_bins) {
@@ -393,12 +387,15 @@ SpectrogramTileOverlap tools::loadMelOverlap(const std::vector<float>& data,
         for (int c = 0; c < width; ++c)
             normalizedData.push_back(magnitudes(r, c));
 
-    // ---------- Build tile ----------
-    Spectrogram tile_spec = internal_tools::buildTile(magnitudes);
-    if ((int)tile_spec.data.size() != tile_spec.width * tile_spec.height) {
-        //g_error("buildTile invalid buffer: w=%d h=%d size=%zu",
-        //        tile_spec.width, tile_spec.height, tile_spec.data.size());
-        return {};
+    // ---------- Build tile (only on request) ----------
+    Spectrogram tile_spec = { 0, 0, {} };
+    if (build_tile) {
+        tile_spec = internal_tools::buildTile(magnitudes);
+        if ((int)tile_spec.data.size() != tile_spec.width * tile_spec.height) {
+            //g_error("buildTile invalid buffer: w=%d h=%d size=%zu",
+            //        tile_spec.width, tile_spec.height, tile_spec.data.size());
+            return {};
+        }
     }
 
     Spectrogram spec = { width, height, normalizedData };
@@ -414,9 +411,145 @@ SpectrogramTileOverlap tools::loadMelOverlap(const std::vector<float>& data,
         tile_spec.height,
         hop_frames,
         frames_per_chunk_actual,
-        tile_spec.data
+        tile_spec.data,
+        fft_total
+    };
+    return tile;
+}
+
+SpectrogramTileOverlap tools::loadMelDirect(const std::vector<float>& data,
+                                            const int& sr,
+                                            int n_fft, int n_hop,
+                                            int n_mels, float fmin, float fmax,
+                                            bool to_unit, bool build_tile, float ref_power)
+{
+    // ---------- Basic guards ----------
+    if (sr <= 0 || n_fft <= 0 || n_hop <= 0 || n_mels <= 0) {
+        return {};
+    }
+    if (fmin < 0.0f) fmin = 0.0f;
+    const float nyquist = 0.5f * sr;
+    if (fmax <= 0.0f || fmax > nyquist) fmax = nyquist;
+
+    // reflect padding mirrors n_fft/2 samples about each edge sample, so it needs n_fft/2 + 1;
+    // the padded signal is then always at least one frame long
+    const int total_samples = static_cast<int>(data.size());
+    if (total_samples <= n_fft / 2) {
+        return {};
+    }
+
+    // ---------- Mel filterbank ----------
+    Matrixf mel_filterbank = internal_tools::create_mel_filterbank(sr, n_fft, n_mels, fmin, fmax, /*htk=*/false);
+    const int stft_bins_expected = n_fft / 2 + 1;
+    if (mel_filterbank.rows() != n_mels || mel_filterbank.cols() != stft_bins_expected) {
+        return {};
+    }
+
+    // ---------- One STFT for the whole window ----------
+    // center=true pads n_fft/2 on both window edges only, so frame i is centred on sample i*n_hop:
+    // frames = 1 + total_samples / n_hop, same hop grid as SpecViewPort::frame_start (s / n_hop).
+    Matrixf S = internal_tools::stftMagnitude(data, n_fft, n_hop, "hann", /*center=*/true, "reflect");
+    if (S.rows() != stft_bins_expected || S.cols() <= 0) {
+        return {};
+    }
+    const int fft_total = static_cast<int>(S.cols());
+
+    Matrixf M = mel_filterbank * S;
+    DbParams db;
+    db.to_unit = to_unit;
+    if (ref_power > 0.0f) {
+        db.ref_is_max = false;
+        db.ref_value = ref_power;
+        db.top_db = -1.0f;
+    }
+    db_kernel::power_to_db(M.data(), (size_t)M.size(), db);
+
+    // ---------- Flatten ----------
+    const int height = (int)M.rows();
+    const int width  = (int)M.cols();
+    std::vector<float> normalizedData(M.data(), M.data() + M.size()); // Matrixf is row-major
+
+    // ---------- Build tile (only on request) ----------
+    Spectrogram tile_spec = { 0, 0, {} };
+    if (build_tile) {
+        tile_spec = internal_tools::buildTile(M);
+        if ((int)tile_spec.data.size() != tile_spec.width * tile_spec.height) {
+            return {};
+        }
+    }
+
+    // the whole window is a single "chunk": hop_frames == framesPerChunk == width
+    SpectrogramTileOverlap tile = {
+        Spectrogram{width, height, normalizedData},
+        tile_spec.width,
+        tile_spec.height,
+        width,
+        width,
+        tile_spec.data,
+        fft_total
     };
     return tile;
 }
 
+Spectrogram tools::loadMelFrames(const std::vector<float>& data, const int& sr, int n_fft, int n_hop, int n_mels,
+                                 int skip, int count, float ref_power, float fmin, float fmax)
+{
+    Spectrogram out = { 0, 0, {} };
+    if (sr <= 0 || n_fft <= 0 || n_hop <= 0 || n_mels <= 0 || skip < 0 || count <= 0) return out;
+    if (static_cast<int>(data.size()) < n_fft) return out;
+    if (fmin < 0.0f) fmin = 0.0f;
+    const float nyquist = 0.5f * sr;
+    if (fmax <= 0.0f || fmax > nyquist) fmax = nyquist;
+
+    Matrixf mel_filterbank = internal_tools::create_mel_filterbank(sr, n_fft, n_mels, fmin, fmax, /*htk=*/false);
+    Matrixf S = internal_tools::stftMagnitude(data, n_fft, n_hop, "hann", /*center=*/true, "reflect");
+    if (S.rows() != mel_filterbank.cols() || S.cols() <= skip) return out;
+
+    const int width = std::min<int>(count, static_cast<int>(S.cols()) - skip);
+    Matrixf M = mel_filterbank * S.middleCols(skip, width);
+
+    DbParams db;
+    db.to_unit = false;
+    db.top_db = -1.0f;   // a fixed reference already bounds the range; the floor does the rest
+    db.ref_is_max = false;
+    db.ref_value = ref_power > 0.0f ? ref_power : melReferencePower();
+    db_kernel::power_to_db(M.data(), (size_t)M.size(), db);
+
+    out.width = width;
+    out.height = static_cast<int>(M.rows());
+    out.data.assign(M.data(), M.data() + M.size());
+    return out;
+}
+
+float tools::melReferencePower(float peak) {
+    // stft() normalises the window to sum 1, so a sine of amplitude A puts A / 2 in its bin; a filter
+    // weighs its centre bin by up to 1
+    const float mag = 0.5f * peak;
+    return std::max(mag * mag, 1e-10f);
+}
+
+int tools::countOverlapFft(int total_samples, const int& sr, int n_hop, float segment_sec, float overlap_ratio) {
+    // mirrors the span / frame math of loadMelOverlap
+    if (sr <= 0 || n_hop <= 0 || segment_sec <= 0.0f) return 0;
+    if (overlap_ratio < 0.0f) overlap_ratio = 0.0f;
+    if (overlap_ratio >= 1.0f) overlap_ratio = 0.99f;
+
+    const int segment_samples = static_cast<int>(std::floor(sr * segment_sec));
+    if (segment_samples <= 0 || segment_samples > total_samples) return 0;
+
+    int hop_samples = (int)std::round(segment_samples * (1.0f - overlap_ratio));
+    if (hop_samples <= 0) hop_samples = 1;
+
+    int spans = 0;
+    int last = -1;
+    for (int start = 0; start + segment_samples <= total_samples; start += hop_samples) {
+        last = start;
+        ++spans;
+    }
+    if (spans == 0 || last < total_samples - segment_samples) ++spans; // snapped tail
+
+    const int frames_per_chunk = 1 + segment_samples / n_hop;
+    return spans * frames_per_chunk;
+}
+
 }
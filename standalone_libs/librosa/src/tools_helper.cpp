@@ -6,6 +6,8 @@
 #include <opencv2/highgui.hpp>
 #include <opencv2/imgproc.hpp>
 
+#include <cstring>
+
 namespace raiden {
 
 SpectrogramByte tools::flatMatrixToByteImg(const std::vector<float>& flat, int height, int width, const std::string &file_name, bool is_db) {
@@ -78,4 +80,92 @@ std::vector<float> tools::extractSpectrogramSlice(const std::vector<float> &full
     return slice_flat;
 }
 
+uint16_t tools::floatToHalf(float f) {
+    uint32_t x;
+    std::memcpy(&x, &f, sizeof(x));
+    const uint32_t sign = (x >> 16) & 0x8000u;
+    const uint32_t absx = x & 0x7fffffffu;
+
+    if (absx >= 0x7f800000u)                 // inf / NaN
+        return uint16_t(sign | 0x7c00u | (absx > 0x7f800000u ? 0x200u : 0u));
+    if (absx >= 0x477ff000u)                 // rounds past 65504 -> inf
+        return uint16_t(sign | 0x7c00u);
+    if (absx < 0x38800000u) {                // half subnormal / zero
+        if (absx < 0x33000000u) return uint16_t(sign);
+        const uint32_t mant = (absx & 0x007fffffu) | 0x00800000u;
+        const int shift = 126 - int(absx >> 23);   // 14..24
+        uint32_t h = mant >> shift;
+        const uint32_t rem = mant & ((1u << shift) - 1u);
+        const uint32_t half = 1u << (shift - 1);
+        if (rem > half || (rem == half && (h & 1u))) ++h;
+        return uint16_t(sign | h);
+    }
+    // normal: rebias exponent, round mantissa to nearest even
+    uint32_t h = ((absx - 0x38000000u) >> 13);
+    const uint32_t rem = absx & 0x1fffu;
+    if (rem > 0x1000u || (rem == 0x1000u && (h & 1u))) ++h;
+    return uint16_t(sign | h);
+}
+
+float tools::halfToFloat(uint16_t h) {
+    const uint32_t sign = uint32_t(h & 0x8000u) << 16;
+    uint32_t exp  = (h >> 10) & 0x1fu;
+    uint32_t mant = h & 0x3ffu;
+    uint32_t x;
+    if (exp == 0x1fu) {
+        x = sign | 0x7f800000u | (mant << 13);
+    } else if (exp == 0) {
+        if (mant == 0) {
+            x = sign;
+        } else {
+            exp = 113;
+            while (!(mant & 0x400u)) { mant <<= 1; --exp; }
+            x = sign | (exp << 23) | ((mant & 0x3ffu) << 13);
+        }
+    } else {
+        x = sign | ((exp + 112u) << 23) | (mant << 13);
+    }
+    float f;
+    std::memcpy(&f, &x, sizeof(f));
+    return f;
+}
+
+SpectrogramQ tools::quantizeSpectrogram(const std::vector<float> &db, int width, int height,
+                                        SpecSampleFormat format, float min_db, float max_db) {
+    SpectrogramQ q;
+    if (width <= 0 || height <= 0 || (int)db.size() < width * height) return q;
+
+    q.width = width;
+    q.height = height;
+    q.format = format;
+    const size_t n = size_t(width) * size_t(height);
+
+    if (format == SpecSampleFormat::F16) {
+        // half keeps <= 0.0625 dB steps over [-80, 0]; stored as dB, no remap
+        q.scale = 1.0f;
+        q.offset = 0.0f;
+        q.data.resize(n * 2);
+        uint16_t* dst = reinterpret_cast<uint16_t*>(q.data.data());
+        for (size_t i = 0; i < n; ++i) {
+            float v = db[i];
+            if (!(v == v)) v = min_db;
+            dst[i] = floatToHalf(v);
+        }
+        return q;
+    }
+
+    if (max_db <= min_db) max_db = min_db + 1.0f;
+    q.scale = max_db - min_db;
+    q.offset = min_db;
+    q.data.resize(n);
+    const float k = 255.0f / q.scale;
+    for (size_t i = 0; i < n; ++i) {
+        float v = db[i];
+        if (!(v == v)) v = min_db;
+        v = std::min(std::max(v, min_db), max_db);
+        q.data[i] = uint8_t((v - min_db) * k + 0.5f);
+    }
+    return q;
+}
+
 }
@@ -1,4 +1,5 @@
 #include "librosa.h"
+#include "envelope_kernel.h"
 #include <cmath>
 #include <algorithm>
 
@@ -78,53 +79,70 @@ float audio::to_ndc(float t, double view_start_sec, double view_span_sec) {
 }
 
 SignalAdaptGl audio::project_visible_adapt_wave(const std::vector<float> &audio_wave, int pixel_w, const float& global_peak) {
-    std::vector<float> adapt_audio_wave;
-    int gl_draw_count = 0;
+    SignalAdaptGl out;
+    out.gl_draw_count = 0;
+    if (audio_wave.empty() || pixel_w <= 0) { return out; }
+
+    // sized once, filled in place
+    out.adapt_audio_wave.resize(envelope_kernel::vertex_floats(audio_wave.size(), pixel_w));
+    out.gl_draw_count = project_visible_adapt_wave_into(audio_wave.data(), audio_wave.size(), pixel_w, global_peak,
+                                                        out.adapt_audio_wave.data());
+    return out;
+}
+
+int audio::project_visible_adapt_wave_into(const float* audio_wave, size_t n, int pixel_w, const float& global_peak, float* out) {
+    const float gain = (global_peak > 0.f) ? (1.0f / global_peak) : 1.0f;
+    return envelope_kernel::write_vertices(audio_wave, n, pixel_w, gain, out);
+}
+
+SignalAdaptGl audio::project_visible_adapt_wave(const PeakIndex& index, double view_start_sec, double view_span_sec,
+                                                int pixel_w, const float& global_peak) {
+    const int sr = index.sampleRate();
+    if (pixel_w <= 0 || sr <= 0 || view_span_sec <= 0.0) return {{}, 0};
 
-    adapt_audio_wave.clear();
-    if (audio_wave.empty() || pixel_w <= 0) { return {{}, gl_draw_count}; }
+    const int64_t s0 = std::max<int64_t>(0, int64_t(std::llround(view_start_sec * sr)));
+    const int64_t s1 = std::min<int64_t>(index.totalSamples(), int64_t(std::llround((view_start_sec + view_span_sec) * sr)));
+    if (s1 <= s0) return {{}, 0};
 
-    const int N = (int)audio_wave.size();
+    std::vector<float> mn(static_cast<size_t>(pixel_w)), mx(static_cast<size_t>(pixel_w));
+    if (!index.project(s0, s1, pixel_w, mn.data(), mx.data())) return {{}, 0};
+
+    // same layout as the sample envelope: (x, vmin), (x, vmax) per pixel for GL_LINES
     const float gain = (global_peak > 0.f) ? (1.0f / global_peak) : 1.0f;
+    std::vector<float> adapt_audio_wave;
+    adapt_audio_wave.reserve(size_t(pixel_w) * 4);
+    for (int px = 0; px < pixel_w; ++px) {
+        const float vmin = std::max(-1.f, std::min(1.f, mn[size_t(px)] * gain));
+        const float vmax = std::max(-1.f, std::min(1.f, mx[size_t(px)] * gain));
+        const float x_ndc = (pixel_w == 1) ? 0.f : ((float)px / (float)(pixel_w - 1) * 2.f - 1.f);
+        adapt_audio_wave.push_back(x_ndc); adapt_audio_wave.push_back(vmin);
+        adapt_audio_wave.push_back(x_ndc); adapt_audio_wave.push_back(vmax);
+    }
+    const int gl_draw_count = (int)adapt_audio_wave.size() / 2;
+    return { adapt_audio_wave, gl_draw_count };
+}
+
+std::vector<float> audio::project_feature_band(const std::vector<float> &column, int hop, int sr,
+                                               double view_start_sec, double view_span_sec, const float& global_peak) {
+    std::vector<float> band;
+    if (column.empty() || hop <= 0 || sr <= 0 || view_span_sec <= 0.0) return band;
 
-    if (N <= pixel_w) {
-        // High-resolution mode: one vertex per sample (LINE_STRIP)
-        adapt_audio_wave.reserve(N * 2);
-        for (int i = 0; i < N; ++i) {
-            float t = (N > 1) ? (float)i / (float)(N - 1) : 0.f;
-            float x_ndc = t * 2.f - 1.f;
-            float y = std::max(-1.f, std::min(1.f, audio_wave[i] * gain));
-            adapt_audio_wave.push_back(x_ndc); adapt_audio_wave.push_back(y);
-        }
-        gl_draw_count = N; // vertices (pairs)
-        // render path will use LINE_STRIP
-        return { adapt_audio_wave, gl_draw_count };
-    } else {
-        // Envelope mode: per-pixel min/max (LINES)
-        const int spp = std::max(1, N / pixel_w);
-        adapt_audio_wave.reserve(pixel_w * 4);
-        for (int px = 0; px < pixel_w; ++px) {
-            int s0 = px * spp;
-            int s1 = (px == pixel_w - 1) ? N : std::min(N, s0 + spp);
-            if (s0 >= N) break;
-
-            float vmin =  1e9f, vmax = -1e9f;
-            for (int j = s0; j < s1; ++j) {
-                float v = audio_wave[j] * gain;
-                if (v < vmin) vmin = v;
-                if (v > vmax) vmax = v;
-            }
-            vmin = std::max(-1.f, std::min(1.f, vmin));
-            vmax = std::max(-1.f, std::min(1.f, vmax));
-
-            float x_ndc = (pixel_w == 1) ? 0.f : ((float)px / (float)(pixel_w - 1) * 2.f - 1.f);
-            // two points: (x, vmin) and (x, vmax)
-            adapt_audio_wave.push_back(x_ndc); adapt_audio_wave.push_back(vmin);
-            adapt_audio_wave.push_back(x_ndc); adapt_audio_wave.push_back(vmax);
-        }
-        gl_draw_count = (int)adapt_audio_wave.size() / 2;
-        return { adapt_audio_wave, gl_draw_count };
+    const double frame_sec = double(hop) / double(sr);
+    const float gain = (global_peak > 0.f) ? (1.0f / global_peak) : 1.0f;
+    const long first = std::max(0L, long(std::floor(view_start_sec / frame_sec)));
+    const long last  = std::min(long(column.size()) - 1, long(std::ceil((view_start_sec + view_span_sec) / frame_sec)));
+    if (last < first) return band;
+
+    band.reserve(size_t(last - first + 1) * 4);
+    for (long i = first; i <= last; ++i) {
+        // frame centre, clamped to the view edges
+        const double t = (double(i) + 0.5) * frame_sec;
+        const float x = std::max(-1.f, std::min(1.f, to_ndc(float(t), view_start_sec, view_span_sec)));
+        const float y = std::min(1.f, column[size_t(i)] * gain);
+        band.push_back(x); band.push_back( y);
+        band.push_back(x); band.push_back(-y);
     }
+    return band;
 }
 
 }
@@ -0,0 +1,149 @@
+// db_kernel against the Eigen chain it replaced in the spectrogram paths:
+// internal_tools::power_to_db, the -80 dB floor (non finite -> floor) and db_to_unit,
+// on every ISA this build and CPU can run.
+
+#include "db_kernel.h"
+#include "internal_tools.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+using raiden::DbParams;
+using raiden::db_kernel;
+using raiden::internal_tools;
+
+namespace {
+
+// documented bounds of fast_log10 (db_kernel.h), and what the inner one is worth in dB
+const double kLog10Bound = 4e-6;        // x in [1e-32, 1e32]
+const double kLog10BoundNormal = 4.5e-6;
+const double kDbBound = 4e-5;
+const float kFloorDb = -80.0f;
+
+// power spectrum like values: 1e-14 .. 1e2, some exact zeros (amin), any length
+std::vector<float> makePower(size_t n, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> exponent(-14.0f, 2.0f);
+    std::vector<float> out(n);
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = (rng() % 61 == 0) ? 0.0f : std::pow(10.0f, exponent(rng));
+    }
+    return out;
+}
+
+std::vector<float> eigenChain(const std::vector<float>& power, const DbParams& p) {
+    Eigen::MatrixXf m = Eigen::Map<const Eigen::MatrixXf>(power.data(), 1, Eigen::Index(power.size()));
+    m = internal_tools::power_to_db(m, p.ref_is_max, p.ref_value, p.amin, p.top_db);
+    for (Eigen::Index i = 0; i < m.size(); ++i) {
+        float& v = m.data()[i];
+        if (!std::isfinite(v)) v = p.floor_db;
+        v = std::max(p.floor_db, v);
+    }
+    if (p.to_unit) m = internal_tools::db_to_unit(m, p.min_db, p.max_db);
+    return std::vector<float>(m.data(), m.data() + m.size());
+}
+
+std::vector<float> kernel(std::vector<float> data, const DbParams& p) {
+    db_kernel::power_to_db(data.data(), data.size(), p);
+    return data;
+}
+
+double maxAbsDiff(const std::vector<float>& a, const std::vector<float>& b) {
+    double worst = 0.0;
+    for (size_t i = 0; i < a.size(); ++i) worst = std::max(worst, std::fabs(double(a[i]) - double(b[i])));
+    return worst;
+}
+
+class DbKernelIsa : public ::testing::TestWithParam<db_kernel::Isa> {
+protected:
+    void SetUp() override {
+        saved = db_kernel::active_isa();
+        ASSERT_TRUE(db_kernel::set_isa(GetParam()));
+    }
+    void TearDown() override { db_kernel::set_isa(saved); }
+
+    db_kernel::Isa saved = db_kernel::Isa::Scalar;
+};
+
+std::string isaName(const ::testing::TestParamInfo<db_kernel::Isa>& info) {
+    return db_kernel::isa_name(info.param);
+}
+
+}
+
+TEST(DbKernel, FastLog10Bound) {
+    // every exponent of the normal range, a spread of mantissas in each
+    std::mt19937 rng(1);
+    double worst = 0.0, worst_inner = 0.0;
+    for (int e = -126; e <= 127; ++e) {
+        for (int k = 0; k < 512; ++k) {
+            const uint32_t bits = uint32_t(e + 127) << 23 | (k == 0 ? 0u : (rng() & 0x7fffffu));
+            float x;
+            std::memcpy(&x, &bits, sizeof(x));
+            const double err = std::fabs(double(db_kernel::fast_log10(x)) - std::log10(double(x)));
+            worst = std::max(worst, err);
+            if (x >= 1e-32f && x <= 1e32f) worst_inner = std::max(worst_inner, err);
+        }
+    }
+    EXPECT_LT(worst_inner, kLog10Bound);
+    EXPECT_LT(worst, kLog10BoundNormal);
+}
+
+TEST_P(DbKernelIsa, MatchesEigenChainInDb) {
+    DbParams p;
+    p.to_unit = false;
+    // odd sizes leave a scalar tail behind every vector width
+    for (size_t n : { size_t(1), size_t(7), size_t(33), size_t(4099) }) {
+        const std::vector<float> power = makePower(n, uint32_t(n));
+        EXPECT_LT(maxAbsDiff(kernel(power, p), eigenChain(power, p)), kDbBound) << "n=" << n;
+    }
+}
+
+TEST_P(DbKernelIsa, MatchesEigenChainInUnitRange) {
+    DbParams p;
+    const std::vector<float> power = makePower(4099, 11);
+    const double bound = kDbBound / double(p.max_db - p.min_db) + 1e-7;
+    EXPECT_LT(maxAbsDiff(kernel(power, p), eigenChain(power, p)), bound);
+}
+
+TEST_P(DbKernelIsa, MatchesEigenChainWithFixedReference) {
+    // the spectrogram ring / file level reference: fixed ref, no top_db, floor only
+    DbParams p;
+    p.to_unit = false;
+    p.ref_is_max = false;
+    p.ref_value = 0.25f;
+    p.top_db = -1.0f;
+    const std::vector<float> power = makePower(4099, 23);
+    EXPECT_LT(maxAbsDiff(kernel(power, p), eigenChain(power, p)), kDbBound);
+}
+
+TEST_P(DbKernelIsa, ReduceMaxSkipsNaN) {
+    std::vector<float> power = makePower(1027, 5);
+    for (size_t i = 0; i < power.size(); i += 13) power[i] = std::numeric_limits<float>::quiet_NaN();
+    float want = 1e-10f;
+    for (float v : power) {
+        if (v > want) want = v;
+    }
+    EXPECT_EQ(db_kernel::reduce_max(power.data(), power.size(), 1e-10f), want);
+}
+
+TEST_P(DbKernelIsa, NonFiniteInputLandsOnTheFloor) {
+    DbParams p;
+    p.to_unit = false;
+    std::vector<float> power = makePower(64, 9);
+    power[3] = std::numeric_limits<float>::quiet_NaN();
+    power[17] = -std::numeric_limits<float>::infinity();
+    power[40] = -1.0f;
+    const std::vector<float> out = kernel(power, p);
+    for (size_t i : { size_t(3), size_t(17), size_t(40) }) EXPECT_EQ(out[i], kFloorDb) << "i=" << i;
+    for (float v : out) EXPECT_TRUE(std::isfinite(v));
+}
+
+INSTANTIATE_TEST_SUITE_P(AllIsas, DbKernelIsa, ::testing::ValuesIn(db_kernel::available_isas()), isaName);
@@ -0,0 +1,185 @@
+// The spectrogram texture formats: tools::floatToHalf / halfToFloat (F16 samples) and
+// tools::quantizeSpectrogram (U8 over [min_db, max_db], F16 as dB), which every
+// spectrogram path runs before the upload.
+
+#include "tools.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+using raiden::tools;
+
+namespace {
+
+const float kInf = std::numeric_limits<float>::infinity();
+const float kNaN = std::numeric_limits<float>::quiet_NaN();
+
+uint16_t halfAt(const SpectrogramQ& q, size_t i) {
+    uint16_t h;
+    std::memcpy(&h, q.data.data() + i * 2, sizeof(h));
+    return h;
+}
+
+bool isHalfNaN(uint16_t h) { return (h & 0x7c00u) == 0x7c00u && (h & 0x3ffu) != 0; }
+
+}
+
+TEST(HalfFloat, EveryHalfRoundTrips) {
+    for (uint32_t h = 0; h <= 0xffffu; ++h) {
+        const float f = tools::halfToFloat(uint16_t(h));
+        if (isHalfNaN(uint16_t(h))) {
+            EXPECT_TRUE(std::isnan(f)) << std::hex << h;
+            EXPECT_TRUE(isHalfNaN(tools::floatToHalf(f))) << std::hex << h;
+        } else {
+            EXPECT_EQ(tools::floatToHalf(f), uint16_t(h)) << std::hex << h;
+        }
+    }
+}
+
+TEST(HalfFloat, SpecialValues) {
+    EXPECT_EQ(tools::floatToHalf(0.0f), 0x0000);
+    EXPECT_EQ(tools::floatToHalf(-0.0f), 0x8000);
+    EXPECT_EQ(tools::floatToHalf(1.0f), 0x3c00);
+    EXPECT_EQ(tools::floatToHalf(-80.0f), 0xd500);
+    EXPECT_EQ(tools::floatToHalf(kInf), 0x7c00);
+    EXPECT_EQ(tools::floatToHalf(-kInf), 0xfc00);
+    EXPECT_TRUE(isHalfNaN(tools::floatToHalf(kNaN)));
+    EXPECT_TRUE(isHalfNaN(tools::floatToHalf(-kNaN)));
+
+    EXPECT_EQ(tools::halfToFloat(0x7c00), kInf);
+    EXPECT_EQ(tools::halfToFloat(0xfc00), -kInf);
+    EXPECT_TRUE(std::signbit(tools::halfToFloat(0x8000)));
+}
+
+TEST(HalfFloat, OverflowAndSubnormals) {
+    // largest half, and the rounding boundary to inf half an ulp (16) above it
+    EXPECT_EQ(tools::floatToHalf(65504.0f), 0x7bff);
+    EXPECT_EQ(tools::floatToHalf(65519.0f), 0x7bff);
+    EXPECT_EQ(tools::floatToHalf(65520.0f), 0x7c00);
+    EXPECT_EQ(tools::floatToHalf(-1e6f), 0xfc00);
+
+    // smallest normal, largest and smallest subnormal
+    EXPECT_EQ(tools::floatToHalf(std::ldexp(1.0f, -14)), 0x0400);
+    EXPECT_EQ(tools::floatToHalf(std::ldexp(1023.0f, -24)), 0x03ff);
+    EXPECT_EQ(tools::floatToHalf(std::ldexp(1.0f, -24)), 0x0001);
+    EXPECT_EQ(tools::floatToHalf(-std::ldexp(1.0f, -24)), 0x8001);
+    // ties go to even, below half the smallest subnormal flushes to (signed) zero
+    EXPECT_EQ(tools::floatToHalf(std::ldexp(1.0f, -25)), 0x0000);
+    EXPECT_EQ(tools::floatToHalf(std::ldexp(3.0f, -26)), 0x0001);
+    EXPECT_EQ(tools::floatToHalf(std::ldexp(3.0f, -25)), 0x0002);
+    EXPECT_EQ(tools::floatToHalf(std::ldexp(1.0f, -30)), 0x0000);
+    EXPECT_EQ(tools::floatToHalf(-std::ldexp(1.0f, -30)), 0x8000);
+    EXPECT_EQ(tools::floatToHalf(std::numeric_limits<float>::denorm_min()), 0x0000);
+    // normal ties: 1 + 2^-11 sits between 0x3c00 and 0x3c01
+    EXPECT_EQ(tools::floatToHalf(1.0f + std::ldexp(1.0f, -11)), 0x3c00);
+    EXPECT_EQ(tools::floatToHalf(1.0f + std::ldexp(3.0f, -11)), 0x3c02);
+}
+
+TEST(HalfFloat, RoundsToNearest) {
+    // no neighbouring half is closer to f than the one it converts to
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> exponent(-26.0f, 16.0f);
+    for (int i = 0; i < 200000; ++i) {
+        const float f = ((rng() & 1u) ? -1.0f : 1.0f) * std::pow(2.0f, exponent(rng));
+        const uint16_t h = tools::floatToHalf(f);
+        if ((h & 0x7c00u) == 0x7c00u) continue;   // overflow, covered above
+        const double err = std::fabs(double(tools::halfToFloat(h)) - double(f));
+        const uint16_t mag = h & 0x7fffu;
+        if (mag > 0) {
+            EXPECT_LE(err, std::fabs(double(tools::halfToFloat(uint16_t(h - 1))) - double(f))) << f;
+        }
+        if (mag < 0x7bffu) {
+            EXPECT_LE(err, std::fabs(double(tools::halfToFloat(uint16_t(h + 1))) - double(f))) << f;
+        }
+    }
+}
+
+TEST(QuantizeSpectrogram, U8SaturatesAtTheRangeEnds) {
+    const std::vector<float> db = { -200.0f, -80.0f, -40.0f, 0.0f, 12.0f, -kInf, kInf, kNaN };
+    const SpectrogramQ q = tools::quantizeSpectrogram(db, int(db.size()), 1, SpecSampleFormat::U8);
+    ASSERT_EQ(q.data.size(), db.size());
+    EXPECT_EQ(q.bytesPerSample(), 1);
+    EXPECT_EQ(q.offset, -80.0f);
+    EXPECT_EQ(q.scale, 80.0f);
+    const uint8_t want[] = { 0, 0, 128, 255, 255, 0, 255, 0 };
+    for (size_t i = 0; i < db.size(); ++i) EXPECT_EQ(q.data[i], want[i]) << "i=" << i;
+
+    // what the shader undoes: offset + scale * texel / 255 stays within half a step
+    const float step = q.scale / 255.0f;
+    for (float v = -80.0f; v <= 0.0f; v += 0.37f) {
+        const SpectrogramQ one = tools::quantizeSpectrogram(std::vector<float>(1, v), 1, 1);
+        EXPECT_NEAR(one.offset + one.scale * float(one.data[0]) / 255.0f, v, 0.5f * step + 1e-5f);
+    }
+}
+
+TEST(QuantizeSpectrogram, U8CustomAndDegenerateRange) {
+    const std::vector<float> db = { -61.0f, -60.0f, -35.0f, -10.0f, -9.0f };
+    const SpectrogramQ q = tools::quantizeSpectrogram(db, 5, 1, SpecSampleFormat::U8, -60.0f, -10.0f);
+    const uint8_t want[] = { 0, 0, 128, 255, 255 };
+    for (size_t i = 0; i < db.size(); ++i) EXPECT_EQ(q.data[i], want[i]) << "i=" << i;
+
+    // max <= min: one dB wide instead of a division by zero
+    const SpectrogramQ flat = tools::quantizeSpectrogram(db, 5, 1, SpecSampleFormat::U8, -20.0f, -20.0f);
+    EXPECT_EQ(flat.scale, 1.0f);
+    EXPECT_EQ(flat.data[0], 0);
+    EXPECT_EQ(flat.data[4], 255);
+}
+
+TEST(QuantizeSpectrogram, F16KeepsDbAndMapsNaNToTheFloor) {
+    const std::vector<float> db = { -200.0f, -80.0f, -12.5f, 0.0f, 12.0f, -kInf, kInf, kNaN, 1e6f };
+    const SpectrogramQ q = tools::quantizeSpectrogram(db, int(db.size()), 1, SpecSampleFormat::F16);
+    ASSERT_EQ(q.data.size(), db.size() * 2);
+    EXPECT_EQ(q.bytesPerSample(), 2);
+    EXPECT_EQ(q.scale, 1.0f);
+    EXPECT_EQ(q.offset, 0.0f);
+    for (size_t i = 0; i < 5; ++i) EXPECT_EQ(tools::halfToFloat(halfAt(q, i)), db[i]) << "i=" << i;
+    EXPECT_EQ(tools::halfToFloat(halfAt(q, 5)), -kInf);
+    EXPECT_EQ(tools::halfToFloat(halfAt(q, 6)), kInf);
+    EXPECT_EQ(tools::halfToFloat(halfAt(q, 7)), -80.0f);
+    EXPECT_EQ(tools::halfToFloat(halfAt(q, 8)), kInf);
+
+    // within [-80, 0] the step is at most 2^-4 dB, error at most half of it
+    for (float v = -80.0f; v <= 0.0f; v += 0.013f) {
+        EXPECT_LE(std::fabs(tools::halfToFloat(tools::floatToHalf(v)) - v), 1.0f / 32.0f) << v;
+    }
+}
+
+TEST(QuantizeSpectrogram, KeepsTheColumnLayout) {
+    // mels x columns, row-major like the Matrixf the mel paths flatten: sample (mel, col) at
+    // mel * width + col, the layout glTexImage2D gets with width = columns
+    const int width = 37, height = 5;
+    std::vector<float> db(size_t(width * height));
+    for (int m = 0; m < height; ++m) {
+        for (int c = 0; c < width; ++c) db[size_t(m * width + c)] = -80.0f + 0.5f * float(c) + 8.0f * float(m);
+    }
+    for (SpecSampleFormat format : { SpecSampleFormat::U8, SpecSampleFormat::F16 }) {
+        const SpectrogramQ q = tools::quantizeSpectrogram(db, width, height, format);
+        EXPECT_EQ(q.width, width);
+        EXPECT_EQ(q.height, height);
+        EXPECT_EQ(q.format, format);
+        ASSERT_EQ(q.data.size(), db.size() * size_t(q.bytesPerSample()));
+        for (int m = 0; m < height; ++m) {
+            for (int c = 0; c < width; ++c) {
+                const size_t i = size_t(m * width + c);
+                const float back = format == SpecSampleFormat::F16
+                                       ? tools::halfToFloat(halfAt(q, i))
+                                       : q.offset + q.scale * float(q.data[i]) / 255.0f;
+                EXPECT_NEAR(back, std::min(db[i], 0.0f), 0.2f) << "mel " << m << " col " << c;
+            }
+        }
+    }
+}
+
+TEST(QuantizeSpectrogram, RejectsShortInput) {
+    const std::vector<float> db(10, -20.0f);
+    EXPECT_TRUE(tools::quantizeSpectrogram(db, 4, 3).data.empty());
+    EXPECT_TRUE(tools::quantizeSpectrogram(db, 0, 3).data.empty());
+    EXPECT_EQ(tools::quantizeSpectrogram(db, 5, 2).data.size(), size_t(10));
+}
@@ -1,5 +1,6 @@
 #include "ffmpeg_reader.h"
 #include <algorithm>
+#include <cstring>
 #include <iostream>
 
 static SwsContext* create_sws_rgba(const AVCodecContext* vCtx) {
@@ -37,11 +38,16 @@ static bool frame_to_rgba(AVFrame* src,
     out.height  = h;
     out.pts_sec = pts_sec;
 
-    std::vector<uint8_t> buf(w*h*4);
+    // rows padded to 64 bytes so sws_scale keeps its aligned SIMD path; the texture
+    // upload reads this stride directly (GL_UNPACK_ROW_LENGTH), no repack to w*4
+    const int linesize = (w * 4 + 63) & ~63;
+    out.linesize = linesize;
+
+    std::vector<uint8_t> buf(size_t(linesize) * h);
     out.pixels = std::make_shared<std::vector<uint8_t>>();
 
     uint8_t* dstData[4]     = { buf.data(), nullptr, nullptr, nullptr };
-    int      dstLinesize[4] = { w * 4, 0, 0, 0 };
+    int      dstLinesize[4] = { linesize, 0, 0, 0 };
 
     int ret = sws_scale(
         sws_rgba,
@@ -59,6 +65,20 @@ static bool frame_to_rgba(AVFrame* src,
 }
 
 // last frame with pts <= t_sec
+// w*4 rows for consumers that take a plain image (thumbnails)
+static std::vector<uint8_t> tight_rgba(const VideoFrameRGBA& f)
+{
+    const size_t row = size_t(f.width) * 4;
+    if (!f.pixels) return std::vector<uint8_t>();
+    if (f.linesize <= 0 || size_t(f.linesize) == row) return *f.pixels;
+
+    std::vector<uint8_t> out(row * f.height);
+    for (int y = 0; y < f.height; ++y) {
+        std::memcpy(out.data() + y * row, f.pixels->data() + size_t(y) * f.linesize, row);
+    }
+    return out;
+}
+
 static const VideoFrameRGBA* find_frame_for_time(
     const std::vector<VideoFrameRGBA>& frames,
     double t_sec)
@@ -333,7 +353,7 @@ void FFMpegReader::decode_chunk() {
         chunk.t0_sec  = t0;
         chunk.len_sec = chunk_len_;
         if (t0 == start_req_sec) {
-            thumnail_callback->onFFMpegReaderThumbnail("decode 1st load", *outFrame.at(0).pixels);
+            thumnail_callback->onFFMpegReaderThumbnail("decode 1st load", tight_rgba(outFrame.at(0)));
         }
 
         chunk.video   = std::move(outFrame);
@@ -413,7 +433,8 @@ bool FFMpegReader::media_pre_load_chunk(double start_sec) {
 
     AVChunk out;
     if (peek_chunk(0, out)) {
-        std::vector<uint8_t> thumbnail_frame = std::move(*out.video.at(0).pixels);
+        // a copy: the frame is still shared with the queued chunk
+        std::vector<uint8_t> thumbnail_frame = tight_rgba(out.video.at(0));
         thumnail_callback->onFFMpegReaderThumbnail("pre load", thumbnail_frame);
         return true;
     } else {
@@ -547,7 +568,9 @@ void FFMpegReader::play_loop(const double& start_sec, const int& fps, const Play
     snd_pcm_prepare(g_pcm);
 
     // const double frameInterval = (fps > 0) ? (1.0 / fps) : (1.0 / 30.0);
-    const double lead_sec = 0.006;   // show slightly early
+    // hand frames over early; the GL side holds each one until the vsync nearest its pts.
+    // Under half a frame so a due frame is not replaced before it is shown
+    const double lead_sec = (fps > 0) ? std::min(0.020, 0.5 / fps) : 0.006;
     const int prefetch = 2;
 
     bool have_audio_base = false;
@@ -650,7 +673,7 @@ void FFMpegReader::play_loop(const double& start_sec, const int& fps, const Play
                     // force flush remaining video frames
                     while (vid_i < ck.video.size()) {
                         const auto& f = ck.video[vid_i++];
-                        if (f.pixels) frame_callback(f.width, f.height, f.pixels, 4, played_sec, false);
+                        if (f.pixels) frame_callback(f.width, f.height, f.pixels, f.linesize, 4, played_sec, f.pts_sec, false);
                     }
                     break;
                 }
@@ -671,7 +694,7 @@ void FFMpegReader::play_loop(const double& start_sec, const int& fps, const Play
             }
             if (last && last->pixels &&
                 (last_presented_pts < 0.0 || std::fabs(last->pts_sec - last_presented_pts) > 1e-6) && g_playing.load(std::memory_order_acquire)) {
-                frame_callback(last->width, last->height, last->pixels, 4, played_sec, false);
+                frame_callback(last->width, last->height, last->pixels, last->linesize, 4, played_sec, last->pts_sec, false);
                 last_presented_pts = last->pts_sec;
             }
             if (!g_playing.load(std::memory_order_acquire)) break;
@@ -751,7 +774,7 @@ void FFMpegReader::play_loop(const double& start_sec, const int& fps, const Play
         snd_pcm_drain(g_pcm);
     }
 
-    frame_callback(0, 0, {}, 0, 0.0, true);
+    frame_callback(0, 0, {}, 0, 0, 0.0, 0.0, true);
 }
 
 bool FFMpegReader::pop_chunk(AVChunk& out) {
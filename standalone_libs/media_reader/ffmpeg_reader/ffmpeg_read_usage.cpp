@@ -24,6 +24,7 @@ static bool frame_to_rgba(AVFrame* src,
     out.height  = h;
     out.pts_sec = pts_sec;
     out.pixels->resize(w * h * 4);
+    out.linesize = w * 4;
 
     uint8_t* dstData[4]     = { out.pixels->data(), nullptr, nullptr, nullptr };
     int      dstLinesize[4] = { w * 4, 0, 0, 0 };
@@ -27,6 +27,7 @@ struct VideoFrameRGBA {
     double pts_sec = 0.0;              // absolute timestamp in seconds
     //std::vector<uint8_t> pixels;       // size = width * height * 4 (RGBA)
     std::shared_ptr<std::vector<uint8_t>> pixels; // shared <-- shared
+    int linesize = 0;                  // bytes per row in pixels, >= width * 4 (0 = tight)
 };
 
 struct AudioBufferU8 {
@@ -53,7 +54,10 @@ typedef std::function<void(const int& w,
                            const int& h,
                            // const std::vector<uint8_t>& pixels,
                            std::shared_ptr<const std::vector<uint8_t>> pixels,
-                           const int& channel, const double& play_sec, bool done)> PlayerCallback;
+                           // bytes per row, rows may be padded past w * 4
+                           const int& linesize,
+                           // play_sec: audio clock when the frame is handed over, pts_sec: when it is due
+                           const int& channel, const double& play_sec, const double& pts_sec, bool done)> PlayerCallback;
 
 typedef std::function<void(const double& start_sec, const std::string& message)> DecodedCallback;
 